@@ -84,6 +84,10 @@ static void announce_and_cleanup(int fake)
 #ifdef CONFIG_BOOTSTAGE_REPORT
 	bootstage_report();
 #endif
+#ifdef CONFIG_BOOTSTAGE_STASH
+	bootstage_stash((void *)CONFIG_BOOTSTAGE_STASH_ADDR,
+			CONFIG_BOOTSTAGE_STASH_SIZE);
+#endif
 
 #ifdef CONFIG_USB_DEVICE
 	udc_disconnect();
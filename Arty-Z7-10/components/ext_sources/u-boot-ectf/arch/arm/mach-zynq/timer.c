@@ -42,6 +42,16 @@ struct scu_timer {
 static struct scu_timer *timer_base =
 			      (struct scu_timer *)ZYNQ_SCUTIMER_BASEADDR;
 
+struct gtc_timer {
+	u32 counter_lo; /* Global Timer Counter Register 0 */
+	u32 counter_hi; /* Global Timer Counter Register 1 */
+	u32 control; /* Global Timer Control Register */
+};
+
+static struct gtc_timer *gtc_base = (struct gtc_timer *)ZYNQ_GTC_BASEADDR;
+
+#define GTC_CONTROL_ENABLE_MASK			0x00000001 /* Timer enable */
+
 #define SCUTIMER_CONTROL_PRESCALER_MASK	0x0000FF00 /* Prescaler */
 #define SCUTIMER_CONTROL_PRESCALER_SHIFT	8
 #define SCUTIMER_CONTROL_AUTO_RELOAD_MASK	0x00000002 /* Auto-reload */
@@ -85,3 +95,30 @@ ulong get_tbclk(void)
 {
 	return gd->arch.timer_rate_hz;
 }
+
+#ifdef CONFIG_BOOTSTAGE
+/*
+ * The 64-bit global timer is started by ps7_init() in the FSBL and is not
+ * touched by U-Boot, so bootstage marks taken from it are relative to the
+ * FSBL rather than to U-Boot's own timer_init().
+ */
+ulong timer_get_boot_us(void)
+{
+	u32 hi, lo;
+
+	/* CPU clock is not known until arch_cpu_init() */
+	if (!gd->cpu_clk)
+		return 0;
+
+	if (!(readl(&gtc_base->control) & GTC_CONTROL_ENABLE_MASK))
+		setbits_le32(&gtc_base->control, GTC_CONTROL_ENABLE_MASK);
+
+	do {
+		hi = readl(&gtc_base->counter_hi);
+		lo = readl(&gtc_base->counter_lo);
+	} while (hi != readl(&gtc_base->counter_hi));
+
+	/* The global timer is clocked at CPU_3x2x, half the CPU clock */
+	return lldiv(((u64)hi << 32) | lo, gd->cpu_clk / 2 / 1000000);
+}
+#endif
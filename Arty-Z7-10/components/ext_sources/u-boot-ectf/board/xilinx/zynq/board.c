@@ -7,6 +7,7 @@
 #include <common.h>
 #include <fdtdec.h>
 #include <fpga.h>
+#include <mesh.h>
 #include <mmc.h>
 #include <spi.h>
 #include <spi_flash.h>
@@ -116,6 +117,13 @@ int board_late_init(void)
 	return 0;
 }
 
+#ifdef CONFIG_OF_BOARD_SETUP
+int ft_board_setup(void *blob, bd_t *bd)
+{
+	return mesh_fdt_fixup(blob);
+}
+#endif
+
 #ifdef CONFIG_DISPLAY_BOARDINFO
 int checkboard(void)
 {
@@ -0,0 +1,213 @@
+/*
+ * Read benchmark of block devices
+ *
+ * Each read is timed on its own with the bench statistics, so that the
+ * spread of latencies shows as well as the throughput. The region, sizes
+ * and random offsets are the same on every run, so that transfer modes,
+ * MMC command choices and block cache settings can be compared line by
+ * line.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <bench.h>
+#include <blk.h>
+#include <command.h>
+#include <console.h>
+#include <errno.h>
+#include <malloc.h>
+#include <part.h>
+#include <linux/sizes.h>
+
+#define BLK_BENCH_DEF_REPS	64
+#define BLK_BENCH_MAX_BYTES	SZ_8M
+#define BLK_BENCH_MAX_ROWS	32
+#define BLK_BENCH_SEED		0x2545f491
+
+int blk_bench_parse(struct blk_bench *bb, int argc, char * const argv[])
+{
+	char *endp;
+
+	memset(bb, '\0', sizeof(*bb));
+	bb->reps = BLK_BENCH_DEF_REPS;
+	if (argc && !strcmp(argv[0], "-u")) {
+		bb->uncached = true;
+		argc--;
+		argv++;
+	}
+	if (argc < 2 || argc > 3)
+		return -EINVAL;
+
+	bb->start = simple_strtoul(argv[0], &endp, 16);
+	if (*argv[0] == 0 || *endp != 0)
+		return -EINVAL;
+	bb->count = simple_strtoul(argv[1], &endp, 16);
+	if (*argv[1] == 0 || *endp != 0 || !bb->count)
+		return -EINVAL;
+	if (argc > 2)
+		bb->reps = simple_strtoul(argv[2], NULL, 10);
+
+	return bb->reps ? 0 : -EINVAL;
+}
+
+/* Add a size to time to a sorted list, unless it is there already */
+static int blk_bench_add_size(lbaint_t *sizes, int count, lbaint_t size)
+{
+	int i;
+
+	for (i = 0; i < count && sizes[i] < size; i++)
+		;
+	if ((i < count && sizes[i] == size) || count == BLK_BENCH_MAX_ROWS)
+		return count;
+	memmove(&sizes[i + 1], &sizes[i], (count - i) * sizeof(*sizes));
+	sizes[i] = size;
+
+	return count + 1;
+}
+
+/* Sizes to time: powers of two, with b_max and one block beyond it */
+static int blk_bench_sizes(struct blk_bench *bb, lbaint_t max,
+			   lbaint_t *sizes)
+{
+	lbaint_t size;
+	int count = 0;
+
+	for (size = 1; size <= max; size <<= 1)
+		count = blk_bench_add_size(sizes, count, size);
+	if (bb->b_max && bb->b_max <= max)
+		count = blk_bench_add_size(sizes, count, bb->b_max);
+	if (bb->b_max && bb->b_max + 1 <= max)
+		count = blk_bench_add_size(sizes, count, bb->b_max + 1);
+
+	return count;
+}
+
+/* Time @bb->reps reads of @size blocks, or enough to read the region once */
+static int blk_bench_row(struct blk_bench *bb, lbaint_t size, bool random,
+			 void *buf, struct bench_stats *st)
+{
+	struct blk_desc *desc = bb->desc;
+	ulong slots = bb->count / size;
+	u32 seed = BLK_BENCH_SEED;
+	lbaint_t blk;
+	ulong start, n;
+	uint i, reps;
+
+	reps = min_t(ulong, bb->reps, slots);
+	for (i = 0; i < reps; i++) {
+		if (random) {
+			seed = seed * 1103515245 + 12345;
+			blk = bb->start + (lbaint_t)((seed >> 8) % slots) * size;
+		} else {
+			blk = bb->start + (lbaint_t)(i % slots) * size;
+		}
+
+		start = timer_get_us();
+		n = blk_dread(desc, blk, size, buf);
+		bench_add(st, timer_get_us() - start, size * desc->blksz);
+		if (n != size) {
+			printf("read FAILED: " LBAFU " blocks at 0x" LBAF "\n",
+			       size, blk);
+			return -EIO;
+		}
+	}
+
+	return 0;
+}
+
+int blk_bench(struct blk_bench *bb)
+{
+	static const char * const patterns[] = { "seq", "rand" };
+	struct blk_desc *desc = bb->desc;
+	lbaint_t sizes[BLK_BENCH_MAX_ROWS], max;
+#ifdef CONFIG_BLOCK_CACHE
+	struct block_cache_stats cache;
+#endif
+	struct bench_stats st;
+	int i, p, count, ret = 0;
+	void *buf;
+
+	if (bb->start + bb->count > desc->lba) {
+		printf("Region ends at block 0x" LBAF ", past the end at 0x"
+		       LBAF "\n", bb->start + bb->count, desc->lba);
+		return -EINVAL;
+	}
+	max = min_t(lbaint_t, bb->count, BLK_BENCH_MAX_BYTES / desc->blksz);
+	buf = memalign(ARCH_DMA_MINALIGN, max * desc->blksz);
+	if (!buf) {
+		printf("Cannot allocate memory\n");
+		return -ENOMEM;
+	}
+	count = blk_bench_sizes(bb, max, sizes);
+
+#ifdef CONFIG_BLOCK_CACHE
+	blkcache_stats(&cache);
+	if (bb->uncached)
+		blkcache_configure(0, 0);
+#endif
+	printf("Read bench: 0x" LBAF " blocks of %lu bytes at 0x" LBAF
+	       ", %u reps%s\n", bb->count, desc->blksz, bb->start, bb->reps,
+	       bb->uncached ? ", uncached" : "");
+	bench_print_header();
+
+	for (p = 0; p < ARRAY_SIZE(patterns) && !ret; p++) {
+		for (i = 0; i < count && !ret; i++) {
+			bench_init(&st);
+			if (bb->row_start)
+				bb->row_start(bb);
+			ret = blk_bench_row(bb, sizes[i], p, buf, &st);
+			bench_print(patterns[p], sizes[i] * desc->blksz, 0, &st);
+			if (bb->row_end)
+				bb->row_end(bb);
+			if (ctrlc())
+				ret = -EINTR;
+		}
+	}
+
+#ifdef CONFIG_BLOCK_CACHE
+	if (bb->uncached)
+		blkcache_configure(cache.max_blocks_per_entry,
+				   cache.max_entries);
+#endif
+	free(buf);
+
+	return ret;
+}
+
+static int do_blk_bench(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	struct blk_bench bb;
+	struct blk_desc *desc;
+	bool uncached;
+
+	if (argc < 2 || strcmp(argv[1], "bench"))
+		return CMD_RET_USAGE;
+	argc -= 2;
+	argv += 2;
+	uncached = argc && !strcmp(argv[0], "-u");
+	if (uncached) {
+		argc--;
+		argv++;
+	}
+	if (argc < 4)
+		return CMD_RET_USAGE;
+
+	if (blk_get_device_by_str(argv[0], argv[1], &desc) < 0)
+		return CMD_RET_FAILURE;
+	if (blk_bench_parse(&bb, argc - 2, argv + 2))
+		return CMD_RET_USAGE;
+	bb.desc = desc;
+	bb.uncached |= uncached;
+
+	return blk_bench(&bb) ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	blk, 8, 0, do_blk_bench,
+	"block device commands",
+	"bench [-u] interface dev[.hwpart] start count [reps]\n"
+	"    - time reads of 1 block and up from `count' blocks at `start',\n"
+	"      sequentially and at random; -u bypasses the block cache"
+);
@@ -15,6 +15,7 @@
 #include <errno.h>
 #include <image.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <nand.h>
 #include <asm/byteorder.h>
 #include <linux/ctype.h>
@@ -242,7 +243,7 @@ static int do_iminfo(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 static int image_info(ulong addr)
 {
-	void *hdr = (void *)addr;
+	void *hdr = map_sysmem(addr, 0);
 
 	printf("\n## Checking Image at %08lx ...\n", addr);
 
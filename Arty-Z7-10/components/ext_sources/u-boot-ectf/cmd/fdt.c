@@ -15,6 +15,7 @@
 #include <asm/global_data.h>
 #include <libfdt.h>
 #include <fdt_support.h>
+#include <fdtdec.h>
 #include <mapmem.h>
 #include <asm/io.h>
 
@@ -79,7 +80,8 @@ static int fdt_value_setenv(const void *nodep, int len, const char *var)
 /*
  * Flattened Device Tree command, see the help for parameter definitions.
  */
-static int do_fdt(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+static int fdt_subcmd(cmd_tbl_t *cmdtp, int flag, int argc,
+		      char * const argv[])
 {
 	if (argc < 2)
 		return CMD_RET_USAGE;
@@ -679,6 +681,19 @@ static int do_fdt(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	return 0;
 }
 
+static int do_fdt(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	int ret;
+
+	ret = fdt_subcmd(cmdtp, flag, argc, argv);
+#if CONFIG_IS_ENABLED(OF_INDEX)
+	/* Any subcommand may have written to the control FDT */
+	fdtdec_index_changed(working_fdt);
+#endif
+
+	return ret;
+}
+
 /****************************************************************************/
 
 /**
@@ -0,0 +1,194 @@
+/*
+ * Check and benchmark memcpy, memmove and memset
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <console.h>
+#include <div64.h>
+#include <mapmem.h>
+#include <linux/sizes.h>
+
+#define MEMBENCH_DEF_MAX	SZ_1M
+#define MEMBENCH_BYTES		(16 << 20)	/* Bytes moved per measurement */
+#define MEMBENCH_CHECK_MAX	300		/* Largest length checked */
+
+enum {
+	MEMBENCH_MEMCPY,
+	MEMBENCH_MEMMOVE,
+	MEMBENCH_MEMSET,
+
+	MEMBENCH_COUNT,
+};
+
+static const char *const membench_name[MEMBENCH_COUNT] = {
+	"memcpy", "memmove", "memset",
+};
+
+static void membench_fill(u8 *buf, ulong len, uint seed)
+{
+	ulong i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (u8)(seed + i * 7 + (i >> 8));
+}
+
+/*
+ * Compare one call against a byte loop, on a copy of the same pattern.
+ * @buf holds two areas of @area bytes: the first is worked on, the second
+ * holds the expected result.
+ */
+static int membench_check_one(int op, u8 *buf, ulong area, ulong dst,
+			      ulong src, ulong len)
+{
+	u8 *got = buf, *want = buf + area;
+	ulong i;
+
+	membench_fill(got, area, dst + src + len);
+	membench_fill(want, area, dst + src + len);
+	switch (op) {
+	case MEMBENCH_MEMCPY:
+		memcpy(got + dst, got + src, len);
+		for (i = 0; i < len; i++)
+			want[dst + i] = want[src + i];
+		break;
+	case MEMBENCH_MEMMOVE:
+		memmove(got + dst, got + src, len);
+		if (dst < src) {
+			for (i = 0; i < len; i++)
+				want[dst + i] = want[src + i];
+		} else {
+			for (i = len; i > 0; i--)
+				want[dst + i - 1] = want[src + i - 1];
+		}
+		break;
+	case MEMBENCH_MEMSET:
+		memset(got + dst, 0xa5, len);
+		for (i = 0; i < len; i++)
+			want[dst + i] = 0xa5;
+		break;
+	}
+	if (memcmp(got, want, area)) {
+		printf("%s FAILED: dst %lu, src %lu, len %lu\n",
+		       membench_name[op], dst, src, len);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Check every length up to MEMBENCH_CHECK_MAX at a few alignments, with
+ * memmove also run with the areas overlapping in both directions
+ */
+static int membench_check(u8 *buf)
+{
+	static const ulong offs[] = { 0, 1, 3, 4, 17, 31, 32, 63 };
+	const ulong area = MEMBENCH_CHECK_MAX * 2 + 128;
+	const ulong far = MEMBENCH_CHECK_MAX + 64;
+	ulong len, i, j;
+	int ret = 0;
+
+	for (len = 0; len <= MEMBENCH_CHECK_MAX && !ret; len++) {
+		for (i = 0; i < ARRAY_SIZE(offs) && !ret; i++) {
+			for (j = 0; j < ARRAY_SIZE(offs) && !ret; j++) {
+				ret |= membench_check_one(MEMBENCH_MEMCPY, buf,
+							  area, offs[i],
+							  far + offs[j], len);
+				ret |= membench_check_one(MEMBENCH_MEMMOVE,
+							  buf, area, offs[i],
+							  offs[i] + offs[j],
+							  len);
+				ret |= membench_check_one(MEMBENCH_MEMMOVE,
+							  buf, area,
+							  offs[i] + offs[j],
+							  offs[i], len);
+			}
+			ret |= membench_check_one(MEMBENCH_MEMSET, buf, area,
+						  offs[i], 0, len);
+		}
+	}
+
+	return ret;
+}
+
+/* Return the bandwidth of @op on @size bytes in MB/s */
+static ulong membench_run(int op, u8 *dst, u8 *src, ulong size)
+{
+	ulong reps = max(MEMBENCH_BYTES / size, 1UL);
+	ulong start, elapsed, i;
+
+	start = timer_get_us();
+	for (i = 0; i < reps; i++) {
+		switch (op) {
+		case MEMBENCH_MEMCPY:
+			memcpy(dst, src, size);
+			break;
+		case MEMBENCH_MEMMOVE:
+			memmove(dst, src, size);
+			break;
+		case MEMBENCH_MEMSET:
+			memset(dst, (int)i, size);
+			break;
+		}
+	}
+	elapsed = max(timer_get_us() - start, 1UL);
+
+	return lldiv((u64)reps * size, elapsed);
+}
+
+static int do_membench(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	ulong addr = CONFIG_SYS_LOAD_ADDR, max_size = MEMBENCH_DEF_MAX;
+	ulong size;
+	u8 *buf;
+	int op;
+
+	if (argc > 3)
+		return CMD_RET_USAGE;
+	if (argc > 1)
+		addr = simple_strtoul(argv[1], NULL, 16);
+	if (argc > 2)
+		max_size = simple_strtoul(argv[2], NULL, 16);
+	if (max_size < SZ_1K)	/* membench_check() needs this much */
+		return CMD_RET_USAGE;
+
+	/* Source and destination each get max_size bytes, plus a cache line */
+	buf = map_sysmem(addr, max_size * 2 + 64);
+	if (membench_check(buf)) {
+		unmap_sysmem(buf);
+		return CMD_RET_FAILURE;
+	}
+	printf("memcpy, memmove and memset checked OK\n\n");
+
+	printf("%10s", "Bytes");
+	for (op = 0; op < MEMBENCH_COUNT; op++)
+		printf("%10s", membench_name[op]);
+	printf("  (MB/s)\n");
+	for (size = 16; size <= max_size; size <<= 2) {
+		printf("%10lu", size);
+		for (op = 0; op < MEMBENCH_COUNT; op++) {
+			printf("%10lu", membench_run(op, buf,
+						     buf + max_size + 64,
+						     size));
+		}
+		printf("\n");
+		if (ctrlc())
+			break;
+	}
+	unmap_sysmem(buf);
+
+	return 0;
+}
+
+U_BOOT_CMD(membench, 3, 0, do_membench,
+	"check and benchmark memcpy, memmove and memset",
+	"[<addr> [<max_size>]]\n"
+	"    - check the string functions against byte loops, then time\n"
+	"      them on sizes from 16 bytes to <max_size> (default 1MiB),\n"
+	"      using 2 * <max_size> + 64 bytes of memory at <addr>\n"
+	"      (default CONFIG_SYS_LOAD_ADDR)"
+);
@@ -280,6 +280,9 @@ static int do_mii(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	if (argc < 2)
 		return CMD_RET_USAGE;
 
+	/* The MDIO bus is registered when the MAC is probed */
+	eth_lazy_initialize();
+
 #if defined(CONFIG_MII_INIT)
 	mii_init ();
 #endif
@@ -364,6 +364,92 @@ static int do_mmc_rescan(cmd_tbl_t *cmdtp, int flag,
 
 	return CMD_RET_SUCCESS;
 }
+static int do_mmc_stats(cmd_tbl_t *cmdtp, int flag,
+			int argc, char * const argv[])
+{
+	struct mmc_stats *st;
+	struct mmc *mmc;
+	ulong cmds;
+
+	if (argc == 2 && strcmp(argv[1], "reset"))
+		return CMD_RET_USAGE;
+
+	mmc = init_mmc_device(curr_device, false);
+	if (!mmc)
+		return CMD_RET_FAILURE;
+
+	st = &mmc->stats;
+	if (argc == 2) {
+		memset(st, 0, sizeof(*st));
+		return CMD_RET_SUCCESS;
+	}
+
+	cmds = st->read_cmds + st->set_block_count + st->stop + st->set_blocklen;
+	printf("Reads: %lu of %lu blocks\n", st->reads, st->blocks);
+	printf("Read commands: %lu CMD17/18, %lu CMD23, %lu CMD12\n",
+	       st->read_cmds, st->set_block_count, st->stop);
+	printf("Block length: %lu CMD16, %lu not needed\n", st->set_blocklen,
+	       st->blocklen_cached);
+	if (st->reads)
+		printf("Commands per read: %lu.%02lu\n", cmds / st->reads,
+		       cmds % st->reads * 100 / st->reads);
+	printf("Set block count: %s\n",
+	       mmc->card_caps & MMC_MODE_CMD23 ? "yes" : "no");
+
+	return CMD_RET_SUCCESS;
+}
+#ifdef CONFIG_CMD_BLK_BENCH
+static void mmc_bench_row_start(struct blk_bench *bb)
+{
+	struct mmc *mmc = bb->priv;
+
+	memset(&mmc->stats, 0, sizeof(mmc->stats));
+}
+
+static void mmc_bench_row_end(struct blk_bench *bb)
+{
+	struct mmc *mmc = bb->priv;
+	struct mmc_stats *st = &mmc->stats;
+
+	printf("%10s cmds: %lu CMD17/18, %lu CMD23, %lu CMD12, %lu CMD16\n",
+	       "", st->read_cmds, st->set_block_count, st->stop,
+	       st->set_blocklen);
+}
+
+static int do_mmc_bench(cmd_tbl_t *cmdtp, int flag,
+			int argc, char * const argv[])
+{
+	struct mmc_stats stats;
+	struct blk_bench bb;
+	struct mmc *mmc;
+	int ret;
+
+	if (blk_bench_parse(&bb, argc - 1, argv + 1))
+		return CMD_RET_USAGE;
+
+	mmc = init_mmc_device(curr_device, false);
+	if (!mmc)
+		return CMD_RET_FAILURE;
+
+	bb.desc = mmc_get_blk_desc(mmc);
+	bb.b_max = mmc->cfg->b_max;
+	if (mmc->card_caps & MMC_MODE_CMD23)
+		bb.b_max = min_t(lbaint_t, bb.b_max, 0xffff);
+	bb.row_start = mmc_bench_row_start;
+	bb.row_end = mmc_bench_row_end;
+	bb.priv = mmc;
+	printf("%s: %u-bit bus at %u Hz, %lu blocks a command, CMD23 %s\n",
+	       mmc->cfg->name, mmc->bus_width, mmc->clock, (ulong)bb.b_max,
+	       mmc->card_caps & MMC_MODE_CMD23 ? "yes" : "no");
+
+	/* leave the counts "mmc stats" shows as they were */
+	stats = mmc->stats;
+	ret = blk_bench(&bb);
+	mmc->stats = stats;
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+#endif
 static int do_mmc_part(cmd_tbl_t *cmdtp, int flag,
 		       int argc, char * const argv[])
 {
@@ -760,6 +846,10 @@ static cmd_tbl_t cmd_mmc[] = {
 	U_BOOT_CMD_MKENT(write, 4, 0, do_mmc_write, "", ""),
 	U_BOOT_CMD_MKENT(erase, 3, 0, do_mmc_erase, "", ""),
 	U_BOOT_CMD_MKENT(rescan, 1, 1, do_mmc_rescan, "", ""),
+	U_BOOT_CMD_MKENT(stats, 2, 0, do_mmc_stats, "", ""),
+#ifdef CONFIG_CMD_BLK_BENCH
+	U_BOOT_CMD_MKENT(bench, 5, 0, do_mmc_bench, "", ""),
+#endif
 	U_BOOT_CMD_MKENT(part, 1, 1, do_mmc_part, "", ""),
 	U_BOOT_CMD_MKENT(dev, 3, 0, do_mmc_dev, "", ""),
 	U_BOOT_CMD_MKENT(list, 1, 1, do_mmc_list, "", ""),
@@ -813,6 +903,12 @@ U_BOOT_CMD(
 	"mmc write addr blk# cnt\n"
 	"mmc erase blk# cnt\n"
 	"mmc rescan\n"
+	"mmc stats [reset] - show or reset the command counts of reads\n"
+#ifdef CONFIG_CMD_BLK_BENCH
+	"mmc bench [-u] blk# cnt [reps] - time reads of each size from cnt\n"
+	"    blocks at blk#, with the commands they took; -u bypasses the\n"
+	"    block cache\n"
+#endif
 	"mmc part - lists available partition on current mmc device\n"
 	"mmc dev [dev] [part] - show or set current mmc device [partition]\n"
 	"mmc list - lists available devices\n"
@@ -7,6 +7,8 @@
  */
 
 #include <common.h>
+#include <bench.h>
+#include <console.h>
 #include <div64.h>
 #include <dm.h>
 #include <malloc.h>
@@ -14,6 +16,7 @@
 #include <spi.h>
 #include <spi_flash.h>
 #include <jffs2/jffs2.h>
+#include <linux/sizes.h>
 #include <linux/mtd/mtd.h>
 
 #include <asm/io.h>
@@ -235,6 +238,7 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 				       100 - (end - buf) / scale,
 					bytes_per_second(buf - start_buf,
 							 start_time));
+				console_flush();
 				last_update = get_timer(0);
 			}
 			err_oper = spi_flash_update_block(flash, offset, todo,
@@ -542,6 +546,312 @@ static int do_spi_flash_test(int argc, char * const argv[])
 }
 #endif /* CONFIG_CMD_SF_TEST */
 
+#ifdef CONFIG_CMD_SF_BENCH
+/* Erase opcodes, as in drivers/mtd/spi/sf_internal.h */
+#define SF_BENCH_ERASE_4K	0x20
+#define SF_BENCH_ERASE_64K	0xd8
+
+#define SF_BENCH_DEF_REPS	8
+#define SF_BENCH_MAX_SIZE	SZ_64K
+#define SF_BENCH_UNALIGNED	3	/* offset of the unaligned runs */
+
+static const ulong sf_bench_sizes[] = { 16, 256, SZ_4K, SZ_64K };
+static const ulong sf_bench_aligns[] = { 0, SF_BENCH_UNALIGNED };
+
+/**
+ * struct sf_bench - a benchmark run on a region of the flash
+ *
+ * @start:	first byte of the region, which is overwritten
+ * @len:	bytes in the region, a multiple of the largest erase block
+ * @next:	erased flash in the region not yet programmed
+ * @reps:	times each operation is timed
+ * @buf:	data to write
+ * @vbuf:	data read back, to check it
+ * @cmp_buf:	a sector, for sf_bench_update()
+ */
+struct sf_bench {
+	u32 start;
+	u32 len;
+	u32 next;
+	uint reps;
+	u8 *buf;
+	u8 *vbuf;
+	char *cmp_buf;
+};
+
+static void sf_bench_fill(u8 *buf, ulong len, uint seed)
+{
+	ulong i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (u8)(seed + i * 7 + (i >> 8));
+}
+
+/* Read back what was just written, and check it */
+static int sf_bench_verify(struct sf_bench *sb, const char *name, u32 offset,
+			   ulong size)
+{
+	if (spi_flash_read(flash, offset, size, sb->vbuf) ||
+	    memcmp(sb->buf, sb->vbuf, size)) {
+		printf("%s FAILED: %lu bytes at %#x\n", name, size, offset);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Erase the whole region, untimed, ready to program it */
+static int sf_bench_erase_all(struct sf_bench *sb)
+{
+	sb->next = sb->start;
+	if (spi_flash_erase(flash, sb->start, sb->len)) {
+		printf("Erase of %#x bytes at %#x failed\n", sb->len, sb->start);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int sf_bench_read(struct sf_bench *sb, ulong size, ulong align,
+			 struct bench_stats *st)
+{
+	ulong start;
+	uint i;
+
+	for (i = 0; i < sb->reps; i++) {
+		start = timer_get_us();
+		if (spi_flash_read(flash, sb->start + align, size, sb->vbuf)) {
+			printf("read FAILED: %lu bytes at %#lx\n", size,
+			       sb->start + align);
+			return -1;
+		}
+		bench_add(st, timer_get_us() - start, size);
+	}
+
+	return 0;
+}
+
+/* Program erased flash, erasing the region again when it runs out */
+static int sf_bench_program(struct sf_bench *sb, ulong size, ulong align,
+			    struct bench_stats *st)
+{
+	ulong start;
+	u32 offset;
+	uint i;
+
+	for (i = 0; i < sb->reps; i++) {
+		if (sb->next + align + size > sb->start + sb->len &&
+		    sf_bench_erase_all(sb))
+			return -1;
+		offset = sb->next + align;
+		sf_bench_fill(sb->buf, size, i + size);
+
+		start = timer_get_us();
+		if (spi_flash_write(flash, offset, size, sb->buf)) {
+			printf("program FAILED: %lu bytes at %#x\n", size,
+			       offset);
+			return -1;
+		}
+		bench_add(st, timer_get_us() - start, size);
+
+		if (sf_bench_verify(sb, "program", offset, size))
+			return -1;
+		sb->next = roundup(offset + size, flash->page_size);
+	}
+
+	return 0;
+}
+
+/* Erase blocks of @size bytes with @cmd, each holding a programmed page */
+static int sf_bench_erase(struct sf_bench *sb, u8 cmd, ulong size,
+			  struct bench_stats *st)
+{
+	u8 erase_cmd = flash->erase_cmd;
+	u32 erase_size = flash->erase_size;
+	ulong start;
+	u32 offset;
+	uint i;
+	int ret = 0;
+
+	flash->erase_cmd = cmd;
+	flash->erase_size = size;
+	for (i = 0; i < sb->reps && !ret; i++) {
+		offset = sb->start + i * size % sb->len;
+		sf_bench_fill(sb->buf, flash->page_size, i);
+		if (spi_flash_write(flash, offset, flash->page_size, sb->buf)) {
+			printf("program FAILED: %u bytes at %#x\n",
+			       flash->page_size, offset);
+			ret = -1;
+			break;
+		}
+
+		start = timer_get_us();
+		ret = spi_flash_erase(flash, offset, size);
+		bench_add(st, timer_get_us() - start, size);
+		if (ret)
+			printf("erase FAILED: %lu bytes at %#x\n", size, offset);
+	}
+	flash->erase_cmd = erase_cmd;
+	flash->erase_size = erase_size;
+	sb->next = sb->start + sb->len;
+
+	return ret;
+}
+
+/* Time spi_flash_update() without its progress output */
+static int sf_bench_update(struct sf_bench *sb, ulong size,
+			   struct bench_stats *st)
+{
+	const char *err = NULL;
+	size_t skipped = 0;
+	ulong start, done, todo;
+	u32 offset;
+	uint i;
+
+	for (i = 0; i < sb->reps; i++) {
+		offset = sb->start +
+			i * roundup(size, flash->sector_size) % sb->len;
+		/* new data every time, so that nothing is skipped */
+		sf_bench_fill(sb->buf, size, i + size + 1);
+
+		start = timer_get_us();
+		for (done = 0; done < size && !err; done += todo) {
+			todo = min_t(ulong, size - done, flash->sector_size);
+			err = spi_flash_update_block(flash, offset + done, todo,
+						     (char *)sb->buf + done,
+						     sb->cmp_buf, &skipped);
+		}
+		bench_add(st, timer_get_us() - start, size);
+
+		if (err) {
+			printf("update FAILED in %s: %lu bytes at %#x\n", err,
+			       size, offset);
+			return -1;
+		}
+		if (sf_bench_verify(sb, "update", offset, size))
+			return -1;
+	}
+	sb->next = sb->start + sb->len;
+
+	return 0;
+}
+
+/*
+ * Time each operation on each size that fits in the region, aligned and not
+ * aligned where the flash allows it. The rows are the same on every flash,
+ * with "not run" for an erase size it does not have, so that two runs can
+ * be compared line by line.
+ */
+static int spi_flash_bench(struct sf_bench *sb)
+{
+	ulong block_4k = SZ_4K << flash->shift;
+	ulong block_64k = SZ_64K << flash->shift;
+	struct bench_stats st;
+	ulong size, align;
+	int i, j, ret = 0;
+
+	printf("SPI flash bench: %#x bytes at %#x, %u reps\n", sb->len,
+	       sb->start, sb->reps);
+	bench_print_header();
+
+	for (i = 0; i < ARRAY_SIZE(sf_bench_sizes) && !ret; i++) {
+		size = sf_bench_sizes[i];
+		for (j = 0; j < ARRAY_SIZE(sf_bench_aligns) && !ret; j++) {
+			align = sf_bench_aligns[j];
+			bench_init(&st);
+			if (align + size <= sb->len)
+				ret = sf_bench_read(sb, size, align, &st);
+			bench_print("read", size, align, &st);
+		}
+	}
+
+	ret = ret ? ret : sf_bench_erase_all(sb);
+	for (i = 0; i < ARRAY_SIZE(sf_bench_sizes) && !ret; i++) {
+		size = sf_bench_sizes[i];
+		for (j = 0; j < ARRAY_SIZE(sf_bench_aligns) && !ret; j++) {
+			align = sf_bench_aligns[j];
+			bench_init(&st);
+			if (align + size <= sb->len)
+				ret = sf_bench_program(sb, size, align, &st);
+			bench_print("program", size, align, &st);
+		}
+		if (ctrlc())
+			ret = -EINTR;
+	}
+
+	if (!ret) {
+		bench_init(&st);
+		if (flash->erase_cmd == SF_BENCH_ERASE_4K)
+			ret = sf_bench_erase(sb, SF_BENCH_ERASE_4K, block_4k,
+					     &st);
+		bench_print("erase4k", block_4k, 0, &st);
+	}
+	if (!ret) {
+		bench_init(&st);
+		ret = sf_bench_erase(sb, SF_BENCH_ERASE_64K, block_64k, &st);
+		bench_print("erase64k", block_64k, 0, &st);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(sf_bench_sizes) && !ret; i++) {
+		size = sf_bench_sizes[i];
+		if (size < SZ_4K)
+			continue;
+		bench_init(&st);
+		ret = sf_bench_update(sb, size, &st);
+		bench_print("update", size, 0, &st);
+		if (ctrlc())
+			ret = -EINTR;
+	}
+
+	return ret;
+}
+
+static int do_spi_flash_bench(int argc, char * const argv[])
+{
+	ulong block = SZ_64K << flash->shift;
+	struct sf_bench sb;
+	char *endp;
+	int ret;
+
+	if (argc < 3 || argc > 4)
+		return -1;
+	memset(&sb, '\0', sizeof(sb));
+	sb.start = simple_strtoul(argv[1], &endp, 16);
+	if (*argv[1] == 0 || *endp != 0)
+		return -1;
+	sb.len = simple_strtoul(argv[2], &endp, 16);
+	if (*argv[2] == 0 || *endp != 0)
+		return -1;
+	sb.reps = SF_BENCH_DEF_REPS;
+	if (argc > 3)
+		sb.reps = simple_strtoul(argv[3], NULL, 10);
+	if (!sb.reps)
+		return -1;
+
+	if (!sb.len || sb.start % block || sb.len % block ||
+	    sb.start + sb.len > flash->size) {
+		printf("Region must be whole %#lx byte blocks within the flash\n",
+		       block);
+		return 1;
+	}
+
+	sb.buf = memalign(ARCH_DMA_MINALIGN, SF_BENCH_MAX_SIZE);
+	sb.vbuf = memalign(ARCH_DMA_MINALIGN, SF_BENCH_MAX_SIZE);
+	sb.cmp_buf = memalign(ARCH_DMA_MINALIGN, flash->sector_size);
+	if (!sb.buf || !sb.vbuf || !sb.cmp_buf) {
+		printf("Cannot allocate memory\n");
+		ret = -ENOMEM;
+	} else {
+		ret = spi_flash_bench(&sb);
+	}
+	free(sb.cmp_buf);
+	free(sb.vbuf);
+	free(sb.buf);
+
+	return ret ? 1 : 0;
+}
+#endif /* CONFIG_CMD_SF_BENCH */
+
 static int do_spi_flash(cmd_tbl_t *cmdtp, int flag, int argc,
 			char * const argv[])
 {
@@ -577,6 +887,10 @@ static int do_spi_flash(cmd_tbl_t *cmdtp, int flag, int argc,
 #ifdef CONFIG_CMD_SF_TEST
 	else if (!strcmp(cmd, "test"))
 		ret = do_spi_flash_test(argc, argv);
+#endif
+#ifdef CONFIG_CMD_SF_BENCH
+	else if (!strcmp(cmd, "bench"))
+		ret = do_spi_flash_bench(argc, argv);
 #endif
 	else
 		ret = -1;
@@ -595,6 +909,14 @@ usage:
 #else
 #define SF_TEST_HELP
 #endif
+#ifdef CONFIG_CMD_SF_BENCH
+#define SF_BENCH_HELP "\nsf bench offset len [reps]	" \
+		"- time reads, programs, erases and updates\n" \
+		"					  of each size, destroying `len'\n" \
+		"					  bytes at `offset'"
+#else
+#define SF_BENCH_HELP
+#endif
 
 U_BOOT_CMD(
 	sf,	5,	1,	do_spi_flash,
@@ -616,4 +938,5 @@ U_BOOT_CMD(
 	"sf protect lock/unlock sector len	- protect/unprotect 'len' bytes starting\n"
 	"					  at address 'sector'\n"
 	SF_TEST_HELP
+	SF_BENCH_HELP
 );
@@ -324,6 +324,12 @@ static int initr_dm(void)
 	gd->dm_root = NULL;
 #ifdef CONFIG_TIMER
 	gd->timer = NULL;
+#endif
+#ifdef CONFIG_OF_INDEX
+	/* Not fatal: lookups fall back to libfdt without the index */
+	ret = fdtdec_index_build(gd->fdt_blob);
+	if (ret)
+		debug("Cannot index device tree: %d\n", ret);
 #endif
 	ret = dm_init_and_scan(false);
 	if (ret)
@@ -650,8 +656,11 @@ static int initr_bbmii(void)
 #ifdef CONFIG_CMD_NET
 static int initr_net(void)
 {
+	/* With NET_LAZY_INIT the first network command probes the devices */
+#ifndef CONFIG_NET_LAZY_INIT
 	puts("Net:   ");
 	eth_initialize();
+#endif
 #if defined(CONFIG_RESET_PHY_R)
 	debug("Reset Ethernet PHY\n");
 	reset_phy();
@@ -440,9 +440,11 @@ static int bootm_load_os(bootm_headers_t *images, unsigned long *load_end,
 
 	load_buf = map_sysmem(load, 0);
 	image_buf = map_sysmem(os.image_start, image_len);
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DECOMP, "decompress");
 	err = bootm_decomp_image(os.comp, load, os.image_start, os.type,
 				 load_buf, image_buf, image_len,
 				 CONFIG_SYS_BOOTM_LEN, load_end);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DECOMP);
 	if (err) {
 		bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
 		return err;
@@ -107,6 +107,10 @@ static int console_setfile(int file, struct stdio_dev * dev)
 	if (dev == NULL)
 		return -1;
 
+	/* Anything buffered for the old stdout goes there */
+	if (file == stdout && stdio_devices[file])
+		console_flush();
+
 	switch (file) {
 	case stdin:
 	case stdout:
@@ -267,6 +271,50 @@ static inline void console_doenv(int file, struct stdio_dev *dev)
 }
 #endif /* defined(CONFIG_CONSOLE_MUX) */
 
+#ifdef CONFIG_CONSOLE_BUFFER
+/*
+ * Output to stdout is gathered here and handed to the devices a line at a
+ * time, rather than a printf() or a character at a time. It is flushed on
+ * a newline, when full, when input is polled for, and when stdout changes.
+ */
+static char console_outbuf[CONFIG_CONSOLE_BUFFER_SIZE + 1];
+static int console_outbuf_len;
+
+void console_flush(void)
+{
+	if (!console_outbuf_len)
+		return;
+
+	console_outbuf[console_outbuf_len] = '\0';
+	console_outbuf_len = 0;
+	console_puts(stdout, console_outbuf);
+}
+
+static void console_outbuf_puts(const char *s)
+{
+	bool newline = false;
+
+	while (*s) {
+		if (*s == '\n')
+			newline = true;
+		console_outbuf[console_outbuf_len++] = *s++;
+		if (console_outbuf_len == CONFIG_CONSOLE_BUFFER_SIZE) {
+			console_flush();
+			newline = false;
+		}
+	}
+	if (newline)
+		console_flush();
+}
+
+static void console_outbuf_putc(const char c)
+{
+	const char s[2] = { c, '\0' };
+
+	console_outbuf_puts(s);
+}
+#endif
+
 /** U-Boot INITIAL CONSOLE-NOT COMPATIBLE FUNCTIONS *************************/
 
 int serial_printf(const char *fmt, ...)
@@ -289,6 +337,7 @@ int serial_printf(const char *fmt, ...)
 
 int fgetc(int file)
 {
+	console_flush();
 	if (file < MAX_FILES) {
 #if defined(CONFIG_CONSOLE_MUX)
 		/*
@@ -321,6 +370,7 @@ int fgetc(int file)
 
 int ftstc(int file)
 {
+	console_flush();
 	if (file < MAX_FILES)
 		return console_tstc(file);
 
@@ -329,14 +379,30 @@ int ftstc(int file)
 
 void fputc(int file, const char c)
 {
-	if (file < MAX_FILES)
-		console_putc(file, c);
+	if (file >= MAX_FILES)
+		return;
+#ifdef CONFIG_CONSOLE_BUFFER
+	if (file == stdout) {
+		console_outbuf_putc(c);
+		return;
+	}
+	console_flush();
+#endif
+	console_putc(file, c);
 }
 
 void fputs(int file, const char *s)
 {
-	if (file < MAX_FILES)
-		console_puts(file, s);
+	if (file >= MAX_FILES)
+		return;
+#ifdef CONFIG_CONSOLE_BUFFER
+	if (file == stdout) {
+		console_outbuf_puts(s);
+		return;
+	}
+	console_flush();
+#endif
+	console_puts(file, s);
 }
 
 int fprintf(int file, const char *fmt, ...)
@@ -1513,11 +1513,16 @@ void fit_conf_print(const void *fit, int noffset, const char *p)
 
 static int fit_image_select(const void *fit, int rd_noffset, int verify)
 {
+	int ret;
+
 	fit_image_print(fit, rd_noffset, "   ");
 
 	if (verify) {
 		puts("   Verifying Hash Integrity ... ");
-		if (!fit_image_verify(fit, rd_noffset)) {
+		bootstage_start(BOOTSTAGE_ID_ACCUM_FIT_VERIFY, "fit_verify");
+		ret = fit_image_verify(fit, rd_noffset);
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_FIT_VERIFY);
+		if (!ret) {
 			puts("Bad Data Hash\n");
 			return -EACCES;
 		}
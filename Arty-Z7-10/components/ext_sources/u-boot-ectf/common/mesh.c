@@ -9,12 +9,16 @@
 #include <spi_flash.h>
 #include <command.h>
 #include <os.h>
+#include <mapmem.h>
+#include <u-boot/crc.h>
+#include <hexdump.h>
+#include <fdt_support.h>
 
 #include <mesh.h>
+#include <mesh_handoff.h>
 #include <mesh_users.h>
 #include <default_games.h>
 
-#define MESH_TOK_BUFSIZE 64
 #define MESH_TOK_DELIM " \t\r\n\a"
 #define MESH_RL_BUFSIZE 1024
 #define MESH_SHUTDOWN -2
@@ -29,6 +33,21 @@
 // declare user global
 User user;
 
+/*
+    Arena the short-lived allocations of mesh commands come from: the input
+    line, its tokens and the small buffers the commands use. Allocating only
+    bumps an offset, and everything a command allocated is freed at once by
+    mesh_arena_reset() after it, rather than a malloc and free per table row
+    or directory entry. Loops free what each pass allocated with
+    mesh_arena_mark() and mesh_arena_release(). Buffers as big as a game or
+    a flash page still come from malloc.
+*/
+static struct {
+    size_t used;
+    size_t peak;
+    char buf[CONFIG_MESH_ARENA_SIZE] __aligned(8);
+} mesh_arena;
+
 /*
     List of builtin commands, followed by their corresponding functions.
  */
@@ -71,11 +90,11 @@ int (*builtin_func[]) (char **) = {
 int mesh_init_table(void)
 {
     /* Initialize the table where games will be installed */
-    char* sentinel = (char*) malloc(sizeof(char) * MESH_SENTINEL_LENGTH);
+    unsigned int sentinel;
     int ret = 1;
 
-    mesh_flash_read(sentinel, MESH_SENTINEL_LOCATION, MESH_SENTINEL_LENGTH);
-    if (*((unsigned int*) sentinel) != MESH_SENTINEL_VALUE)
+    mesh_flash_read(&sentinel, MESH_SENTINEL_LOCATION, MESH_SENTINEL_LENGTH);
+    if (sentinel != MESH_SENTINEL_VALUE)
     {
         unsigned int sentinel_value = MESH_SENTINEL_VALUE;
         mesh_flash_write(&sentinel_value, MESH_SENTINEL_LOCATION, MESH_SENTINEL_LENGTH);
@@ -85,7 +104,6 @@ int mesh_init_table(void)
         mesh_flash_write(&tend, MESH_INSTALL_GAME_OFFSET, sizeof(char));
         ret = 0;
     }
-    free(sentinel);
     return ret;
 }
 
@@ -293,6 +311,7 @@ int mesh_list(char **args)
     struct games_tbl_row row;
     unsigned int offset = MESH_INSTALL_GAME_OFFSET;
 
+    bootstage_start(BOOTSTAGE_ID_ACCUM_MESH_TABLE, "mesh_table_scan");
     // loop through install table untill end of table is found.
     for(mesh_flash_read(&row, offset, sizeof(struct games_tbl_row));
         row.install_flag != MESH_TABLE_END;
@@ -303,20 +322,422 @@ int mesh_list(char **args)
             printf("%s-v%d.%d\n", row.game_name, row.major_version, row.minor_version);
         offset += sizeof(struct games_tbl_row);
     }
+    bootstage_accum(BOOTSTAGE_ID_ACCUM_MESH_TABLE);
+
+    return 0;
+}
+
+/*
+    This function splits the reserved game region into the segments the game
+    is loaded to: everything after the handoff descriptor, except a
+    bootstage stash that may sit inside the region. Returns the number of
+    bytes available across all segments.
+*/
+static u32 mesh_handoff_segments(struct mesh_handoff *desc)
+{
+    u32 start = CONFIG_MESH_GAME_REGION_ADDR + MESH_HANDOFF_SIZE;
+    u32 end = CONFIG_MESH_GAME_REGION_ADDR + CONFIG_MESH_GAME_REGION_SIZE;
+    u32 hole_start = end, hole_end = end;
+    u32 total = 0;
+
+#ifdef CONFIG_BOOTSTAGE_STASH
+    if (CONFIG_BOOTSTAGE_STASH_ADDR < end &&
+        CONFIG_BOOTSTAGE_STASH_ADDR + CONFIG_BOOTSTAGE_STASH_SIZE > start) {
+        hole_start = CONFIG_BOOTSTAGE_STASH_ADDR & ~(MESH_HANDOFF_SIZE - 1);
+        hole_end = ALIGN(CONFIG_BOOTSTAGE_STASH_ADDR +
+                         CONFIG_BOOTSTAGE_STASH_SIZE, MESH_HANDOFF_SIZE);
+    }
+#endif
+
+    desc->num_segments = 0;
+    if (hole_start > start) {
+        desc->segments[0].addr = start;
+        desc->segments[0].len = hole_start - start;
+        desc->num_segments++;
+    }
+    if (hole_end < end) {
+        desc->segments[desc->num_segments].addr = max(hole_end, start);
+        desc->segments[desc->num_segments].len = end - max(hole_end, start);
+        desc->num_segments++;
+    }
+    for (int i = 0; i < desc->num_segments; i++) {
+        total += desc->segments[i].len;
+    }
+
+    return total;
+}
+
+/*
+    This function finds the end of the text header lines at the start of a
+    game and reads the optional compression line after them. Returns 0 on
+    success, -1 if there is no valid header in the len bytes at head.
+*/
+static int mesh_game_parse_header(const char *head, u32 len,
+                                  struct mesh_handoff *desc)
+{
+    const char *p = head, *nl;
+    int lines;
+
+    for (lines = 0; lines < 3; lines++) {
+        nl = memchr(p, '\n', head + len - p);
+        if (!nl) {
+            printf("Game has no header\n");
+            return -1;
+        }
+        p = nl + 1;
+    }
+
+    desc->compression = MESH_HANDOFF_COMP_NONE;
+    nl = memchr(p, '\n', head + len - p);
+    if (nl && !strncmp(p, "compression:", 12)) {
+        p += 12;
+        if (!strncmp(p, "gzip ", 5)) {
+            desc->compression = MESH_HANDOFF_COMP_GZIP;
+            p += 5;
+        } else if (!strncmp(p, "lz4 ", 4)) {
+            desc->compression = MESH_HANDOFF_COMP_LZ4;
+            p += 4;
+        } else {
+            printf("Game has unknown compression\n");
+            return -1;
+        }
+        desc->uncompressed_len = simple_strtoul(p, NULL, 10);
+        p = nl + 1;
+    }
+    desc->header_len = p - head;
+
+    return 0;
+}
+
+#ifdef CONFIG_MESH_GAME_DECOMPRESS
+/*
+    This function decompresses the payload of the game into the first
+    segment, behind a copy of its header lines, so that Linux gets it as if
+    it had not been compressed. Returns 0 on success, 1 if the payload has
+    to be passed on compressed instead, -1 on error.
+*/
+static int mesh_handoff_decompress(loff_t size, struct mesh_handoff *desc)
+{
+    char *seg = map_sysmem(desc->segments[0].addr, desc->segments[0].len);
+    char *out = seg + desc->header_len;
+    u32 room = desc->segments[0].len - desc->header_len;
+    unsigned long out_len = 0;
+    loff_t actually_read;
+    char *buf;
+    int ret;
+
+    switch (desc->compression) {
+#ifdef CONFIG_GZIP
+    case MESH_HANDOFF_COMP_GZIP:
+        break;
+#endif
+#ifdef CONFIG_LZ4
+    case MESH_HANDOFF_COMP_LZ4:
+        break;
+#endif
+    default:
+        return 1;
+    }
+    if (desc->uncompressed_len > room) {
+        return 1;
+    }
+    buf = malloc(size);
+    if (!buf) {
+        return 1;
+    }
+
+    ret = ext4fs_read(buf, 0, size, &actually_read);
+    if (ret < 0 || actually_read != size) {
+        free(buf);
+        return -1;
+    }
+
+    switch (desc->compression) {
+#ifdef CONFIG_GZIP
+    case MESH_HANDOFF_COMP_GZIP:
+        out_len = size - desc->header_len;
+        ret = gunzip(out, room, (unsigned char *)buf + desc->header_len,
+                     &out_len);
+        break;
+#endif
+#ifdef CONFIG_LZ4
+    case MESH_HANDOFF_COMP_LZ4: {
+        size_t n = room;
+
+        ret = ulz4fn(buf + desc->header_len, size - desc->header_len, out,
+                     &n);
+        out_len = n;
+        break;
+    }
+#endif
+    }
+    if (ret || out_len != desc->uncompressed_len) {
+        printf("Game failed to decompress\n");
+        free(buf);
+        return -1;
+    }
+
+    memcpy(seg, buf, desc->header_len);
+    free(buf);
+    desc->payload_crc32 = crc32(0, (unsigned char *)out, out_len);
+    desc->compression = MESH_HANDOFF_COMP_NONE;
+    desc->stream_len = desc->header_len + out_len;
+    desc->segments[0].len = desc->stream_len;
+    desc->num_segments = 1;
 
     return 0;
 }
+#endif
+
+// how far mesh_handoff_crc has got through the game
+struct mesh_handoff_crc {
+    u32 skip;   // header bytes still to skip
+    u32 crc;    // CRC32 of the payload so far
+};
 
 /*
-    This function writes the specified game to ram address 0x1fc00040 and the
-    size of the specified game binary to 0x1fc00000. It then boots the linux
-    kernel from ram address 0x10000000. This allows the linux kernel to read the
-    binary and execute it to play the game..
+    This function checksums each part of the game as it is read, skipping
+    the header, while the next part is still on its way from the card.
+    Returns 0.
+*/
+static int mesh_handoff_crc(void *priv, char *buf, loff_t len)
+{
+    struct mesh_handoff_crc *state = priv;
+    u32 skip = min((u32)len, state->skip);
+
+    state->skip -= skip;
+    state->crc = crc32(state->crc, (unsigned char *)buf + skip, len - skip);
+
+    return 0;
+}
+
+/*
+    This function reads the open game file as it is into the segments of
+    the handoff descriptor, filling them in order, and checksums the
+    payload as it goes. Returns 0 on success, -1 on error.
+*/
+static int mesh_handoff_read(loff_t size, u32 capacity,
+                             struct mesh_handoff *desc)
+{
+    struct mesh_handoff_crc state = { .skip = desc->header_len };
+    loff_t actually_read;
+    u32 pos = 0, len;
+    int i;
+
+    if (size > capacity) {
+        printf("Game is %lld bytes, at most %u fit in the reserved region\n",
+               size, capacity);
+        return -1;
+    }
+    for (i = 0; i < desc->num_segments && pos < size; i++) {
+        len = min((u32)size - pos, desc->segments[i].len);
+        if (ext4fs_read_stream(map_sysmem(desc->segments[i].addr, len), pos,
+                               len, &actually_read, mesh_handoff_crc,
+                               &state) < 0 ||
+            actually_read != len) {
+            return -1;
+        }
+        desc->segments[i].len = len;
+        pos += len;
+    }
+    desc->num_segments = i;
+    desc->stream_len = size;
+    desc->payload_crc32 = state.crc;
+
+    return 0;
+}
+
+/*
+    This function loads the game file into the segments of the handoff
+    descriptor, filling them in order, and fills in the rest of the
+    descriptor. A compressed payload is decompressed here with
+    CONFIG_MESH_GAME_DECOMPRESS, otherwise it is left to the loader in Linux.
+    Returns 0 on success, -1 on error.
+*/
+static int mesh_handoff_load(char *game_name, struct mesh_handoff *desc)
+{
+    char head[MESH_GAME_HEADER_MAX];
+    loff_t size, actually_read;
+    u32 capacity, len;
+    int ret = -1;
+
+    memset(desc, 0, sizeof(*desc));
+    capacity = mesh_handoff_segments(desc);
+
+    if (fs_set_blk_dev("mmc", "0:2", FS_TYPE_EXT) < 0) {
+        return -1;
+    }
+    if (ext4fs_open(game_name, &size) < 0 || size <= 0) {
+        printf("** File not found %s **\n", game_name);
+        goto out;
+    }
+
+    // the header says where the payload starts and how it is stored
+    len = min((u32)size, (u32)sizeof(head));
+    if (ext4fs_read(head, 0, len, &actually_read) < 0 ||
+        actually_read != len ||
+        mesh_game_parse_header(head, len, desc) < 0) {
+        goto out;
+    }
+
+    // decompress here if possible, otherwise load the game as it is
+    ret = 1;
+#ifdef CONFIG_MESH_GAME_DECOMPRESS
+    if (desc->compression != MESH_HANDOFF_COMP_NONE) {
+        ret = mesh_handoff_decompress(size, desc);
+    }
+#endif
+    if (ret > 0) {
+        ret = mesh_handoff_read(size, capacity, desc);
+    }
+    if (ret < 0) {
+        goto out;
+    }
+
+    desc->magic = MESH_HANDOFF_MAGIC;
+    desc->version = MESH_HANDOFF_VERSION;
+    desc->desc_len = sizeof(*desc);
+    desc->payload_offset = desc->header_len;
+    desc->payload_len = desc->stream_len - desc->payload_offset;
+    if (desc->compression == MESH_HANDOFF_COMP_NONE) {
+        desc->uncompressed_len = desc->payload_len;
+    }
+
+    ret = 0;
+
+out:
+    ext4fs_close();
+
+    return ret;
+}
+
+/*
+    This function adds a no-map node called name@start to the device tree's
+    /reserved-memory, creating that node if the tree has none, so that Linux
+    keeps off size bytes at start. A node already there is updated.
+
+    Returns the offset of the node, or a libfdt error.
+*/
+static int mesh_fdt_reserve(void *blob, const char *name, u64 start, u64 size)
+{
+    fdt32_t reg[4];
+    char node_name[32];
+    int parent, node, len = 0, ret;
+
+    parent = fdt_subnode_offset(blob, 0, "reserved-memory");
+    if (parent == -FDT_ERR_NOTFOUND) {
+        // map it 1:1 onto the root's address space
+        parent = fdt_add_subnode(blob, 0, "reserved-memory");
+        if (parent < 0) {
+            return parent;
+        }
+        ret = fdt_setprop_u32(blob, parent, "#address-cells",
+                              fdt_address_cells(blob, 0));
+        if (ret == 0) {
+            ret = fdt_setprop_u32(blob, parent, "#size-cells",
+                                  fdt_size_cells(blob, 0));
+        }
+        if (ret == 0) {
+            ret = fdt_setprop(blob, parent, "ranges", NULL, 0);
+        }
+        if (ret < 0) {
+            return ret;
+        }
+    } else if (parent < 0) {
+        return parent;
+    }
+
+    snprintf(node_name, sizeof(node_name), "%s@%llx", name,
+             (unsigned long long)start);
+    node = fdt_find_or_add_subnode(blob, parent, node_name);
+    if (node < 0) {
+        return node;
+    }
+
+    if (fdt_address_cells(blob, parent) == 2) {
+        reg[len++] = cpu_to_fdt32(start >> 32);
+    }
+    reg[len++] = cpu_to_fdt32(start);
+    if (fdt_size_cells(blob, parent) == 2) {
+        reg[len++] = cpu_to_fdt32(size >> 32);
+    }
+    reg[len++] = cpu_to_fdt32(size);
+
+    ret = fdt_setprop(blob, node, "reg", reg, len * sizeof(*reg));
+    if (ret == 0) {
+        ret = fdt_setprop(blob, node, "no-map", NULL, 0);
+    }
+
+    return ret < 0 ? ret : node;
+}
+
+/*
+    This function reserves the game region from Kconfig in the device tree
+    and points the mesh-game-mem node's memory-region at it. The device tree
+    Linux is built with does not describe the region, so Linux and
+    mesh-game-loader always take it from U-Boot. A bootstage stash outside
+    the region is reserved too, as the loader records its own stages there.
+
+    Returns 0 on success, or a libfdt error if the region could not be
+    reserved.
+*/
+int mesh_fdt_fixup(void *blob)
+{
+    u32 phandle;
+    int node;
+
+#if defined(CONFIG_BOOTSTAGE_STASH) && defined(CONFIG_BOOTSTAGE_STASH_ADDR)
+    if (CONFIG_BOOTSTAGE_STASH_ADDR + CONFIG_BOOTSTAGE_STASH_SIZE <=
+        CONFIG_MESH_GAME_REGION_ADDR ||
+        CONFIG_BOOTSTAGE_STASH_ADDR >=
+        CONFIG_MESH_GAME_REGION_ADDR + CONFIG_MESH_GAME_REGION_SIZE) {
+        node = mesh_fdt_reserve(blob, "bootstage", CONFIG_BOOTSTAGE_STASH_ADDR,
+                                CONFIG_BOOTSTAGE_STASH_SIZE);
+        if (node < 0) {
+            printf("Could not reserve the bootstage stash: %s\n",
+                   fdt_strerror(node));
+        }
+    }
+#endif
+
+    node = mesh_fdt_reserve(blob, "mesh-game", CONFIG_MESH_GAME_REGION_ADDR,
+                            CONFIG_MESH_GAME_REGION_SIZE);
+    if (node < 0) {
+        printf("Could not reserve the mesh game region: %s\n",
+               fdt_strerror(node));
+        return node;
+    }
+    // fdt_create_phandle() says why if it fails
+    phandle = fdt_create_phandle(blob, node);
+    if (phandle == 0) {
+        return -FDT_ERR_NOSPACE;
+    }
+
+    // without the driver, the loader falls back to /dev/mem
+    node = fdt_node_offset_by_compatible(blob, -1, "mitre,mesh-game-mem");
+    if (node < 0) {
+        return 0;
+    }
+
+    return fdt_setprop_u32(blob, node, "memory-region", phandle);
+}
+
+/*
+    This function loads the specified game into the reserved game region
+    and writes a struct mesh_handoff describing it to the start of the
+    region. It then boots the linux kernel from ram address 0x10000000.
+    mesh-game-loader in Linux reads the descriptor to find the game and
+    execute it to play the game.
 
     This function implements the play function in mesh. 
 */
 int mesh_play(char **args)
 {
+    struct mesh_handoff desc;
+    int ret;
+
+    bootstage_mark_name(BOOTSTAGE_ID_MESH_PLAY, "mesh_play");
+
     if (!mesh_play_validate_args(args)){
         return 0;
     }
@@ -329,26 +750,17 @@ int mesh_play(char **args)
         return 0;
     }
 
-    loff_t size = 0;
-
-    // get size of binary
-    size = mesh_size_ext4(args[1]);
-
-    // write game size to memory
-    char *size_str = (char *)malloc(sizeof(int));
-    sprintf(size_str, "0x%x", (int) size);
-    char * const mw_argv[3] = { "mw.l", "0x1fc00000", size_str };
-    cmd_tbl_t* mem_write_tp = find_cmd("mw.l");
-    mem_write_tp->cmd(mem_write_tp, 0, 3, mw_argv);
-
-    // load game binary into memory
-    char * const argv[5] = { "ext4load", "mmc", "0:2", "0x1fc00040", args[1] };
-    cmd_tbl_t* load_tp = find_cmd("ext4load");
-
-    load_tp->cmd(load_tp, 0, 5, argv);
-
-    // cleanup - this is here because boot may not execute following commands
-    free(size_str);
+    // load game binary into memory and describe it for linux
+    bootstage_start(BOOTSTAGE_ID_ACCUM_MESH_LOAD, "mesh_game_load");
+    ret = mesh_handoff_load(args[1], &desc);
+    bootstage_accum(BOOTSTAGE_ID_ACCUM_MESH_LOAD);
+    if (ret) {
+        printf("Error loading game %s\n", args[1]);
+        return 0;
+    }
+    memcpy(map_sysmem(CONFIG_MESH_GAME_REGION_ADDR, sizeof(desc)), &desc,
+           sizeof(desc));
+    bootstage_mark_name(BOOTSTAGE_ID_MESH_GAME_LOADED, "mesh_game_loaded");
 
     // boot petalinux
     char * const boot_argv[2] = { "bootm", "0x10000000"};
@@ -469,13 +881,17 @@ int mesh_uninstall(char **args)
     struct games_tbl_row row;
     unsigned int offset = MESH_INSTALL_GAME_OFFSET;
 
+    size_t mark = mesh_arena_mark();
+
     printf("Uninstalling %s for %s...\n", args[1], user.name);
     for(mesh_flash_read(&row, offset, sizeof(struct games_tbl_row));
         row.install_flag != MESH_TABLE_END;
         mesh_flash_read(&row, offset, sizeof(struct games_tbl_row)))
     {
         // the most space that we could need to store the full game name
-        char* full_name = (char*) malloc(snprintf(NULL, 0, "%s-v%d.%d", row.game_name, row.major_version, row.minor_version) + 1);
+        char* full_name = (char*) mesh_arena_alloc(snprintf(NULL, 0, "%s-v%d.%d", row.game_name, row.major_version, row.minor_version) + 1);
+        if (!full_name)
+            break;
         full_name_from_short_name(full_name, &row);
 
         if (strcmp(row.user_name, user.name) == 0 &&
@@ -485,12 +901,12 @@ int mesh_uninstall(char **args)
             row.install_flag = MESH_TABLE_UNINSTALLED;
             mesh_flash_write(&row, offset, sizeof(struct games_tbl_row));
             printf("%s was successfully uninstalled for %s\n", args[1], user.name);
-            free(full_name);
             break;
         }
-        free(full_name);
+        mesh_arena_release(mark);
         offset += sizeof(struct games_tbl_row);
     }
+    mesh_arena_release(mark);
 
     return 0;
 }
@@ -499,36 +915,51 @@ int mesh_uninstall(char **args)
 /* 
     This is a development utility that allows you to easily dump flash
     memory to std out.
+
+    Flash is read MESH_DUMP_CHUNK bytes at a time and streamed through the
+    hex dump engine, so any size can be dumped without holding it all in
+    memory. With "b64" the dump is base64 with a length and CRC32 trailer,
+    for capturing on the host. Ctrl-C stops it.
 */
 int mesh_dump_flash(char **args)
 {
     int argv = mesh_get_argv(args);
-    if (argv < 3){
-        printf("Not enough arguments specified.\nUsage: dump offset size\n");
+    if (argv < 3 || (argv > 3 && strcmp(args[3], "b64") != 0)){
+        printf("Not enough arguments specified.\nUsage: dump offset size [b64]\n");
         return 0;
     }
     unsigned int size = simple_strtoul(args[2], NULL, 16);
     unsigned int offset = simple_strtoul(args[1], NULL, 16);
-    printf("Dumping %u bytes of flash\n", size);
-    char* flash = (char*) malloc(sizeof(char) * size);
-    mesh_flash_read(flash, offset, size);
+    enum hexdump_mode mode = argv > 3 ? HEXDUMP_BASE64 : HEXDUMP_HEX;
+    struct hexdump hd;
 
-    // print hex in 16 byte blocks
-    for(unsigned int i = 0; i < size; ++i)
+    char* chunk = (char*) mesh_arena_alloc(MESH_DUMP_CHUNK);
+    if (!chunk)
     {
-        if (i % 16 == 0)
+        printf("Not enough memory to dump flash\n");
+        return 0;
+    }
+
+    printf("Dumping %u bytes of flash\n", size);
+    hexdump_start(&hd, mode, offset, 1);
+    while (size)
+    {
+        unsigned int len = min_t(unsigned int, size, MESH_DUMP_CHUNK);
+
+        if (mesh_flash_read(chunk, offset, len))
         {
-            printf("0x%06x ", i);
+            printf("\nFlash read failed at 0x%x\n", offset);
+            break;
         }
-        printf("%02x ", flash[i]);
-        if (i % 16 == 15)
+        if (hexdump_write(&hd, chunk, len))
         {
-        printf("\n");
+            printf("\nInterrupted\n");
+            break;
         }
+        offset += len;
+        size -= len;
     }
-    printf("\n");
-
-    free(flash);
+    hexdump_finish(&hd);
 
     return 0;
 }
@@ -561,6 +992,8 @@ void mesh_loop(void) {
     char **args;
     int status = 1;
 
+    bootstage_mark_name(BOOTSTAGE_ID_MESH_LOOP, "mesh_loop");
+
     memset(user.name, 0, MAX_STR_LEN);
     memset(user.pin, 0, MAX_STR_LEN);
 
@@ -589,6 +1022,7 @@ void mesh_loop(void) {
             while(1);
         }
     }
+    mesh_arena_reset(NULL);
 
     memset(user.name, 0, MAX_STR_LEN);
     memset(user.pin, 0, MAX_STR_LEN);
@@ -608,11 +1042,13 @@ void mesh_loop(void) {
             // if (!run_command(line, 0)){
             // }
 
-            args = mesh_split_line(line);
+            args = line ? mesh_split_line(line) : NULL;
+            if (!args) {
+                mesh_arena_reset(NULL);
+                continue;
+            }
             status = mesh_execute(args);
-            free(args);
-
-            free(line);
+            mesh_arena_reset(args[0]);
 
             // -2 for exit
             if (status == MESH_SHUTDOWN)
@@ -674,6 +1110,7 @@ int mesh_ls_iterate_dir(struct ext2fs_node *dir, char *fname)
             char filename[dirent.namelen + 1];
             struct ext2fs_node *fdiro;
             int type = FILETYPE_UNKNOWN;
+            size_t mark = mesh_arena_mark();
 
             status = ext4fs_read_file(diro,
                           fpos +
@@ -683,7 +1120,7 @@ int mesh_ls_iterate_dir(struct ext2fs_node *dir, char *fname)
             if (status < 0)
                 return 0;
 
-            fdiro = zalloc(sizeof(struct ext2fs_node));
+            fdiro = mesh_arena_zalloc(sizeof(struct ext2fs_node));
             if (!fdiro)
                 return 0;
 
@@ -707,7 +1144,7 @@ int mesh_ls_iterate_dir(struct ext2fs_node *dir, char *fname)
                                (dirent.inode),
                                &fdiro->inode);
                 if (status == 0) {
-                    free(fdiro);
+                    mesh_arena_release(mark);
                     return 0;
                 }
                 fdiro->inode_read = 1;
@@ -738,7 +1175,7 @@ int mesh_ls_iterate_dir(struct ext2fs_node *dir, char *fname)
                                  dirent.inode),
                                  &fdiro->inode);
                     if (status == 0) {
-                        free(fdiro);
+                        mesh_arena_release(mark);
                         return 0;
                     }
                     fdiro->inode_read = 1;
@@ -757,7 +1194,7 @@ int mesh_ls_iterate_dir(struct ext2fs_node *dir, char *fname)
                     break;
                 }
             }
-            free(fdiro);
+            mesh_arena_release(mark);
         }
         fpos += le16_to_cpu(dirent.direntlen);
     }
@@ -862,26 +1299,32 @@ void full_name_from_short_name(char* full_name, struct games_tbl_row* row)
 int mesh_game_installed(char *game_name){
     struct games_tbl_row row;
     unsigned int offset = MESH_INSTALL_GAME_OFFSET;
+    size_t mark = mesh_arena_mark();
 
+    bootstage_start(BOOTSTAGE_ID_ACCUM_MESH_TABLE, "mesh_table_scan");
     // loop through install table until table end is found
     for(mesh_flash_read(&row, offset, sizeof(struct games_tbl_row));
         row.install_flag != MESH_TABLE_END;
         mesh_flash_read(&row, offset, sizeof(struct games_tbl_row)))
     {
         // the most space that we could need to store the full game name
-        char* full_name = (char*) malloc(snprintf(NULL, 0, "%s-v%d.%d", row.game_name, row.major_version, row.minor_version) + 1);
+        char* full_name = (char*) mesh_arena_alloc(snprintf(NULL, 0, "%s-v%d.%d", row.game_name, row.major_version, row.minor_version) + 1);
+        if (!full_name)
+            break;
         full_name_from_short_name(full_name, &row);
         // check if game is installed and if it is for the specified user.
         if (strcmp(game_name, full_name) == 0 &&
             strcmp(user.name, row.user_name) == 0 &&
             row.install_flag == MESH_TABLE_INSTALLED)
         {
-            free(full_name);
+            mesh_arena_release(mark);
+            bootstage_accum(BOOTSTAGE_ID_ACCUM_MESH_TABLE);
             return 1;
         }
-        free(full_name);
+        mesh_arena_release(mark);
         offset += sizeof(struct games_tbl_row);
     }
+    bootstage_accum(BOOTSTAGE_ID_ACCUM_MESH_TABLE);
 
     return 0;
 }
@@ -954,6 +1397,7 @@ int mesh_check_downgrade(char *game_name, unsigned int major_version, unsigned i
     unsigned int offset = MESH_INSTALL_GAME_OFFSET;
     int return_value = 0;
 
+    bootstage_start(BOOTSTAGE_ID_ACCUM_MESH_TABLE, "mesh_table_scan");
     for(mesh_flash_read(&row, offset, sizeof(struct games_tbl_row));
         row.install_flag != MESH_TABLE_END;
         mesh_flash_read(&row, offset, sizeof(struct games_tbl_row)))
@@ -992,6 +1436,7 @@ int mesh_check_downgrade(char *game_name, unsigned int major_version, unsigned i
             return_value = return_value == 1 ? return_value : 2;
         }
     }
+    bootstage_accum(BOOTSTAGE_ID_ACCUM_MESH_TABLE);
     return return_value;
 }
 
@@ -1003,6 +1448,8 @@ void mesh_get_game_header(Game *game, char *game_name){
     int i = 0;
     int j = 0;
 
+    bootstage_start(BOOTSTAGE_ID_ACCUM_MESH_HEADER, "mesh_header_read");
+
     // get the size of the game
     game_size = mesh_size_ext4(game_name);
 
@@ -1055,6 +1502,7 @@ void mesh_get_game_header(Game *game, char *game_name){
     game->num_users = i;
 
     free(game_buffer);
+    bootstage_accum(BOOTSTAGE_ID_ACCUM_MESH_HEADER);
 }
 /*
     This function reads in the specified game and ensures that the user is
@@ -1149,6 +1597,69 @@ int mesh_install_validate_args(char **args){
     return 0;
 }
 
+/*
+    This function allocates size bytes from the mesh arena, aligned to 8
+    bytes. It returns NULL if the arena is out of room.
+*/
+void *mesh_arena_alloc(size_t size)
+{
+    size_t start = ALIGN(mesh_arena.used, 8);
+
+    if (size > sizeof(mesh_arena.buf) - start) {
+        printf("Out of mesh arena memory for %zu bytes\n", size);
+        return NULL;
+    }
+    mesh_arena.used = start + size;
+    mesh_arena.peak = max(mesh_arena.peak, mesh_arena.used);
+
+    return mesh_arena.buf + start;
+}
+
+/*
+    This function allocates size zeroed bytes from the mesh arena.
+*/
+void *mesh_arena_zalloc(size_t size)
+{
+    void *p = mesh_arena_alloc(size);
+
+    if (p) {
+        memset(p, 0, size);
+    }
+
+    return p;
+}
+
+/*
+    These functions free everything allocated from the arena since the mark
+    was taken, for a loop to give back what each pass used.
+*/
+size_t mesh_arena_mark(void)
+{
+    return mesh_arena.used;
+}
+
+void mesh_arena_release(size_t mark)
+{
+    mesh_arena.used = mark;
+}
+
+/*
+    This function frees everything in the arena once a command is done with
+    it. With CONFIG_MESH_ARENA_REPORT it first prints the most the command
+    had allocated at once.
+*/
+void mesh_arena_reset(const char *cmd)
+{
+#ifdef CONFIG_MESH_ARENA_REPORT
+    if (cmd) {
+        printf("arena: %s peaked at %zu of %zu bytes\n", cmd,
+               mesh_arena.peak, sizeof(mesh_arena.buf));
+    }
+#endif
+    mesh_arena.used = 0;
+    mesh_arena.peak = 0;
+}
+
 /*
     This function executes the specified command for the given user.
     It finds the command in builtin_func and then calls the function with the
@@ -1193,16 +1704,15 @@ void ptr_to_string(void* ptr, char* buf)
 int mesh_is_first_table_write(void)
 {
     /* Initialize the table where games will be installed */
-    char* sentinel = (char*) malloc(sizeof(char) * MESH_SENTINEL_LENGTH);
+    unsigned int sentinel;
     int ret = 0;
 
-    mesh_flash_read(sentinel, MESH_SENTINEL_LOCATION, MESH_SENTINEL_LENGTH);
+    mesh_flash_read(&sentinel, MESH_SENTINEL_LOCATION, MESH_SENTINEL_LENGTH);
 
-    if (*((unsigned int*) sentinel) != MESH_SENTINEL_VALUE)
+    if (sentinel != MESH_SENTINEL_VALUE)
     {
         ret = 1;
     }
-    free(sentinel);
     return ret;
 }
 
@@ -1240,15 +1750,20 @@ int mesh_num_builtins(void) {
     This function reads a line from stdin and returns a pointer to the character
     buffer containing the null terminated line. 
 
-    This funciton allocates the charater buffer on the heap, therefore, the caller
-    must free this buffer to avoid a memory leak.
+    This funciton allocates the charater buffer in the mesh arena, so it lasts
+    until the arena is reset after the command. It returns NULL if the arena
+    is full.
 */
 char* mesh_read_line(int bufsize)
 {
     int position = 0;
-    char *buffer = (char*) malloc(sizeof(char) * bufsize);
+    char *buffer = (char*) mesh_arena_alloc(sizeof(char) * bufsize);
     int c;
 
+    if (!buffer) {
+        return NULL;
+    }
+
     while (1) {
         // Read a character
         c = getc();
@@ -1299,29 +1814,25 @@ int mesh_get_argv(char **args){
     This function is used to split a single line of command line arguments
     into an array of individual arguments. 
 
-    It returns an array of character buffers. Both this array and the character
-    buffers are allocated on the heap and therefore, it is the responsibility of
-    the caller to free this memory after the arguments are used.
+    It returns an array of pointers into line, allocated in the mesh arena.
+    Every token but the last is followed by a delimiter, so the array is
+    sized for the most tokens line can hold and never has to grow. It
+    returns NULL if the arena is full.
 */
 char **mesh_split_line(char *line) {
-    int bufsize = MESH_TOK_BUFSIZE, position = 0;
-    char **tokens = (char**) malloc(bufsize * sizeof(char*));
-    char *token, **tokens_backup;
+    int position = 0;
+    char **tokens = (char**) mesh_arena_alloc((strlen(line) / 2 + 2) * sizeof(char*));
+    char *token;
+
+    if (!tokens) {
+        return NULL;
+    }
 
     token = strtok(line, MESH_TOK_DELIM);
     while (token != NULL) {
         tokens[position] = token;
         position++;
 
-        if (position >= bufsize) {
-            bufsize += MESH_TOK_BUFSIZE;
-            tokens_backup = tokens;
-            tokens = realloc(tokens, bufsize * sizeof(char*));
-            if (!tokens) {
-                free(tokens_backup);
-            }
-        }
-
         token = strtok(NULL, MESH_TOK_DELIM);
     }
     tokens[position] = NULL;
@@ -1331,7 +1842,7 @@ char **mesh_split_line(char *line) {
 /*
     This function prompts from user input from stdin and returns a point to
     that read line. Note, this is line is created using mesh_read_line and thus
-    it is the responsibility of the caller to free the character buffer.
+    lives in the mesh arena, and is NULL if the arena is full.
 */
 char* mesh_input(char* prompt)
 {
@@ -1348,17 +1859,28 @@ int mesh_login(User *user) {
     User tmp_user;
 
     char *tmp_name, *tmp_pin;
+    size_t mark;
     int retval;
 
     memset(user->name, 0, MAX_STR_LEN);
 
+    // empty lines are given back to the arena as they are read
+    mark = mesh_arena_mark();
     do {
+        mesh_arena_release(mark);
         tmp_name = mesh_input("Enter your username: ");
-    } while (!strlen(tmp_name));
+    } while (tmp_name && !strlen(tmp_name));
 
+    mark = mesh_arena_mark();
     do {
-        tmp_pin = mesh_input("Enter your PIN: ");
-    } while (!strlen(tmp_pin));
+        mesh_arena_release(mark);
+        tmp_pin = tmp_name ? mesh_input("Enter your PIN: ") : NULL;
+    } while (tmp_pin && !strlen(tmp_pin));
+
+    if (!tmp_pin) {
+        mesh_arena_reset(NULL);
+        return 1;
+    }
 
     strncpy(tmp_user.name, tmp_name, MAX_STR_LEN);
     strncpy(tmp_user.pin, tmp_pin, MAX_STR_LEN);
@@ -1372,8 +1894,7 @@ int mesh_login(User *user) {
         printf("Login failed. Please try again\n");
     }
 
-    free(tmp_name);
-    free(tmp_pin);
+    mesh_arena_reset(NULL);
 
     return retval;
 }
@@ -305,12 +305,20 @@ ulong blk_write_devnum(enum if_type if_type, int devnum, lbaint_t start,
 	return blk_dwrite(desc, start, blkcnt, buffer);
 }
 
+/* Wait for the read in flight on a device, if any, before using it */
+static void blk_dread_flush(struct blk_desc *block_dev)
+{
+	if (block_dev->inflight)
+		blk_dread_wait(block_dev->inflight);
+}
+
 int blk_select_hwpart(struct udevice *dev, int hwpart)
 {
 	const struct blk_ops *ops = blk_get_ops(dev);
 
 	if (!ops)
 		return -ENOSYS;
+	blk_dread_flush(dev_get_uclass_platdata(dev));
 	if (!ops->select_hwpart)
 		return 0;
 
@@ -396,6 +404,7 @@ unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 	if (!ops->read)
 		return -ENOSYS;
 
+	blk_dread_flush(block_dev);
 	if (blkcache_read(block_dev->if_type, block_dev->devnum,
 			  start, blkcnt, block_dev->blksz, buffer))
 		return blkcnt;
@@ -416,6 +425,7 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 	if (!ops->write)
 		return -ENOSYS;
 
+	blk_dread_flush(block_dev);
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
 	return ops->write(dev, start, blkcnt, buffer);
 }
@@ -429,10 +439,80 @@ unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 	if (!ops->erase)
 		return -ENOSYS;
 
+	blk_dread_flush(block_dev);
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
 	return ops->erase(dev, start, blkcnt);
 }
 
+/* Record the result of a read, which is then done */
+static void blk_dread_done(struct blk_req *req, ulong blks_read)
+{
+	struct blk_desc *block_dev = req->desc;
+
+	if (blks_read == req->blkcnt)
+		blkcache_fill(block_dev->if_type, block_dev->devnum,
+			      req->start, req->blkcnt, block_dev->blksz,
+			      req->buffer);
+	req->ret = blks_read;
+	req->busy = false;
+	if (block_dev->inflight == req)
+		block_dev->inflight = NULL;
+}
+
+void blk_dread_start(struct blk_desc *block_dev, lbaint_t start,
+		     lbaint_t blkcnt, void *buffer, struct blk_req *req)
+{
+	struct udevice *dev = block_dev->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	int ret = -ENOSYS;
+
+	blk_dread_flush(block_dev);
+	req->desc = block_dev;
+	req->start = start;
+	req->blkcnt = blkcnt;
+	req->buffer = buffer;
+	req->busy = false;
+
+	if (blkcache_read(block_dev->if_type, block_dev->devnum,
+			  start, blkcnt, block_dev->blksz, buffer)) {
+		req->ret = blkcnt;
+		return;
+	}
+	if (ops->read_start && ops->read_poll)
+		ret = ops->read_start(dev, req);
+	if (!ret) {
+		req->busy = true;
+		block_dev->inflight = req;
+	} else if (ret == -ENOSYS && ops->read) {
+		blk_dread_done(req, ops->read(dev, start, blkcnt, buffer));
+	} else {
+		req->ret = ret;
+	}
+}
+
+bool blk_dread_poll(struct blk_req *req)
+{
+	struct udevice *dev = req->desc->bdev;
+	long ret;
+
+	if (!req->busy)
+		return true;
+	ret = blk_get_ops(dev)->read_poll(dev, req);
+	if (ret == -EBUSY)
+		return false;
+	blk_dread_done(req, ret);
+
+	return true;
+}
+
+ulong blk_dread_wait(struct blk_req *req)
+{
+	while (!blk_dread_poll(req))
+		;
+
+	return req->ret;
+}
+
 int blk_prepare_device(struct udevice *dev)
 {
 	struct blk_desc *desc = dev_get_uclass_platdata(dev);
@@ -542,8 +622,16 @@ int blk_unbind_all(int if_type)
 	return 0;
 }
 
+static int blk_pre_remove(struct udevice *dev)
+{
+	blk_dread_flush(dev_get_uclass_platdata(dev));
+
+	return 0;
+}
+
 UCLASS_DRIVER(blk) = {
 	.id		= UCLASS_BLK,
 	.name		= "blk",
+	.pre_remove	= blk_pre_remove,
 	.per_device_platdata_auto_alloc_size = sizeof(struct blk_desc),
 };
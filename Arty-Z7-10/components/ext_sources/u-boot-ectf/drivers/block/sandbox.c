@@ -61,6 +61,20 @@ static unsigned long host_block_read(struct blk_desc *block_dev,
 }
 
 #ifdef CONFIG_BLK
+/*
+ * A started read is only done when it is polled, so that it can be seen to
+ * be in flight as it would be on a real device.
+ */
+static int host_block_read_start(struct udevice *dev, struct blk_req *req)
+{
+	return 0;
+}
+
+static long host_block_read_poll(struct udevice *dev, struct blk_req *req)
+{
+	return host_block_read(dev, req->start, req->blkcnt, req->buffer);
+}
+
 static unsigned long host_block_write(struct udevice *dev,
 				      unsigned long start, lbaint_t blkcnt,
 				      const void *buffer)
@@ -220,6 +234,8 @@ int host_get_dev_err(int devnum, struct blk_desc **blk_devp)
 #ifdef CONFIG_BLK
 static const struct blk_ops sandbox_host_blk_ops = {
 	.read	= host_block_read,
+	.read_start	= host_block_read_start,
+	.read_poll	= host_block_read_poll,
 	.write	= host_block_write,
 };
 
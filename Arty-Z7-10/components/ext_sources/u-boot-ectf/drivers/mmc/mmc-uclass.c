@@ -36,6 +36,29 @@ int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 	return dm_mmc_send_cmd(mmc->dev, cmd, data);
 }
 
+int dm_mmc_send_cmd_start(struct udevice *dev, struct mmc_cmd *cmd,
+			  struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+	int ret;
+
+	if (!ops->send_cmd_start || !ops->send_cmd_poll)
+		return -ENOSYS;
+	mmmc_trace_before_send(mmc, cmd);
+	ret = ops->send_cmd_start(dev, cmd, data);
+	mmmc_trace_after_send(mmc, cmd, ret);
+
+	return ret;
+}
+
+int dm_mmc_send_cmd_poll(struct udevice *dev, struct mmc_data *data)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+
+	return ops->send_cmd_poll(dev, data);
+}
+
 int dm_mmc_set_ios(struct udevice *dev)
 {
 	struct dm_mmc_ops *ops = mmc_get_ops(dev);
@@ -301,6 +324,10 @@ static int mmc_select_hwpart(struct udevice *bdev, int hwpart)
 
 static const struct blk_ops mmc_blk_ops = {
 	.read	= mmc_bread,
+#if defined(CONFIG_DM_MMC_OPS) && !defined(CONFIG_SPL_BUILD)
+	.read_start	= mmc_bread_start,
+	.read_poll	= mmc_bread_poll,
+#endif
 #ifndef CONFIG_SPL_BUILD
 	.write	= mmc_bwrite,
 	.erase	= mmc_berase,
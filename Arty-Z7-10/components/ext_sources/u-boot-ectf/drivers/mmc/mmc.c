@@ -209,78 +209,131 @@ int mmc_send_status(struct mmc *mmc, int timeout)
 int mmc_set_blocklen(struct mmc *mmc, int len)
 {
 	struct mmc_cmd cmd;
+	int err;
 
 	if (mmc->ddr_mode)
 		return 0;
 
+	/* The card keeps its block length until it goes idle */
+	if (mmc->blocklen == len) {
+		mmc->stats.blocklen_cached++;
+		return 0;
+	}
+
 	cmd.cmdidx = MMC_CMD_SET_BLOCKLEN;
 	cmd.resp_type = MMC_RSP_R1;
 	cmd.cmdarg = len;
 
-	return mmc_send_cmd(mmc, &cmd, NULL);
+	mmc->stats.set_blocklen++;
+	err = mmc_send_cmd(mmc, &cmd, NULL);
+	mmc->blocklen = err ? 0 : len;
+
+	return err;
 }
 
-static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
-			   lbaint_t blkcnt)
+/*
+ * Set up cmd and data to read blkcnt blocks, first sending a CMD23 if the
+ * card takes one, in which case *set_count is set.
+ */
+static int mmc_read_blocks_prepare(struct mmc *mmc, struct mmc_cmd *cmd,
+				   struct mmc_data *data, void *dst,
+				   lbaint_t start, lbaint_t blkcnt,
+				   bool *set_count)
 {
-	struct mmc_cmd cmd;
-	struct mmc_data data;
+	/*
+	 * With the count set beforehand the card stops by itself, which
+	 * saves the CMD12 and its busy wait.
+	 */
+	*set_count = blkcnt > 1 && (mmc->card_caps & MMC_MODE_CMD23) &&
+		     !mmc_host_is_spi(mmc);
+	if (*set_count) {
+		cmd->cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+		cmd->cmdarg = blkcnt;
+		cmd->resp_type = MMC_RSP_R1;
+		mmc->stats.set_block_count++;
+		if (mmc_send_cmd(mmc, cmd, NULL))
+			return -EIO;
+	}
 
 	if (blkcnt > 1)
-		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
+		cmd->cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
 	else
-		cmd.cmdidx = MMC_CMD_READ_SINGLE_BLOCK;
+		cmd->cmdidx = MMC_CMD_READ_SINGLE_BLOCK;
 
 	if (mmc->high_capacity)
-		cmd.cmdarg = start;
+		cmd->cmdarg = start;
 	else
-		cmd.cmdarg = start * mmc->read_bl_len;
+		cmd->cmdarg = start * mmc->read_bl_len;
 
-	cmd.resp_type = MMC_RSP_R1;
+	cmd->resp_type = MMC_RSP_R1;
 
-	data.dest = dst;
-	data.blocks = blkcnt;
-	data.blocksize = mmc->read_bl_len;
-	data.flags = MMC_DATA_READ;
+	data->dest = dst;
+	data->blocks = blkcnt;
+	data->blocksize = mmc->read_bl_len;
+	data->flags = MMC_DATA_READ;
 
-	if (mmc_send_cmd(mmc, &cmd, &data))
-		return 0;
+	mmc->stats.read_cmds++;
+
+	return 0;
+}
 
-	if (blkcnt > 1) {
+/* Stop a read of blkcnt blocks, unless the card stops by itself */
+static int mmc_read_blocks_stop(struct mmc *mmc, lbaint_t blkcnt,
+				bool set_count)
+{
+	struct mmc_cmd cmd;
+
+	if (blkcnt > 1 && !set_count) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
+		mmc->stats.stop++;
 		if (mmc_send_cmd(mmc, &cmd, NULL)) {
 #if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
 			printf("mmc fail to send stop cmd\n");
 #endif
-			return 0;
+			return -EIO;
 		}
 	}
 
-	return blkcnt;
+	return 0;
 }
 
-#ifdef CONFIG_BLK
-ulong mmc_bread(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *dst)
-#else
-ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
-		void *dst)
-#endif
+static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
+			   lbaint_t blkcnt)
 {
-#ifdef CONFIG_BLK
-	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
-#endif
-	int dev_num = block_dev->devnum;
-	int err;
-	lbaint_t cur, blocks_todo = blkcnt;
+	struct mmc_cmd cmd;
+	struct mmc_data data;
+	bool set_count;
 
-	if (blkcnt == 0)
+	if (mmc_read_blocks_prepare(mmc, &cmd, &data, dst, start, blkcnt,
+				    &set_count))
 		return 0;
+	if (mmc_send_cmd(mmc, &cmd, &data))
+		return 0;
+	if (mmc_read_blocks_stop(mmc, blkcnt, set_count))
+		return 0;
+
+	return blkcnt;
+}
+
+/*
+ * Check a read of blocks from block_dev and get the card ready for it,
+ * counting it in the stats. Returns the card, or NULL if it can't be read.
+ */
+static struct mmc *mmc_bread_setup(struct blk_desc *block_dev, lbaint_t start,
+				   lbaint_t blkcnt, lbaint_t *b_max)
+{
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+	int err;
 
-	struct mmc *mmc = find_mmc_device(dev_num);
 	if (!mmc)
-		return 0;
+		return NULL;
+
+	/* CMD23 counts 16 bits of blocks, whatever the host can do */
+	*b_max = mmc->cfg->b_max;
+	if (mmc->card_caps & MMC_MODE_CMD23)
+		*b_max = min_t(lbaint_t, *b_max, 0xffff);
 
 	if (CONFIG_IS_ENABLED(MMC_TINY))
 		err = mmc_switch_part(mmc, block_dev->hwpart);
@@ -288,24 +341,49 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		err = blk_dselect_hwpart(block_dev, block_dev->hwpart);
 
 	if (err < 0)
-		return 0;
+		return NULL;
 
 	if ((start + blkcnt) > block_dev->lba) {
 #if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
 		printf("MMC: block number 0x" LBAF " exceeds max(0x" LBAF ")\n",
 			start + blkcnt, block_dev->lba);
 #endif
-		return 0;
+		return NULL;
 	}
 
 	if (mmc_set_blocklen(mmc, mmc->read_bl_len)) {
 		debug("%s: Failed to set blocklen\n", __func__);
-		return 0;
+		return NULL;
 	}
 
+	mmc->stats.reads++;
+	mmc->stats.blocks += blkcnt;
+
+	return mmc;
+}
+
+#ifdef CONFIG_BLK
+ulong mmc_bread(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *dst)
+#else
+ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
+		void *dst)
+#endif
+{
+#ifdef CONFIG_BLK
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+#endif
+	struct mmc *mmc;
+	lbaint_t cur, b_max, blocks_todo = blkcnt;
+
+	if (blkcnt == 0)
+		return 0;
+
+	mmc = mmc_bread_setup(block_dev, start, blkcnt, &b_max);
+	if (!mmc)
+		return 0;
+
 	do {
-		cur = (blocks_todo > mmc->cfg->b_max) ?
-			mmc->cfg->b_max : blocks_todo;
+		cur = (blocks_todo > b_max) ? b_max : blocks_todo;
 		if (mmc_read_blocks(mmc, dst, start, cur) != cur) {
 			debug("%s: Failed to read blocks\n", __func__);
 			return 0;
@@ -318,6 +396,87 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	return blkcnt;
 }
 
+#if defined(CONFIG_BLK) && defined(CONFIG_DM_MMC_OPS) && \
+	!defined(CONFIG_SPL_BUILD)
+/*
+ * Send the next command of an asynchronous read. A transfer the host can't
+ * start is done here and now instead.
+ */
+static int mmc_bread_next(struct mmc *mmc)
+{
+	struct mmc_async_read *rd = &mmc->async;
+	lbaint_t cur = min(rd->todo, rd->b_max);
+	struct mmc_cmd cmd;
+	int ret;
+
+	ret = mmc_read_blocks_prepare(mmc, &cmd, &rd->data, rd->dst,
+				      rd->start, cur, &rd->set_count);
+	if (ret)
+		return ret;
+	ret = dm_mmc_send_cmd_start(mmc->dev, &cmd, &rd->data);
+	rd->busy = !ret;
+	if (ret == -ENOSYS)
+		ret = mmc_send_cmd(mmc, &cmd, &rd->data);
+	if (ret)
+		return ret;
+
+	rd->todo -= cur;
+	rd->start += cur;
+	rd->dst += cur * mmc->read_bl_len;
+
+	return 0;
+}
+
+int mmc_bread_start(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+	struct mmc_async_read *rd;
+
+	/* without the host's help, read() does just as well */
+	if (!mmc || !req->blkcnt || !mmc_get_ops(mmc->dev)->send_cmd_start)
+		return -ENOSYS;
+
+	rd = &mmc->async;
+	if (!mmc_bread_setup(block_dev, req->start, req->blkcnt, &rd->b_max))
+		return -EIO;
+	rd->dst = req->buffer;
+	rd->start = req->start;
+	rd->todo = req->blkcnt;
+
+	return mmc_bread_next(mmc);
+}
+
+long mmc_bread_poll(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+	struct mmc_async_read *rd = &mmc->async;
+	int ret = 0;
+
+	if (rd->busy) {
+		ret = dm_mmc_send_cmd_poll(mmc->dev, &rd->data);
+		if (ret == -EBUSY)
+			return ret;
+		rd->busy = false;
+	}
+	if (!ret)
+		ret = mmc_read_blocks_stop(mmc, rd->data.blocks,
+					   rd->set_count);
+	if (!ret && rd->todo) {
+		ret = mmc_bread_next(mmc);
+		if (!ret)
+			return -EBUSY;
+	}
+	if (ret) {
+		debug("%s: Failed to read blocks\n", __func__);
+		return 0;
+	}
+
+	return req->blkcnt;
+}
+#endif
+
 static int mmc_go_idle(struct mmc *mmc)
 {
 	struct mmc_cmd cmd;
@@ -329,6 +488,7 @@ static int mmc_go_idle(struct mmc *mmc)
 	cmd.cmdarg = 0;
 	cmd.resp_type = MMC_RSP_NONE;
 
+	mmc->blocklen = 0;
 	err = mmc_send_cmd(mmc, &cmd, NULL);
 
 	if (err)
@@ -708,6 +868,9 @@ static int mmc_change_freq(struct mmc *mmc)
 	if (mmc_host_is_spi(mmc))
 		return 0;
 
+	if (mmc->version >= MMC_VERSION_3)
+		mmc->card_caps |= MMC_MODE_CMD23;
+
 	/* Only version 4 supports high-speed */
 	if (mmc->version < MMC_VERSION_4)
 		return 0;
@@ -1167,6 +1330,8 @@ retry_scr:
 
 	if (mmc->scr[0] & SD_DATA_4BIT)
 		mmc->card_caps |= MMC_MODE_4BIT;
+	if (mmc->scr[0] & SD_SCR_CMD23_SUPPORT)
+		mmc->card_caps |= MMC_MODE_CMD23;
 
 	/* Version 1.0 doesn't support switching */
 	if (mmc->version == SD_VERSION_1_0)
@@ -23,6 +23,8 @@ void mmc_adapter_card_type_ident(void);
 #ifdef CONFIG_BLK
 ulong mmc_bread(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 		void *dst);
+int mmc_bread_start(struct udevice *dev, struct blk_req *req);
+long mmc_bread_poll(struct udevice *dev, struct blk_req *req);
 #else
 ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		void *dst);
@@ -17,6 +17,7 @@ DECLARE_GLOBAL_DATA_PTR;
 struct sandbox_mmc_plat {
 	struct mmc_config cfg;
 	struct mmc mmc;
+	struct mmc_cmd started;		/* read started, done when polled */
 };
 
 /**
@@ -60,6 +61,7 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		strcpy(data->dest, "this is a test");
 		break;
 	case MMC_CMD_STOP_TRANSMISSION:
+	case MMC_CMD_SET_BLOCK_COUNT:
 		break;
 	case SD_CMD_APP_SEND_OP_COND:
 		cmd->response[0] = OCR_BUSY | OCR_HCS;
@@ -74,7 +76,8 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	case SD_CMD_APP_SEND_SCR: {
 		u32 *scr = (u32 *)data->dest;
 
-		scr[0] = cpu_to_be32(2 << 24 | 1 << 15);  /* SD version 3 */
+		/* SD version 3, with CMD23 */
+		scr[0] = cpu_to_be32(2 << 24 | 1 << 15 | SD_SCR_CMD23_SUPPORT);
 		break;
 	}
 	default:
@@ -85,6 +88,28 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	return 0;
 }
 
+/*
+ * A started read is only done when it is polled, so that it can be seen to
+ * be in flight as it would be with DMA.
+ */
+static int sandbox_mmc_send_cmd_start(struct udevice *dev, struct mmc_cmd *cmd,
+				      struct mmc_data *data)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	plat->started = *cmd;
+
+	return 0;
+}
+
+static int sandbox_mmc_send_cmd_poll(struct udevice *dev,
+				     struct mmc_data *data)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	return sandbox_mmc_send_cmd(dev, &plat->started, data);
+}
+
 static int sandbox_mmc_set_ios(struct udevice *dev)
 {
 	return 0;
@@ -97,6 +122,8 @@ static int sandbox_mmc_get_cd(struct udevice *dev)
 
 static const struct dm_mmc_ops sandbox_mmc_ops = {
 	.send_cmd = sandbox_mmc_send_cmd,
+	.send_cmd_start = sandbox_mmc_send_cmd_start,
+	.send_cmd_poll = sandbox_mmc_send_cmd_poll,
 	.set_ios = sandbox_mmc_set_ios,
 	.get_cd = sandbox_mmc_get_cd,
 };
@@ -114,7 +141,8 @@ int sandbox_mmc_bind(struct udevice *dev)
 	struct mmc_config *cfg = &plat->cfg;
 
 	cfg->name = dev->name;
-	cfg->host_caps = MMC_MODE_HS_52MHz | MMC_MODE_HS | MMC_MODE_8BIT;
+	cfg->host_caps = MMC_MODE_HS_52MHz | MMC_MODE_HS | MMC_MODE_8BIT |
+			 MMC_MODE_CMD23;
 	cfg->voltages = MMC_VDD_165_195 | MMC_VDD_32_33 | MMC_VDD_33_34;
 	cfg->f_min = 1000000;
 	cfg->f_max = 52000000;
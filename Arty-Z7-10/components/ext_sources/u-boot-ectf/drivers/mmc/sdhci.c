@@ -69,16 +69,30 @@ static void sdhci_transfer_pio(struct sdhci_host *host, struct mmc_data *data)
 	}
 }
 
-static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data,
-				unsigned int start_addr)
+static void sdhci_start_dma(struct sdhci_host *host)
 {
-	unsigned int stat, rdy, mask, timeout, block = 0;
-#ifdef CONFIG_MMC_SDHCI_SDMA
 	unsigned char ctrl;
+
 	ctrl = sdhci_readb(host, SDHCI_HOST_CONTROL);
 	ctrl &= ~SDHCI_CTRL_DMA_MASK;
 	sdhci_writeb(host, ctrl, SDHCI_HOST_CONTROL);
-#endif
+}
+
+/* Move the DMA address on to the next boundary, where the engine paused */
+static void sdhci_next_dma(struct sdhci_host *host)
+{
+	sdhci_writel(host, SDHCI_INT_DMA_END, SDHCI_INT_STATUS);
+	host->dma_addr &= ~(SDHCI_DEFAULT_BOUNDARY_SIZE - 1);
+	host->dma_addr += SDHCI_DEFAULT_BOUNDARY_SIZE;
+	sdhci_writel(host, host->dma_addr, SDHCI_DMA_ADDRESS);
+}
+
+static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data)
+{
+	unsigned int stat, rdy, mask, timeout, block = 0;
+
+	if (host->dma)
+		sdhci_start_dma(host);
 
 	timeout = 1000000;
 	rdy = SDHCI_INT_SPACE_AVAIL | SDHCI_INT_DATA_AVAIL;
@@ -99,14 +113,8 @@ static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data,
 			if (++block >= data->blocks)
 				break;
 		}
-#ifdef CONFIG_MMC_SDHCI_SDMA
-		if (stat & SDHCI_INT_DMA_END) {
-			sdhci_writel(host, SDHCI_INT_DMA_END, SDHCI_INT_STATUS);
-			start_addr &= ~(SDHCI_DEFAULT_BOUNDARY_SIZE - 1);
-			start_addr += SDHCI_DEFAULT_BOUNDARY_SIZE;
-			sdhci_writel(host, start_addr, SDHCI_DMA_ADDRESS);
-		}
-#endif
+		if (host->dma && (stat & SDHCI_INT_DMA_END))
+			sdhci_next_dma(host);
 		if (timeout-- > 0)
 			udelay(10);
 		else {
@@ -127,35 +135,36 @@ static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data,
 #define SDHCI_CMD_MAX_TIMEOUT			3200
 #define SDHCI_CMD_DEFAULT_TIMEOUT		100
 #define SDHCI_READ_STATUS_TIMEOUT		1000
+#define SDHCI_DATA_TIMEOUT			10000
 
-#ifdef CONFIG_DM_MMC_OPS
-static int sdhci_send_command(struct udevice *dev, struct mmc_cmd *cmd,
-			      struct mmc_data *data)
-{
-	struct mmc *mmc = mmc_get_mmc_dev(dev);
-
-#else
-static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
-			      struct mmc_data *data)
+/*
+ * Send a command and wait for its response, setting up its data transfer,
+ * by SDMA if dma is true. Returns 0 if the data can now be transferred, 1
+ * if there is nothing more to do, or -ve on error.
+ */
+static int sdhci_start_command(struct mmc *mmc, struct mmc_cmd *cmd,
+			       struct mmc_data *data, bool dma)
 {
-#endif
 	struct sdhci_host *host = mmc->priv;
 	unsigned int stat = 0;
-	int ret = 0;
-	int trans_bytes = 0, is_aligned = 1;
+	int trans_bytes = 0;
 	u32 mask, flags, mode;
 	unsigned int time = 0, start_addr = 0;
+	bool auto_stop;
 	int mmc_dev = mmc_get_blk_desc(mmc)->devnum;
 	unsigned start = get_timer(0);
 
 	/* Timeout unit - ms */
 	static unsigned int cmd_timeout = SDHCI_CMD_DEFAULT_TIMEOUT;
 
+	host->dma = false;
+	host->dma_bounce = false;
+
 	if (((host->last_cmd == MMC_CMD_WRITE_MULTIPLE_BLOCK) ||
 	     (host->last_cmd == MMC_CMD_READ_MULTIPLE_BLOCK)) &&
 	    (host->quirks & SDHCI_QUIRK_USE_ACMD12) &&
 	    (cmd->cmdidx == MMC_CMD_STOP_TRANSMISSION))
-		return 0;
+		return 1;
 
 	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
 	mask = SDHCI_CMD_INHIBIT | SDHCI_DATA_INHIBIT;
@@ -209,6 +218,12 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	    (cmd->cmdidx ==  MMC_CMD_SEND_TUNING_BLOCK_HS200))
 		flags |= SDHCI_CMD_DATA;
 
+	/* After a CMD23 the card stops by itself */
+	auto_stop = ((cmd->cmdidx == MMC_CMD_WRITE_MULTIPLE_BLOCK) ||
+		     (cmd->cmdidx == MMC_CMD_READ_MULTIPLE_BLOCK)) &&
+		    (host->quirks & SDHCI_QUIRK_USE_ACMD12) &&
+		    (host->last_cmd != MMC_CMD_SET_BLOCK_COUNT);
+
 	host->last_cmd = cmd->cmdidx;
 
 	/* Set Transfer mode regarding to data flag */
@@ -219,41 +234,40 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 		if (data->blocks > 1)
 			mode |= SDHCI_TRNS_MULTI;
 
-		if (((cmd->cmdidx == MMC_CMD_WRITE_MULTIPLE_BLOCK) ||
-		     (cmd->cmdidx == MMC_CMD_READ_MULTIPLE_BLOCK)) &&
-		    (host->quirks & SDHCI_QUIRK_USE_ACMD12))
+		if (auto_stop)
 			mode |= SDHCI_TRNS_ACMD12;
 
 		if (data->flags == MMC_DATA_READ)
 			mode |= SDHCI_TRNS_READ;
 
-#ifdef CONFIG_MMC_SDHCI_SDMA
-		if (data->flags == MMC_DATA_READ)
-			start_addr = (unsigned long)data->dest;
-		else
-			start_addr = (unsigned long)data->src;
-		if ((host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR) &&
-				(start_addr & 0x7) != 0x0) {
-			is_aligned = 0;
+		if (dma) {
+			if (data->flags == MMC_DATA_READ)
+				start_addr = (unsigned long)data->dest;
+			else
+				start_addr = (unsigned long)data->src;
+			if ((host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR) &&
+					(start_addr & 0x7) != 0x0) {
+				host->dma_bounce = true;
+				start_addr = (unsigned long)aligned_buffer;
+				if (data->flags != MMC_DATA_READ)
+					memcpy(aligned_buffer, data->src,
+					       trans_bytes);
+			}
+
+#if defined(CONFIG_FIXED_SDHCI_ALIGNED_BUFFER)
+			/*
+			 * Always use this bounce-buffer when
+			 * CONFIG_FIXED_SDHCI_ALIGNED_BUFFER is defined
+			 */
+			host->dma_bounce = true;
 			start_addr = (unsigned long)aligned_buffer;
 			if (data->flags != MMC_DATA_READ)
 				memcpy(aligned_buffer, data->src, trans_bytes);
-		}
-
-#if defined(CONFIG_FIXED_SDHCI_ALIGNED_BUFFER)
-		/*
-		 * Always use this bounce-buffer when
-		 * CONFIG_FIXED_SDHCI_ALIGNED_BUFFER is defined
-		 */
-		is_aligned = 0;
-		start_addr = (unsigned long)aligned_buffer;
-		if (data->flags != MMC_DATA_READ)
-			memcpy(aligned_buffer, data->src, trans_bytes);
 #endif
 
-		sdhci_writel(host, start_addr, SDHCI_DMA_ADDRESS);
-		mode |= SDHCI_TRNS_DMA;
-#endif
+			sdhci_writel(host, start_addr, SDHCI_DMA_ADDRESS);
+			mode |= SDHCI_TRNS_DMA;
+		}
 		sdhci_writew(host, SDHCI_MAKE_BLKSZ(SDHCI_DEFAULT_BOUNDARY_ARG,
 				data->blocksize),
 				SDHCI_BLOCK_SIZE);
@@ -264,10 +278,13 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	}
 
 	sdhci_writel(host, cmd->cmdarg, SDHCI_ARGUMENT);
-#ifdef CONFIG_MMC_SDHCI_SDMA
-	trans_bytes = ALIGN(trans_bytes, CONFIG_SYS_CACHELINE_SIZE);
-	flush_cache(start_addr, trans_bytes);
-#endif
+	if (dma) {
+		trans_bytes = ALIGN(trans_bytes, CONFIG_SYS_CACHELINE_SIZE);
+		flush_cache(start_addr, trans_bytes);
+	}
+	host->dma = dma && data;
+	host->dma_addr = start_addr;
+	host->trans_bytes = trans_bytes;
 	sdhci_writew(host, SDHCI_MAKE_CMD(cmd->cmdidx, flags), SDHCI_COMMAND);
 	start = get_timer(0);
 	do {
@@ -277,7 +294,7 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 
 		if (get_timer(start) >= SDHCI_READ_STATUS_TIMEOUT) {
 			if (host->quirks & SDHCI_QUIRK_BROKEN_R1B) {
-				return 0;
+				return 1;
 			} else {
 				printf("%s: Timeout for status update!\n",
 				       __func__);
@@ -289,11 +306,17 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	if ((stat & (SDHCI_INT_ERROR | mask)) == mask) {
 		sdhci_cmd_done(host, cmd);
 		sdhci_writel(host, mask, SDHCI_INT_STATUS);
-	} else
-		ret = -1;
+		return 0;
+	}
 
-	if (!ret && data)
-		ret = sdhci_transfer_data(host, data, start_addr);
+	return -1;
+}
+
+/* Finish a command whose data transfer returned ret */
+static int sdhci_end_command(struct sdhci_host *host, struct mmc_data *data,
+			     int ret)
+{
+	unsigned int stat;
 
 	if (host->quirks & SDHCI_QUIRK_WAIT_SEND_CMD)
 		udelay(1000);
@@ -301,9 +324,8 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	stat = sdhci_readl(host, SDHCI_INT_STATUS);
 	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
 	if (!ret) {
-		if ((host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR) &&
-				!is_aligned && (data->flags == MMC_DATA_READ))
-			memcpy(data->dest, aligned_buffer, trans_bytes);
+		if (host->dma_bounce && (data->flags == MMC_DATA_READ))
+			memcpy(data->dest, aligned_buffer, host->trans_bytes);
 		return 0;
 	}
 
@@ -314,6 +336,100 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	else
 		return -ECOMM;
 }
+
+#ifdef CONFIG_DM_MMC_OPS
+static int sdhci_send_command(struct udevice *dev, struct mmc_cmd *cmd,
+			      struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+
+#else
+static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
+			      struct mmc_data *data)
+{
+#endif
+	struct sdhci_host *host = mmc->priv;
+	int ret;
+
+	ret = sdhci_start_command(mmc, cmd, data,
+				  IS_ENABLED(CONFIG_MMC_SDHCI_SDMA));
+	if (ret > 0)
+		return 0;
+	if (!ret && data)
+		ret = sdhci_transfer_data(host, data);
+
+	return sdhci_end_command(host, data, ret);
+}
+
+#if defined(CONFIG_DM_MMC_OPS) && !defined(CONFIG_SPL_BUILD)
+/*
+ * Reads are started by SDMA into the caller's buffer, which must be whole
+ * cache lines as it is invalidated once the data is in. The data's arrival
+ * is then polled for, moving the DMA address on at each boundary. Without
+ * MMC_SDHCI_SDMA, reads are left to sdhci_send_command() by PIO.
+ */
+static int sdhci_send_command_start(struct udevice *dev, struct mmc_cmd *cmd,
+				    struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+	ulong dest = (ulong)data->dest;
+	int ret;
+
+	if (!IS_ENABLED(CONFIG_MMC_SDHCI_SDMA) ||
+	    !(sdhci_readl(host, SDHCI_CAPABILITIES) & SDHCI_CAN_DO_SDMA) ||
+	    data->flags != MMC_DATA_READ ||
+	    !IS_ALIGNED(dest, ARCH_DMA_MINALIGN) ||
+	    !IS_ALIGNED(data->blocks * data->blocksize, ARCH_DMA_MINALIGN))
+		return -ENOSYS;
+#if defined(CONFIG_FIXED_SDHCI_ALIGNED_BUFFER)
+	return -ENOSYS;
+#endif
+
+	ret = sdhci_start_command(mmc, cmd, data, true);
+	if (ret > 0)
+		ret = -ETIMEDOUT;
+	if (ret)
+		return sdhci_end_command(host, data, ret);
+
+	sdhci_start_dma(host);
+	host->data_start = get_timer(0);
+
+	return 0;
+}
+
+static int sdhci_send_command_poll(struct udevice *dev, struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+	ulong dest = (ulong)data->dest;
+	unsigned int stat;
+	int ret = 0;
+
+	stat = sdhci_readl(host, SDHCI_INT_STATUS);
+	if (stat & SDHCI_INT_ERROR) {
+		printf("%s: Error detected in status(0x%X)!\n", __func__,
+		       stat);
+		ret = -EIO;
+	} else {
+		if (stat & SDHCI_INT_DMA_END)
+			sdhci_next_dma(host);
+		if (!(stat & SDHCI_INT_DATA_END)) {
+			if (get_timer(host->data_start) < SDHCI_DATA_TIMEOUT)
+				return -EBUSY;
+			printf("%s: Transfer data timeout\n", __func__);
+			ret = -ETIMEDOUT;
+		}
+	}
+
+	ret = sdhci_end_command(host, data, ret);
+	if (!ret)
+		invalidate_dcache_range(dest, dest + host->trans_bytes);
+
+	return ret;
+}
+#endif
+
 #ifdef CONFIG_DM_MMC_OPS
 static int sdhci_execute_tuning(struct udevice *dev, u8 opcode)
 {
@@ -697,6 +813,10 @@ int sdhci_probe(struct udevice *dev)
 
 const struct dm_mmc_ops sdhci_ops = {
 	.send_cmd	= sdhci_send_command,
+#ifndef CONFIG_SPL_BUILD
+	.send_cmd_start	= sdhci_send_command_start,
+	.send_cmd_poll	= sdhci_send_command_poll,
+#endif
 	.set_ios	= sdhci_set_ios,
 	.set_voltage	= sdhci_set_voltage,
 	.set_uhs	= sdhci_set_uhs,
@@ -808,6 +928,14 @@ int sdhci_setup_cfg(struct mmc_config *cfg, struct sdhci_host *host,
 	if (caps_1 & SDHCI_USE_SDR50_TUNING)
 		cfg->host_caps |= MMC_MODE_NEEDS_TUNING;
 
+	/*
+	 * Without Auto-CMD12 each multi-block read needs a CMD12 after it,
+	 * which a CMD23 before it saves. With it, a CMD23 would be one command
+	 * more, and on hosts with SDHCI_QUIRK_WAIT_SEND_CMD a millisecond more.
+	 */
+	if (!(host->quirks & SDHCI_QUIRK_USE_ACMD12))
+		cfg->host_caps |= MMC_MODE_CMD23;
+
 	if (host->host_caps)
 		cfg->host_caps |= host->host_caps;
 
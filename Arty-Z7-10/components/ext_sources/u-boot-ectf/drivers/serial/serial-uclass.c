@@ -139,8 +139,31 @@ static void _serial_putc(struct udevice *dev, char ch)
 
 static void _serial_puts(struct udevice *dev, const char *str)
 {
-	while (*str)
-		_serial_putc(dev, *str++);
+	struct dm_serial_ops *ops = serial_get_ops(dev);
+	int len, ret;
+
+	if (!ops->puts) {
+		while (*str)
+			_serial_putc(dev, *str++);
+		return;
+	}
+
+	while (*str) {
+		/* hand over everything up to the next newline at once */
+		for (len = 0; str[len] && str[len] != '\n'; len++)
+			;
+		while (len) {
+			ret = ops->puts(dev, str, len);
+			if (ret == -EAGAIN)
+				continue;
+			if (ret < 0)
+				return;
+			str += ret;
+			len -= ret;
+		}
+		if (*str == '\n')
+			_serial_putc(dev, *str++);
+	}
 }
 
 static int _serial_getc(struct udevice *dev)
@@ -311,6 +334,8 @@ static int serial_post_probe(struct udevice *dev)
 		ops->getc += gd->reloc_off;
 	if (ops->putc)
 		ops->putc += gd->reloc_off;
+	if (ops->puts)
+		ops->puts += gd->reloc_off;
 	if (ops->pending)
 		ops->pending += gd->reloc_off;
 	if (ops->clear)
@@ -21,6 +21,7 @@
 DECLARE_GLOBAL_DATA_PTR;
 
 #define ZYNQ_UART_SR_TXEMPTY	(1 << 3) /* TX FIFO empty */
+#define ZYNQ_UART_SR_TXFULL	(1 << 4) /* TX FIFO full */
 #define ZYNQ_UART_SR_TXACTIVE	(1 << 11)  /* TX active */
 #define ZYNQ_UART_SR_RXEMPTY	0x00000002 /* RX FIFO empty */
 
@@ -96,9 +97,14 @@ static void _uart_zynq_serial_init(struct uart_zynq *regs)
 	writel(ZYNQ_UART_MR_PARITY_NONE, &regs->mode); /* 8 bit, no parity */
 }
 
+/*
+ * Queue a character as long as there is room in the 64 byte TX FIFO, rather
+ * than waiting for it to drain completely, so that the UART always has the
+ * next character to send.
+ */
 static int _uart_zynq_serial_putc(struct uart_zynq *regs, const char c)
 {
-	if (!(readl(&regs->channel_sts) & ZYNQ_UART_SR_TXEMPTY))
+	if (readl(&regs->channel_sts) & ZYNQ_UART_SR_TXFULL)
 		return -EAGAIN;
 
 	writel(c, &regs->tx_rx_fifo);
@@ -168,15 +174,33 @@ static int zynq_serial_putc(struct udevice *dev, const char ch)
 	return _uart_zynq_serial_putc(priv->regs, ch);
 }
 
+/* Fill the TX FIFO with as much of the string as fits */
+static int zynq_serial_puts(struct udevice *dev, const char *s, int len)
+{
+	struct zynq_uart_priv *priv = dev_get_priv(dev);
+	struct uart_zynq *regs = priv->regs;
+	int i;
+
+	for (i = 0; i < len; i++) {
+		if (readl(&regs->channel_sts) & ZYNQ_UART_SR_TXFULL)
+			break;
+		writel(s[i], &regs->tx_rx_fifo);
+	}
+
+	return i ? i : -EAGAIN;
+}
+
 static int zynq_serial_pending(struct udevice *dev, bool input)
 {
 	struct zynq_uart_priv *priv = dev_get_priv(dev);
 	struct uart_zynq *regs = priv->regs;
+	u32 sts = readl(&regs->channel_sts);
 
 	if (input)
-		return !(readl(&regs->channel_sts) & ZYNQ_UART_SR_RXEMPTY);
+		return !(sts & ZYNQ_UART_SR_RXEMPTY);
 	else
-		return !!(readl(&regs->channel_sts) & ZYNQ_UART_SR_TXACTIVE);
+		return !(sts & ZYNQ_UART_SR_TXEMPTY) ||
+		       !!(sts & ZYNQ_UART_SR_TXACTIVE);
 }
 
 static int zynq_serial_ofdata_to_platdata(struct udevice *dev)
@@ -190,6 +214,7 @@ static int zynq_serial_ofdata_to_platdata(struct udevice *dev)
 
 static const struct dm_serial_ops zynq_serial_ops = {
 	.putc = zynq_serial_putc,
+	.puts = zynq_serial_puts,
 	.pending = zynq_serial_pending,
 	.getc = zynq_serial_getc,
 	.setbrg = zynq_serial_setbrg,
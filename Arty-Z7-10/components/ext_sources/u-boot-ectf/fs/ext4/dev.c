@@ -129,6 +129,53 @@ int ext4fs_devread(lbaint_t sector, int byte_offset, int byte_len, char *buf)
 	return 1;
 }
 
+/*
+ * Start a read as ext4fs_devread() does. Whole sectors are left to arrive
+ * in the background, anything else is read before returning; either way
+ * the read is then waited for with ext4fs_devread_wait(). Returns 1 if it
+ * was started, 0 on error.
+ */
+int ext4fs_devread_start(lbaint_t sector, int byte_offset, int byte_len,
+			 char *buf, struct blk_req *req)
+{
+	int log2blksz;
+
+	if (ext4fs_blk_desc == NULL ||
+	    ((byte_offset | byte_len) & (ext4fs_blk_desc->blksz - 1))) {
+		req->desc = ext4fs_blk_desc;
+		req->blkcnt = 0;
+		req->busy = false;
+		req->ret = ext4fs_devread(sector, byte_offset, byte_len, buf) ?
+			   0 : -EIO;
+		return !req->ret;
+	}
+
+	log2blksz = ext4fs_blk_desc->log2blksz;
+	sector += byte_offset >> log2blksz;
+	if ((sector < 0) ||
+	    ((sector + (byte_len >> log2blksz) - 1) >= part_info->size)) {
+		printf("%s read outside partition " LBAFU "\n", __func__,
+		       sector);
+		return 0;
+	}
+
+	blk_dread_start(ext4fs_blk_desc, part_info->start + sector,
+			byte_len >> log2blksz, buf, req);
+
+	return 1;
+}
+
+/* Wait for a read from ext4fs_devread_start(). Returns 1 if OK, 0 on error */
+int ext4fs_devread_wait(struct blk_req *req)
+{
+	if (blk_dread_wait(req) != req->blkcnt) {
+		printf(" ** %s read error\n", __func__);
+		return 0;
+	}
+
+	return 1;
+}
+
 int ext4_read_superblock(char *buffer)
 {
 	struct ext_filesystem *fs = get_fs();
@@ -41,13 +41,76 @@ void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot)
 		free(node);
 }
 
+/*
+ * A file being read a run of blocks at a time, with each run left in flight
+ * while the blocks of the next are looked up
+ */
+struct ext4fs_file_read {
+	struct blk_req req[2];	/* the run last started and the one before */
+	int cur;		/* index of the run last started */
+	bool pending;		/* the run last started has not been waited for */
+	char *reported;		/* end of what has been passed to fn */
+	ext4fs_stream_fn fn;
+	void *priv;
+};
+
+/* Pass fn what has been read, up to end */
+static int ext4fs_read_report(struct ext4fs_file_read *rd, char *end)
+{
+	int ret = 0;
+
+	if (rd->fn && end > rd->reported)
+		ret = rd->fn(rd->priv, rd->reported, end - rd->reported);
+	rd->reported = end;
+
+	return ret;
+}
+
+/*
+ * Start reading a run, then wait for the one before and pass fn what has
+ * been read while this one is in flight
+ */
+static int ext4fs_read_spill(struct ext4fs_file_read *rd, lbaint_t sector,
+			     int byte_offset, int byte_len, char *buf)
+{
+	struct blk_req *prev = rd->pending ? &rd->req[rd->cur] : NULL;
+
+	rd->cur = !rd->cur;
+	rd->pending = ext4fs_devread_start(sector, byte_offset, byte_len, buf,
+					   &rd->req[rd->cur]);
+	if (prev && !ext4fs_devread_wait(prev))
+		return -1;
+	if (!rd->pending)
+		return -1;
+
+	return ext4fs_read_report(rd, buf);
+}
+
+/*
+ * Wait for the run in flight, then pass fn the rest of what has been read,
+ * up to end. With end NULL this just waits, before giving up on an error.
+ */
+static int ext4fs_read_finish(struct ext4fs_file_read *rd, char *end)
+{
+	int ret = 0;
+
+	if (rd->pending && !ext4fs_devread_wait(&rd->req[rd->cur]))
+		ret = -1;
+	rd->pending = false;
+	if (!ret && end)
+		ret = ext4fs_read_report(rd, end);
+
+	return ret;
+}
+
 /*
  * Taken from openmoko-kernel mailing list: By Andy green
  * Optimized read file API : collects and defers contiguous sector
  * reads into one potentially more efficient larger sequential read action
  */
-int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
-		loff_t len, char *buf, loff_t *actread)
+static int ext4fs_read_file_stream(struct ext2fs_node *node, loff_t pos,
+				   loff_t len, char *buf, loff_t *actread,
+				   ext4fs_stream_fn fn, void *priv)
 {
 	struct ext_filesystem *fs = get_fs();
 	int i;
@@ -62,11 +125,17 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 	lbaint_t delayed_skipfirst = 0;
 	lbaint_t delayed_next = 0;
 	char *delayed_buf = NULL;
-	short status;
+	char *end;
+	struct ext4fs_file_read rd = {
+		.reported = buf,
+		.fn = fn,
+		.priv = priv,
+	};
 
 	/* Adjust len so it we can't read past the end of the file. */
 	if (len + pos > filesize)
 		len = (filesize - pos);
+	end = buf + len;
 
 	blockcnt = lldiv(((len + pos) + blocksize - 1), blocksize);
 
@@ -77,7 +146,7 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		int skipfirst = 0;
 		blknr = read_allocated_block(&(node->inode), i);
 		if (blknr < 0)
-			return -1;
+			goto err;
 
 		blknr = blknr << log2_fs_blocksize;
 
@@ -96,19 +165,17 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 			blockend -= skipfirst;
 		}
 		if (blknr) {
-			int status;
-
 			if (previous_block_number != -1) {
 				if (delayed_next == blknr) {
 					delayed_extent += blockend;
 					delayed_next += blockend >> log2blksz;
 				} else {	/* spill */
-					status = ext4fs_devread(delayed_start,
+					if (ext4fs_read_spill(&rd,
+							delayed_start,
 							delayed_skipfirst,
 							delayed_extent,
-							delayed_buf);
-					if (status == 0)
-						return -1;
+							delayed_buf))
+						goto err;
 					previous_block_number = blknr;
 					delayed_start = blknr;
 					delayed_extent = blockend;
@@ -129,12 +196,11 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		} else {
 			if (previous_block_number != -1) {
 				/* spill */
-				status = ext4fs_devread(delayed_start,
-							delayed_skipfirst,
-							delayed_extent,
-							delayed_buf);
-				if (status == 0)
-					return -1;
+				if (ext4fs_read_spill(&rd, delayed_start,
+						      delayed_skipfirst,
+						      delayed_extent,
+						      delayed_buf))
+					goto err;
 				previous_block_number = -1;
 			}
 			memset(buf, 0, blocksize - skipfirst);
@@ -143,16 +209,27 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 	}
 	if (previous_block_number != -1) {
 		/* spill */
-		status = ext4fs_devread(delayed_start,
-					delayed_skipfirst, delayed_extent,
-					delayed_buf);
-		if (status == 0)
-			return -1;
+		if (ext4fs_read_spill(&rd, delayed_start, delayed_skipfirst,
+				      delayed_extent, delayed_buf))
+			goto err;
 		previous_block_number = -1;
 	}
+	if (ext4fs_read_finish(&rd, end))
+		return -1;
 
 	*actread  = len;
 	return 0;
+
+err:
+	ext4fs_read_finish(&rd, NULL);
+	return -1;
+}
+
+int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
+		loff_t len, char *buf, loff_t *actread)
+{
+	return ext4fs_read_file_stream(node, pos, len, buf, actread, NULL,
+				       NULL);
 }
 
 int ext4fs_ls(const char *dirname)
@@ -198,6 +275,16 @@ int ext4fs_read(char *buf, loff_t offset, loff_t len, loff_t *actread)
 	return ext4fs_read_file(ext4fs_file, offset, len, buf, actread);
 }
 
+int ext4fs_read_stream(char *buf, loff_t offset, loff_t len, loff_t *actread,
+		       ext4fs_stream_fn fn, void *priv)
+{
+	if (ext4fs_root == NULL || ext4fs_file == NULL)
+		return -1;
+
+	return ext4fs_read_file_stream(ext4fs_file, offset, len, buf, actread,
+				       fn, priv);
+}
+
 int ext4fs_probe(struct blk_desc *fs_dev_desc,
 		 disk_partition_t *fs_partition)
 {
@@ -15,6 +15,7 @@
 #include <exports.h>
 #include <fat.h>
 #include <asm/byteorder.h>
+#include <asm/unaligned.h>
 #include <part.h>
 #include <malloc.h>
 #include <memalign.h>
@@ -41,9 +42,46 @@ static void downcase(char *str)
 static struct blk_desc *cur_dev;
 static disk_partition_t cur_part_info;
 
+/*
+ * The cluster chain of the last file read, as runs of contiguous clusters.
+ * Loading a file usually means several reads of it (a header, then the
+ * rest), and this saves following the chain through the FAT every time.
+ * Runs are added as reads reach them; past FAT_MAX_EXTENTS runs the rest of
+ * the chain is followed on each read as before.
+ *
+ * The fs commands set the block device again each time, so the runs are
+ * kept across commands for as long as the device, partition and volume ID
+ * stay the same. Writes throw them away.
+ */
+struct fat_extent {
+	__u32	start;		/* First cluster of the run */
+	__u32	count;		/* Number of clusters */
+};
+
+static struct {
+	struct blk_desc	*dev;		/* NULL if nothing is cached */
+	lbaint_t	part_start;
+	__u32		volume_id;
+	__u32		startclust;
+	__u32		filesize;
+	__u32		nclust;		/* Clusters covered by extent[] */
+	__u32		nextclust;	/* Cluster following them */
+	int		count;		/* Number of runs in extent[] */
+	struct fat_extent extent[FAT_MAX_EXTENTS];
+} fat_extents;
+
+static void fat_extents_invalidate(void)
+{
+	fat_extents.dev = NULL;
+}
+
 #define DOS_BOOT_MAGIC_OFFSET	0x1fe
 #define DOS_FS_TYPE_OFFSET	0x36
 #define DOS_FS32_TYPE_OFFSET	0x52
+#define DOS_VOLUME_ID_OFFSET	0x27
+#define DOS_FS32_VOLUME_ID_OFFSET	0x43
+
+static __u32 cur_volume_id;
 
 static int disk_read(__u32 block, __u32 nr_blocks, void *buf)
 {
@@ -80,10 +118,16 @@ int fat_set_blk_dev(struct blk_desc *dev_desc, disk_partition_t *info)
 	}
 
 	/* Check for FAT12/FAT16/FAT32 filesystem */
-	if (!memcmp(buffer + DOS_FS_TYPE_OFFSET, "FAT", 3))
+	if (!memcmp(buffer + DOS_FS_TYPE_OFFSET, "FAT", 3)) {
+		cur_volume_id = get_unaligned_le32(buffer +
+						   DOS_VOLUME_ID_OFFSET);
 		return 0;
-	if (!memcmp(buffer + DOS_FS32_TYPE_OFFSET, "FAT32", 5))
+	}
+	if (!memcmp(buffer + DOS_FS32_TYPE_OFFSET, "FAT32", 5)) {
+		cur_volume_id = get_unaligned_le32(buffer +
+						   DOS_FS32_VOLUME_ID_OFFSET);
 		return 0;
+	}
 
 	cur_dev = NULL;
 	return -1;
@@ -172,6 +216,92 @@ int flush_dirty_fat_buffer(fsdata *mydata)
 }
 #endif
 
+/*
+ * The FAT is cached in FATBUFWINDOWS windows of FATBUFBLOCKS sectors, so
+ * that a fragmented chain hopping between parts of the FAT does not read
+ * the same sectors again and again. fatbuf/fatbufnum is the window in use;
+ * only that one can be dirty, and it is written back before switching.
+ */
+static int fat_cache_alloc(fsdata *mydata)
+{
+	int i;
+
+	mydata->fatcache = memalign(ARCH_DMA_MINALIGN,
+				    FATBUFSIZE * FATBUFWINDOWS);
+	if (mydata->fatcache == NULL)
+		return -1;
+
+	for (i = 0; i < FATBUFWINDOWS; i++) {
+		mydata->fatcachenum[i] = -1;
+		mydata->fatcacheused[i] = 0;
+	}
+	mydata->fatcacheclock = 0;
+	mydata->fatbuf = mydata->fatcache;
+	mydata->fatbufnum = -1;
+	mydata->fat_dirty = 0;
+
+	return 0;
+}
+
+static void fat_cache_free(fsdata *mydata)
+{
+	free(mydata->fatcache);
+	mydata->fatcache = NULL;
+	mydata->fatbuf = NULL;
+}
+
+/*
+ * Make block 'bufnum' of the FAT the current window, reading it in place
+ * of the least recently used window if it is not cached.
+ * Return 0 on success, -1 otherwise.
+ */
+static int fat_cache_select(fsdata *mydata, __u32 bufnum)
+{
+	__u32 getsize = FATBUFBLOCKS;
+	__u32 startblock = bufnum * FATBUFBLOCKS;
+	__u8 *bufptr;
+	int i, lru = 0;
+
+	if (bufnum == mydata->fatbufnum)
+		return 0;
+
+	/* Write back the fatbuf to the disk */
+	if (flush_dirty_fat_buffer(mydata) < 0)
+		return -1;
+
+	for (i = 0; i < FATBUFWINDOWS; i++) {
+		if (mydata->fatcachenum[i] == bufnum)
+			break;
+		if (mydata->fatcacheused[i] < mydata->fatcacheused[lru])
+			lru = i;
+	}
+
+	if (i == FATBUFWINDOWS) {
+		i = lru;
+		bufptr = mydata->fatcache + i * FATBUFSIZE;
+
+		/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
+		if (startblock + getsize > mydata->fatlength)
+			getsize = mydata->fatlength - startblock;
+
+		startblock += mydata->fat_sect;	/* Offset from start of disk */
+
+		if (disk_read(startblock, getsize, bufptr) < 0) {
+			mydata->fatcachenum[i] = -1;
+			if (mydata->fatbuf == bufptr)
+				mydata->fatbufnum = -1;
+			return -1;
+		}
+		mydata->fatcachenum[i] = bufnum;
+	}
+
+	mydata->fatbuf = mydata->fatcache + i * FATBUFSIZE;
+	mydata->fatbufnum = bufnum;
+	mydata->fatcacheused[i] = ++mydata->fatcacheclock;
+
+	return 0;
+}
+
 /*
  * Get the entry at index 'entry' in a FAT (12/16/32) table.
  * On failure 0x00 is returned.
@@ -210,27 +340,9 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 	       mydata->fatsize, entry, entry, offset, offset);
 
 	/* Read a new block of FAT entries into the cache. */
-	if (bufnum != mydata->fatbufnum) {
-		__u32 getsize = FATBUFBLOCKS;
-		__u8 *bufptr = mydata->fatbuf;
-		__u32 fatlength = mydata->fatlength;
-		__u32 startblock = bufnum * FATBUFBLOCKS;
-
-		/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
-		if (startblock + getsize > fatlength)
-			getsize = fatlength - startblock;
-
-		startblock += mydata->fat_sect;	/* Offset from start of disk */
-
-		/* Write back the fatbuf to the disk */
-		if (flush_dirty_fat_buffer(mydata) < 0)
-			return -1;
-
-		if (disk_read(startblock, getsize, bufptr) < 0) {
-			debug("Error reading FAT blocks\n");
-			return ret;
-		}
-		mydata->fatbufnum = bufnum;
+	if (fat_cache_select(mydata, bufnum) < 0) {
+		debug("Error reading FAT blocks\n");
+		return ret;
 	}
 
 	/* Get the actual entry from the table */
@@ -330,14 +442,44 @@ __u8 get_contents_vfatname_block[MAX_CLUSTSIZE]
 __u8 *get_contents_vfatname_block = (__u8 *)FAT_BUFF_PTR_OCM;
 #endif
 
+/*
+ * Follow the cluster chain from *next for the next run of contiguous
+ * clusters, stopping at the end of the file's 'fileclust' clusters.
+ * Update *next to the cluster after the run and *done to the number of
+ * clusters walked so far. Return 0 on success, -1 if the chain is invalid.
+ */
+static int get_next_run(fsdata *mydata, __u32 *next, __u32 *done,
+			__u32 fileclust, struct fat_extent *run)
+{
+	__u32 clust = *next;
+
+	if (*done >= fileclust || CHECK_CLUST(clust, mydata->fatsize))
+		return -1;
+
+	run->start = clust;
+	run->count = 1;
+	while (*done + run->count < fileclust) {
+		clust = get_fatent(mydata, clust);
+		if (clust != run->start + run->count ||
+		    CHECK_CLUST(clust, mydata->fatsize))
+			break;
+		run->count++;
+	}
+	*done += run->count;
+	*next = clust;
+
+	return 0;
+}
+
 static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 			__u8 *buffer, loff_t maxsize, loff_t *gotsize)
 {
 	loff_t filesize = FAT2CPU32(dentptr->size);
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
-	__u32 curclust = START(dentptr);
-	__u32 endclust, newclust;
-	loff_t actsize;
+	__u32 fileclust, next, done, clust, skip;
+	loff_t runpos = 0, runend, actsize;
+	struct fat_extent run;
+	int i = 0;
 
 	*gotsize = 0;
 	debug("Filesize: %llu bytes\n", filesize);
@@ -347,97 +489,96 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 		return 0;
 	}
 
+	fileclust = FAT2CPU32(dentptr->size) / bytesperclust +
+		    (FAT2CPU32(dentptr->size) % bytesperclust != 0);
+
 	if (maxsize > 0 && filesize > pos + maxsize)
 		filesize = pos + maxsize;
 
 	debug("%llu bytes\n", filesize);
 
-	actsize = bytesperclust;
-
-	/* go to cluster at pos */
-	while (actsize <= pos) {
-		curclust = get_fatent(mydata, curclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			debug("Invalid FAT entry\n");
-			return 0;
-		}
-		actsize += bytesperclust;
+	/* Start again if the cached runs are for another file */
+	if (fat_extents.dev != cur_dev ||
+	    fat_extents.part_start != cur_part_info.start ||
+	    fat_extents.volume_id != cur_volume_id ||
+	    fat_extents.startclust != START(dentptr) ||
+	    fat_extents.filesize != FAT2CPU32(dentptr->size)) {
+		fat_extents.dev = cur_dev;
+		fat_extents.part_start = cur_part_info.start;
+		fat_extents.volume_id = cur_volume_id;
+		fat_extents.startclust = START(dentptr);
+		fat_extents.filesize = FAT2CPU32(dentptr->size);
+		fat_extents.nclust = 0;
+		fat_extents.nextclust = START(dentptr);
+		fat_extents.count = 0;
 	}
+	next = fat_extents.nextclust;
+	done = fat_extents.nclust;
 
-	/* actsize > pos */
-	actsize -= bytesperclust;
-	filesize -= actsize;
-	pos -= actsize;
-
-	/* align to beginning of next cluster if any */
-	if (pos) {
-		actsize = min(filesize, (loff_t)bytesperclust);
-		if (get_cluster(mydata, curclust, get_contents_vfatname_block,
-				(int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
+	while (pos < filesize) {
+		/* Take the next run from the cache, or find and cache it */
+		if (i < fat_extents.count) {
+			run = fat_extents.extent[i++];
+		} else {
+			if (get_next_run(mydata, &next, &done, fileclust,
+					 &run) < 0) {
+				debug("curclust: 0x%x\n", next);
+				printf("Invalid FAT entry\n");
+				return 0;
+			}
+			if (i < FAT_MAX_EXTENTS) {
+				fat_extents.extent[i++] = run;
+				fat_extents.count = i;
+				fat_extents.nclust = done;
+				fat_extents.nextclust = next;
+			}
 		}
-		filesize -= actsize;
-		actsize -= pos;
-		memcpy(buffer, get_contents_vfatname_block + pos, actsize);
-		*gotsize += actsize;
-		if (!filesize)
-			return 0;
-		buffer += actsize;
 
-		curclust = get_fatent(mydata, curclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			debug("Invalid FAT entry\n");
-			return 0;
+		runend = runpos + (loff_t)run.count * bytesperclust;
+		if (pos >= runend) {
+			runpos = runend;
+			continue;
 		}
-	}
 
-	actsize = bytesperclust;
-	endclust = curclust;
-
-	do {
-		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = get_fatent(mydata, endclust);
-			if ((newclust - 1) != endclust)
-				goto getit;
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("curclust: 0x%x\n", newclust);
-				debug("Invalid FAT entry\n");
-				return 0;
+		/* Find the cluster holding pos */
+		skip = pos - runpos;
+		clust = run.start + skip / bytesperclust;
+		skip %= bytesperclust;
+
+		/* Read the start of a cluster through the bounce buffer */
+		if (skip) {
+			actsize = min(filesize - pos + skip,
+				      (loff_t)bytesperclust);
+			if (get_cluster(mydata, clust,
+					get_contents_vfatname_block,
+					(int)actsize) != 0) {
+				printf("Error reading cluster\n");
+				return -1;
 			}
-			endclust = newclust;
-			actsize += bytesperclust;
+			actsize -= skip;
+			memcpy(buffer, get_contents_vfatname_block + skip,
+			       actsize);
+			*gotsize += actsize;
+			buffer += actsize;
+			pos += actsize;
+			clust++;
 		}
 
-		/* get remaining bytes */
-		actsize = filesize;
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		*gotsize += actsize;
-		return 0;
-getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
+		/* Then the rest of the run in one go */
+		actsize = min(filesize, runend) - pos;
+		if (actsize > 0) {
+			if (get_cluster(mydata, clust, buffer, actsize) != 0) {
+				printf("Error reading cluster\n");
+				return -1;
+			}
+			*gotsize += actsize;
+			buffer += actsize;
+			pos += actsize;
 		}
-		*gotsize += (int)actsize;
-		filesize -= actsize;
-		buffer += actsize;
+		runpos = runend;
+	}
 
-		curclust = get_fatent(mydata, endclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			printf("Invalid FAT entry\n");
-			return 0;
-		}
-		actsize = bytesperclust;
-		endclust = curclust;
-	} while (1);
+	return 0;
 }
 
 /*
@@ -887,10 +1028,7 @@ int do_fat_read_at(const char *filename, loff_t pos, void *buffer,
 					(mydata->clust_size * 2);
 	}
 
-	mydata->fatbufnum = -1;
-	mydata->fat_dirty = 0;
-	mydata->fatbuf = memalign(ARCH_DMA_MINALIGN, FATBUFSIZE);
-	if (mydata->fatbuf == NULL) {
+	if (fat_cache_alloc(mydata) < 0) {
 		debug("Error: allocating memory\n");
 		return -1;
 	}
@@ -1243,7 +1381,7 @@ rootdir_done:
 	debug("Size: %u, got: %llu\n", FAT2CPU32(dentptr->size), *size);
 
 exit:
-	free(mydata->fatbuf);
+	fat_cache_free(mydata);
 	return ret;
 }
 
@@ -387,26 +387,9 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 	}
 
 	/* Read a new block of FAT entries into the cache. */
-	if (bufnum != mydata->fatbufnum) {
-		int getsize = FATBUFBLOCKS;
-		__u8 *bufptr = mydata->fatbuf;
-		__u32 fatlength = mydata->fatlength;
-		__u32 startblock = bufnum * FATBUFBLOCKS;
-
-		/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
-		if (startblock + getsize > fatlength)
-			getsize = fatlength - startblock;
-
-		if (flush_dirty_fat_buffer(mydata) < 0)
-			return -1;
-
-		startblock += mydata->fat_sect;
-
-		if (disk_read(startblock, getsize, bufptr) < 0) {
-			debug("Error reading FAT blocks\n");
-			return -1;
-		}
-		mydata->fatbufnum = bufnum;
+	if (fat_cache_select(mydata, bufnum) < 0) {
+		debug("Error reading FAT blocks\n");
+		return -1;
 	}
 
 	/* Mark as dirty */
@@ -920,6 +903,9 @@ static int do_fat_write(const char *filename, void *buffer, loff_t size,
 	*actwrite = size;
 	dir_curclust = 0;
 
+	/* Writing may change any file's cluster chain */
+	fat_extents_invalidate();
+
 	if (read_bootsectandvi(&bs, &volinfo, &mydata->fatsize)) {
 		debug("error: reading boot sector\n");
 		return -1;
@@ -958,10 +944,7 @@ static int do_fat_write(const char *filename, void *buffer, loff_t size,
 					(mydata->clust_size * 2);
 	}
 
-	mydata->fatbufnum = -1;
-	mydata->fat_dirty = 0;
-	mydata->fatbuf = memalign(ARCH_DMA_MINALIGN, FATBUFSIZE);
-	if (mydata->fatbuf == NULL) {
+	if (fat_cache_alloc(mydata) < 0) {
 		debug("Error: allocating memory\n");
 		return -1;
 	}
@@ -1073,7 +1056,7 @@ static int do_fat_write(const char *filename, void *buffer, loff_t size,
 		printf("Error: writing directory entry\n");
 
 exit:
-	free(mydata->fatbuf);
+	fat_cache_free(mydata);
 	return ret;
 }
 
@@ -0,0 +1,71 @@
+/*
+ * Latency and throughput statistics for benchmark commands
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <linux/types.h>
+
+/* Latencies under 2^(BENCH_HIST_BUCKETS - 2) us, about 4s, are bucketed */
+#define BENCH_HIST_BUCKETS	24
+
+/**
+ * struct bench_stats - one operation, timed a number of times
+ *
+ * @count:	operations timed
+ * @bytes:	bytes transferred by all of them
+ * @total_us:	time taken by all of them
+ * @min_us:	quickest operation
+ * @max_us:	slowest operation
+ * @hist:	operations by latency: hist[0] took under 1us, hist[n] took
+ *		2^(n-1) to 2^n - 1 us, and the last bucket anything longer
+ */
+struct bench_stats {
+	ulong count;
+	u64 bytes;
+	ulong total_us;
+	ulong min_us;
+	ulong max_us;
+	ulong hist[BENCH_HIST_BUCKETS];
+};
+
+/**
+ * bench_init() - clear statistics before timing an operation
+ *
+ * @st:		statistics to clear
+ */
+void bench_init(struct bench_stats *st);
+
+/**
+ * bench_add() - add one timed operation
+ *
+ * @st:		statistics to add to
+ * @us:		time taken, e.g. the difference of two timer_get_us()
+ * @bytes:	bytes transferred
+ */
+void bench_add(struct bench_stats *st, ulong us, ulong bytes);
+
+/**
+ * bench_print_header() - print the heading of a table of bench_print() rows
+ */
+void bench_print_header(void);
+
+/**
+ * bench_print() - print a row of results and a line of their histogram
+ *
+ * The row has the operation, its size and alignment, its minimum, average
+ * and maximum latency, and the operations per second and MB/s over all the
+ * timed operations.
+ *
+ * @name:	operation
+ * @size:	bytes per operation
+ * @align:	offset of the operation from an aligned address
+ * @st:		statistics to print
+ */
+void bench_print(const char *name, ulong size, ulong align,
+		 struct bench_stats *st);
+
+#endif
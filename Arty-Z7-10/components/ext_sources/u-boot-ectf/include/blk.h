@@ -69,6 +69,7 @@ struct blk_desc {
 	 * device. Once these functions are removed we can drop this field.
 	 */
 	struct udevice *bdev;
+	struct blk_req *inflight;	/* read started and not yet done */
 #else
 	unsigned long	(*block_read)(struct blk_desc *block_dev,
 				      lbaint_t start,
@@ -174,6 +175,26 @@ static inline void blkcache_invalidate(int iftype, int dev) {}
 
 #endif
 
+/**
+ * struct blk_req - a read started with blk_dread_start()
+ *
+ * @desc:	Device being read
+ * @start:	Start block number
+ * @blkcnt:	Number of blocks
+ * @buffer:	Destination buffer
+ * @ret:	Once done, the number of blocks read or -ve error number, as
+ *		returned by blk_dread()
+ * @busy:	true while the blocks may still be arriving
+ */
+struct blk_req {
+	struct blk_desc *desc;
+	lbaint_t start;
+	lbaint_t blkcnt;
+	void *buffer;
+	ulong ret;
+	bool busy;
+};
+
 #ifdef CONFIG_BLK
 struct udevice;
 
@@ -192,6 +213,31 @@ struct blk_ops {
 	unsigned long (*read)(struct udevice *dev, lbaint_t start,
 			      lbaint_t blkcnt, void *buffer);
 
+	/**
+	 * read_start() - start reading from a block device
+	 *
+	 * This is optional. The blocks need not have arrived when it
+	 * returns: read_poll() is called until they have. The uclass has
+	 * only one read in flight on a device, and does nothing else with
+	 * the device meanwhile.
+	 *
+	 * @dev:	Device to read from
+	 * @req:	Blocks to read
+	 * @return 0 if OK, -ENOSYS if this read can't be done this way (the
+	 * uclass then uses read()), other -ve on error
+	 */
+	int (*read_start)(struct udevice *dev, struct blk_req *req);
+
+	/**
+	 * read_poll() - see whether a started read is done
+	 *
+	 * @dev:	Device being read
+	 * @req:	Read started by read_start()
+	 * @return -EBUSY while the blocks are still arriving, then the
+	 * number of blocks read, or other -ve error number
+	 */
+	long (*read_poll)(struct udevice *dev, struct blk_req *req);
+
 	/**
 	 * write() - write to a block device
 	 *
@@ -252,6 +298,40 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			 lbaint_t blkcnt);
 
+/**
+ * blk_dread_start() - start reading blocks without waiting for them
+ *
+ * Where the device can, the blocks are read in the background, by DMA for
+ * example, so that the caller can get on with something else. Otherwise
+ * they are read before this returns. A device has only one read in flight:
+ * starting another, or any other operation on the device, first waits for
+ * it to be done.
+ *
+ * @block_dev:	Device to read from
+ * @start:	Start block number to read (0=first)
+ * @blkcnt:	Number of blocks to read
+ * @buffer:	Destination buffer, not to be touched until the read is done
+ * @req:	Read to fill in, which must stay valid until it is done
+ */
+void blk_dread_start(struct blk_desc *block_dev, lbaint_t start,
+		     lbaint_t blkcnt, void *buffer, struct blk_req *req);
+
+/**
+ * blk_dread_poll() - see whether a started read is done
+ *
+ * @req:	Read started by blk_dread_start()
+ * @return true if it is, false if the blocks are still arriving
+ */
+bool blk_dread_poll(struct blk_req *req);
+
+/**
+ * blk_dread_wait() - wait for a started read to be done
+ *
+ * @req:	Read started by blk_dread_start()
+ * @return number of blocks read, or -ve error number, as blk_dread()
+ */
+ulong blk_dread_wait(struct blk_req *req);
+
 /**
  * blk_get_device() - Find and probe a block device ready for use
  *
@@ -407,6 +487,29 @@ static inline ulong blk_derase(struct blk_desc *block_dev, lbaint_t start,
 	return block_dev->block_erase(block_dev, start, blkcnt);
 }
 
+/* Without driver model, reads are done when they are started */
+static inline void blk_dread_start(struct blk_desc *block_dev, lbaint_t start,
+				   lbaint_t blkcnt, void *buffer,
+				   struct blk_req *req)
+{
+	req->desc = block_dev;
+	req->start = start;
+	req->blkcnt = blkcnt;
+	req->buffer = buffer;
+	req->ret = blk_dread(block_dev, start, blkcnt, buffer);
+	req->busy = false;
+}
+
+static inline bool blk_dread_poll(struct blk_req *req)
+{
+	return true;
+}
+
+static inline ulong blk_dread_wait(struct blk_req *req)
+{
+	return req->ret;
+}
+
 /**
  * struct blk_driver - Driver for block interface types
  *
@@ -603,4 +706,57 @@ ulong blk_write_devnum(enum if_type if_type, int devnum, lbaint_t start,
  */
 int blk_select_hwpart_devnum(enum if_type if_type, int devnum, int hwpart);
 
+/**
+ * struct blk_bench - a read benchmark of a block device, see blk_bench()
+ *
+ * @desc:	Device to read
+ * @start:	First block of the region read
+ * @count:	Number of blocks in the region
+ * @reps:	Most reads timed of each size, in each pattern
+ * @b_max:	Most blocks the device reads with one command, 0 if not known
+ * @uncached:	Bypass the block cache
+ * @row_start:	If not NULL, called before each size is timed, e.g. to clear
+ *		the device's counters
+ * @row_end:	If not NULL, called after each size is timed and printed, to
+ *		print more about it
+ * @priv:	Private data for @row_start and @row_end
+ */
+struct blk_bench {
+	struct blk_desc *desc;
+	lbaint_t start;
+	lbaint_t count;
+	uint reps;
+	lbaint_t b_max;
+	bool uncached;
+	void (*row_start)(struct blk_bench *bb);
+	void (*row_end)(struct blk_bench *bb);
+	void *priv;
+};
+
+/**
+ * blk_bench_parse() - fill in a benchmark from command arguments
+ *
+ * The arguments are "[-u] start count [reps]", with -u to bypass the block
+ * cache. Everything else in @bb is cleared.
+ *
+ * @bb:		Benchmark to fill in
+ * @argc:	Number of arguments
+ * @argv:	Arguments
+ * @return 0 if OK, -EINVAL if the arguments are not valid
+ */
+int blk_bench_parse(struct blk_bench *bb, int argc, char * const argv[]);
+
+/**
+ * blk_bench() - time reads of a block device
+ *
+ * Reads of 1 block, then of each power of two blocks, and of @bb->b_max and
+ * one block more, are timed one at a time, first sequentially through the
+ * region and then at random places in it. A row of latency, IOPS and MB/s
+ * is printed for each size and pattern.
+ *
+ * @bb:		Benchmark to run
+ * @return 0 if OK, -ve on error or if interrupted
+ */
+int blk_bench(struct blk_bench *bb);
+
 #endif
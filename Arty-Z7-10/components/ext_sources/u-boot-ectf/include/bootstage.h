@@ -198,8 +198,18 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ACCUM_SCSI,
 	BOOTSTAGE_ID_ACCUM_SPI,
 	BOOTSTAGE_ID_ACCUM_DECOMP,
+	BOOTSTAGE_ID_ACCUM_FDTDEC_LOOKUP,
 	BOOTSTAGE_ID_FPGA_INIT,
 
+	/* mesh shell, from entering the loop to handing the game to bootm */
+	BOOTSTAGE_ID_MESH_LOOP,
+	BOOTSTAGE_ID_MESH_PLAY,
+	BOOTSTAGE_ID_MESH_GAME_LOADED,
+	BOOTSTAGE_ID_ACCUM_MESH_TABLE,
+	BOOTSTAGE_ID_ACCUM_MESH_HEADER,
+	BOOTSTAGE_ID_ACCUM_MESH_LOAD,
+	BOOTSTAGE_ID_ACCUM_FIT_VERIFY,
+
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
 	BOOTSTAGE_ID_COUNT = BOOTSTAGE_ID_USER + CONFIG_BOOTSTAGE_USER_COUNT,
@@ -22,6 +22,7 @@
 # define CONFIG_SYS_PL310_BASE		0xf8f02000
 #endif
 
+#define ZYNQ_GTC_BASEADDR		0xF8F00200
 #define ZYNQ_SCUTIMER_BASEADDR		0xF8F00600
 #define CONFIG_SYS_TIMERBASE		ZYNQ_SCUTIMER_BASEADDR
 #define CONFIG_SYS_TIMER_COUNTS_DOWN
@@ -42,6 +42,19 @@ void console_record_reset(void);
  */
 void console_record_reset_enable(void);
 
+/**
+ * console_flush() - write out anything buffered for stdout
+ *
+ * With CONFIG_CONSOLE_BUFFER, output to stdout is held until a newline or
+ * until input is polled for. Call this before a long wait after printing a
+ * partial line, such as a progress indicator.
+ */
+#ifdef CONFIG_CONSOLE_BUFFER
+void console_flush(void);
+#else
+static inline void console_flush(void) {}
+#endif
+
 /*
  * CONSOLE multiplexing.
  */
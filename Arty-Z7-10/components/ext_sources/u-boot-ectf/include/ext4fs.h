@@ -136,6 +136,16 @@ int ext4_write_file(const char *filename, void *buf, loff_t offset, loff_t len,
 struct ext_filesystem *get_fs(void);
 int ext4fs_open(const char *filename, loff_t *len);
 int ext4fs_read(char *buf, loff_t offset, loff_t len, loff_t *actread);
+
+/*
+ * Called by ext4fs_read_stream() with each part of the file as it is read,
+ * in order, while the next part is on its way. Returns 0 to carry on, or
+ * non-zero to stop the read with an error.
+ */
+typedef int (*ext4fs_stream_fn)(void *priv, char *buf, loff_t len);
+
+int ext4fs_read_stream(char *buf, loff_t offset, loff_t len, loff_t *actread,
+		       ext4fs_stream_fn fn, void *priv);
 int ext4fs_mount(unsigned part_length);
 void ext4fs_close(void);
 void ext4fs_reinit_global(void);
@@ -144,6 +154,9 @@ int ext4fs_exists(const char *filename);
 int ext4fs_size(const char *filename, loff_t *size);
 void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot);
 int ext4fs_devread(lbaint_t sector, int byte_offset, int byte_len, char *buf);
+int ext4fs_devread_start(lbaint_t sector, int byte_offset, int byte_len,
+			 char *buf, struct blk_req *req);
+int ext4fs_devread_wait(struct blk_req *req);
 void ext4fs_set_blk_dev(struct blk_desc *rbdd, disk_partition_t *info);
 long int read_allocated_block(struct ext2_inode *inode, int fileblock);
 int ext4fs_probe(struct blk_desc *fs_dev_desc,
@@ -33,6 +33,16 @@
 #define FAT16BUFSIZE	(FATBUFSIZE/2)
 #define FAT32BUFSIZE	(FATBUFSIZE/4)
 
+/* Number of FATBUFSIZE windows of the FAT kept in memory */
+#ifdef CONFIG_SPL_BUILD
+#define FATBUFWINDOWS	1
+#else
+#define FATBUFWINDOWS	4
+#endif
+
+/* Runs of contiguous clusters remembered for the last file read */
+#define FAT_MAX_EXTENTS	128
+
 /* Maximum number of entry for long file name according to spec */
 #define MAX_LFN_SLOT	20
 
@@ -177,6 +187,10 @@ typedef struct {
 	__u16	clust_size;	/* Size of clusters in sectors */
 	int	data_begin;	/* The sector of the first cluster, can be negative */
 	int	fatbufnum;	/* Used by get_fatent, init to -1 */
+	__u8	*fatcache;	/* FATBUFWINDOWS buffers, fatbuf is one of them */
+	int	fatcachenum[FATBUFWINDOWS];	/* fatbufnum of each, or -1 */
+	__u32	fatcacheused[FATBUFWINDOWS];	/* For LRU replacement */
+	__u32	fatcacheclock;
 } fsdata;
 
 typedef int	(file_detectfs_func)(void);
@@ -642,6 +642,89 @@ int fdtdec_get_chosen_node(const void *blob, const char *name);
  */
 const char *fdtdec_get_compatible(enum fdt_compat_id id);
 
+/**
+ * fdtdec_path_offset() - Find a node by path, using the index if built
+ *
+ * This behaves like fdt_path_offset(), but is answered from the index of
+ * the control FDT (see fdtdec_index_build()) where possible. The time spent
+ * in this and the other fdtdec_..._offset() lookups is accumulated under the
+ * "fdtdec_lookup" bootstage record. Callers of libfdt's own fdt_...()
+ * functions, such as drivers and fdt_support, are not counted there.
+ *
+ * @param blob		FDT blob
+ * @param path		Full path of the node, or an alias
+ * @return node offset if found, -ve FDT_ERR_... on error
+ */
+int fdtdec_path_offset(const void *blob, const char *path);
+
+/**
+ * fdtdec_node_offset_by_phandle() - Find a node by phandle, using the index
+ *
+ * This behaves like fdt_node_offset_by_phandle(), see fdtdec_path_offset().
+ *
+ * @param blob		FDT blob
+ * @param phandle	phandle value
+ * @return node offset if found, -ve FDT_ERR_... on error
+ */
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle);
+
+/**
+ * fdtdec_node_offset_by_compatible() - Find the next compatible node
+ *
+ * This behaves like fdt_node_offset_by_compatible(), see
+ * fdtdec_path_offset().
+ *
+ * @param blob		FDT blob
+ * @param startoffset	Only find nodes after this offset, -1 to start at the
+ *			beginning
+ * @param compat	Compatible string to match
+ * @return node offset if found, -ve FDT_ERR_... on error
+ */
+int fdtdec_node_offset_by_compatible(const void *blob, int startoffset,
+				     const char *compat);
+
+/**
+ * fdtdec_index_build() - Index a device tree for faster lookups
+ *
+ * Walk the tree once and build hash tables from path, phandle and
+ * compatible string to node offset, used by fdtdec_path_offset() and
+ * friends. It is built for the control FDT once driver model starts. Any
+ * previous index is freed. Whatever writes to the tree afterwards must call
+ * fdtdec_index_changed().
+ *
+ * @param blob		FDT blob to index
+ * @return 0 if OK, -EINVAL if the tree cannot be indexed, -ENOMEM if out of
+ * memory
+ */
+int fdtdec_index_build(const void *blob);
+
+/**
+ * fdtdec_index_free() - Free the index built by fdtdec_index_build()
+ */
+void fdtdec_index_free(void);
+
+/**
+ * fdtdec_index_changed() - Tell the index that a device tree was written to
+ *
+ * If @blob is the indexed tree, the index is built again, so that it does
+ * not answer with offsets from before the change. A write that changes the
+ * size of the tree's structure or strings is caught without this, but one
+ * that only changes a value in place, such as a phandle, is not.
+ *
+ * @param blob		FDT blob that was changed
+ */
+void fdtdec_index_changed(const void *blob);
+
+/*
+ * Look up a node in the index. These return true with the result in
+ * *offsetp if the index can answer for @blob, else false and the caller
+ * must ask libfdt instead.
+ */
+bool fdtdec_index_path(const void *blob, const char *path, int *offsetp);
+bool fdtdec_index_phandle(const void *blob, uint32_t phandle, int *offsetp);
+bool fdtdec_index_compatible(const void *blob, int startoffset,
+			     const char *compat, int *offsetp);
+
 /* Look up a phandle and follow it to its node. Then return the offset
  * of that node.
  *
@@ -0,0 +1,100 @@
+/*
+ * Streaming hex and base64 dumps
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __HEXDUMP_H
+#define __HEXDUMP_H
+
+#include <linux/types.h>
+
+#define HEXDUMP_LINE_BYTES	16	/* bytes per line of a hex dump */
+#define HEXDUMP_MAX_LINE_BYTES	64	/* the most print_buffer() allows */
+#define HEXDUMP_B64_LINE_BYTES	57	/* 76 characters of base64 */
+
+/* Longest line hexdump_format_line() writes, with its newline and NUL */
+#define HEXDUMP_MAX_LINE_LEN	(2 * sizeof(ulong) + 1 + \
+				 HEXDUMP_MAX_LINE_BYTES * 3 + 4 + \
+				 HEXDUMP_MAX_LINE_BYTES + 2)
+
+enum hexdump_mode {
+	HEXDUMP_HEX,		/* address, hex words and ASCII */
+	HEXDUMP_BASE64,		/* base64 lines, then the length and CRC32 */
+};
+
+/**
+ * struct hexdump - state of a dump being fed a block at a time
+ *
+ * @mode:	what to print
+ * @addr:	address printed at the start of the next hex line
+ * @width:	bytes per word in a hex line, 1, 2, 4 or 8
+ * @len:	bytes held in @line, less than a whole line
+ * @total:	bytes dumped so far
+ * @crc:	CRC32 of the bytes dumped so far
+ * @line:	bytes waiting for the rest of their line
+ */
+struct hexdump {
+	enum hexdump_mode mode;
+	ulong addr;
+	uint width;
+	uint len;
+	ulong total;
+	u32 crc;
+	u8 line[HEXDUMP_B64_LINE_BYTES] __aligned(8);
+};
+
+/**
+ * hexdump_format_line() - format one line of a hex dump
+ *
+ * Writes "<addr>: <word> <word> ...    <ascii>\n" into @buf, padding a short
+ * line so that the ASCII column lines up. Words are printed as the CPU
+ * reads them from @data, which must be aligned to @width.
+ *
+ * @buf:	buffer of at least HEXDUMP_MAX_LINE_LEN bytes
+ * @addr:	address to print at the start of the line
+ * @data:	the words to print
+ * @width:	bytes per word, 1, 2, 4 or 8
+ * @count:	number of words to print
+ * @linelen:	number of words in a full line, at least @count
+ * @return length of the line written, not counting the NUL
+ */
+int hexdump_format_line(char *buf, ulong addr, const void *data, uint width,
+			uint count, uint linelen);
+
+/**
+ * hexdump_start() - start a streaming dump
+ *
+ * @hd:		dump state to set up
+ * @mode:	what to print
+ * @addr:	address to print for the first byte in hex mode
+ * @width:	bytes per word in hex mode, 1, 2, 4 or 8
+ */
+void hexdump_start(struct hexdump *hd, enum hexdump_mode mode, ulong addr,
+		   uint width);
+
+/**
+ * hexdump_write() - dump the next block of data
+ *
+ * Each whole line is formatted into a line buffer and written to the
+ * console in one go; a partial line is held until more data arrives or
+ * the dump finishes. @data needs no alignment.
+ *
+ * @hd:		dump state
+ * @data:	bytes to dump
+ * @len:	number of bytes
+ * @return 0 if OK, -EINTR if Ctrl-C was pressed
+ */
+int hexdump_write(struct hexdump *hd, const void *data, size_t len);
+
+/**
+ * hexdump_finish() - print any partial line and, for base64, the trailer
+ *
+ * The base64 trailer is a line "length <bytes> crc32 <crc>" so that a
+ * capture on the host can be checked.
+ *
+ * @hd:		dump state
+ */
+void hexdump_finish(struct hexdump *hd);
+
+#endif
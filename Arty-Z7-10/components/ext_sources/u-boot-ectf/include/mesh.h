@@ -21,6 +21,7 @@
 // To erase (or call update) on flash, it needs to be done
 // on boundaries of size 64K
 #define FLASH_PAGE_SIZE 65536
+#define MESH_DUMP_CHUNK 4096
 
 typedef struct {
     char name[MAX_USERNAME_LENGTH + 1];
@@ -90,6 +91,16 @@ int mesh_dump_flash(char **args);
 int mesh_reset_flash(char **args);
 int mesh_login(User *user) ;
 void mesh_loop(void);
+int mesh_fdt_fixup(void *blob);
+
+/*
+ * Mesh arena, for the short-lived allocations of a command
+ */
+void *mesh_arena_alloc(size_t size);
+void *mesh_arena_zalloc(size_t size);
+size_t mesh_arena_mark(void);
+void mesh_arena_release(size_t mark);
+void mesh_arena_reset(const char *cmd);
 
 /*
  * Mesh flash commands
@@ -0,0 +1,56 @@
+#ifndef __MESH_HANDOFF_H__
+#define __MESH_HANDOFF_H__
+
+#include <linux/types.h>
+
+/*
+    Descriptor that mesh_play writes at the start of the reserved game region
+    (CONFIG_MESH_GAME_REGION_ADDR) to hand the game over to mesh-game-loader
+    in Linux. The game file, header lines included, is stored as a stream
+    split across the segments in order. The payload is the part of that
+    stream the loader turns into the game binary.
+
+    mesh-game-loader has its own copy of this layout in handoff.h; bump
+    MESH_HANDOFF_VERSION whenever it changes. All fields are little endian.
+*/
+#define MESH_HANDOFF_MAGIC 0x4d475631 /* "MGV1" */
+#define MESH_HANDOFF_VERSION 2
+
+// the descriptor gets a page to itself, the segments start after it
+#define MESH_HANDOFF_SIZE 0x1000
+
+#define MESH_HANDOFF_MAX_SEGMENTS 8
+
+// how the payload is stored
+#define MESH_HANDOFF_COMP_NONE 0
+#define MESH_HANDOFF_COMP_GZIP 1
+#define MESH_HANDOFF_COMP_LZ4 2
+
+/*
+    A game provisioned with a compressed payload has a fourth header line,
+    "compression:<gzip|lz4> <uncompressed size>". The header is never longer
+    than this.
+*/
+#define MESH_GAME_HEADER_MAX 512
+
+struct mesh_handoff_segment {
+    u32 addr;           // physical address, page aligned
+    u32 len;            // bytes of the stream in this segment
+};
+
+struct mesh_handoff {
+    u32 magic;
+    u16 version;
+    u16 desc_len;       // sizeof(struct mesh_handoff)
+    u32 stream_len;     // bytes stored across all segments
+    u32 header_len;     // length of the text header lines of the game
+    u32 payload_offset; // offset of the payload in the stream
+    u32 payload_len;    // bytes of payload as stored
+    u32 compression;    // MESH_HANDOFF_COMP_*
+    u32 uncompressed_len; // bytes of payload once decompressed
+    u32 payload_crc32;  // crc32 of the payload as stored
+    u32 num_segments;
+    struct mesh_handoff_segment segments[MESH_HANDOFF_MAX_SEGMENTS];
+};
+
+#endif
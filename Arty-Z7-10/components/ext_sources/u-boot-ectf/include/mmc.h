@@ -65,11 +65,13 @@
 #define MMC_MODE_UHS_DDR50	(1 << 10)
 #define MMC_MODE_NEEDS_TUNING	(1 << 11)
 #define MMC_MODE_HS200		(1 << 12)
+#define MMC_MODE_CMD23		(1 << 13)	/* SET_BLOCK_COUNT for reads */
 
 #define MMC_MODE_UHS	(MMC_MODE_UHS_SDR12 | MMC_MODE_UHS_SDR25 |	\
 			 MMC_MODE_UHS_SDR50 | MMC_MODE_UHS_SDR104 |	\
 			 MMC_MODE_UHS_DDR50)
 #define SD_DATA_4BIT	0x00040000
+#define SD_SCR_CMD23_SUPPORT	0x00000002
 
 #define IS_SD(x)	((x)->version & SD_VERSION_SD)
 #define IS_MMC(x)	((x)->version & MMC_VERSION_MMC)
@@ -373,6 +375,32 @@ struct dm_mmc_ops {
 	int (*send_cmd)(struct udevice *dev, struct mmc_cmd *cmd,
 			struct mmc_data *data);
 
+	/**
+	 * send_cmd_start() - Send a read command without waiting for its data
+	 *
+	 * The command has had its response when this returns, but its data
+	 * may still be arriving, typically by DMA. send_cmd_poll() is called
+	 * until it has all arrived; no other command is sent meanwhile.
+	 *
+	 * @dev:	Device to receive the command
+	 * @cmd:	Command to send
+	 * @data:	Data to receive, which must stay valid until it is in
+	 * @return 0 if OK, -ENOSYS if this transfer can't be done this way
+	 * (send_cmd() is used instead), other -ve on error
+	 */
+	int (*send_cmd_start)(struct udevice *dev, struct mmc_cmd *cmd,
+			      struct mmc_data *data);
+
+	/**
+	 * send_cmd_poll() - See whether the data of a started command is in
+	 *
+	 * @dev:	Device the command was sent to
+	 * @data:	Data being received
+	 * @return 0 once it has all arrived, -EBUSY until then, other -ve on
+	 * error
+	 */
+	int (*send_cmd_poll)(struct udevice *dev, struct mmc_data *data);
+
 	/**
 	 * set_ios() - Set the I/O speed/width for an MMC device
 	 *
@@ -427,6 +455,9 @@ struct dm_mmc_ops {
 
 int dm_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		    struct mmc_data *data);
+int dm_mmc_send_cmd_start(struct udevice *dev, struct mmc_cmd *cmd,
+			  struct mmc_data *data);
+int dm_mmc_send_cmd_poll(struct udevice *dev, struct mmc_data *data);
 int dm_mmc_set_ios(struct udevice *dev);
 int dm_mmc_get_cd(struct udevice *dev);
 int dm_mmc_get_wp(struct udevice *dev);
@@ -468,6 +499,32 @@ struct mmc_config {
 	unsigned char part_type;
 };
 
+/*
+ * Counts of the commands block reads take, to see what a read costs. The
+ * CMD16 counts include those for writes. A host that stops multi-block
+ * transfers with Auto-CMD12 counts a CMD12 here without sending it.
+ */
+struct mmc_stats {
+	ulong reads;		/* mmc_bread() and mmc_bread_start() calls */
+	ulong blocks;		/* blocks read */
+	ulong read_cmds;	/* CMD17 and CMD18 */
+	ulong set_block_count;	/* CMD23 */
+	ulong stop;		/* CMD12 */
+	ulong set_blocklen;	/* CMD16 */
+	ulong blocklen_cached;	/* CMD16s not sent, the length being set */
+};
+
+/* A read started by mmc_bread_start(), sent a command at a time */
+struct mmc_async_read {
+	struct mmc_data data;	/* data of the command in flight */
+	bool busy;		/* that data is still arriving */
+	bool set_count;		/* the command followed a CMD23 */
+	char *dst;		/* where the next command reads to */
+	lbaint_t start;		/* first block of the next command */
+	lbaint_t todo;		/* blocks not yet asked for */
+	lbaint_t b_max;		/* most blocks per command */
+};
+
 struct sd_ssr {
 	unsigned int au;		/* In sectors */
 	unsigned int erase_timeout;	/* In milliseconds */
@@ -506,6 +563,7 @@ struct mmc {
 	uint tran_speed;
 	uint read_bl_len;
 	uint write_bl_len;
+	uint blocklen;		/* last set with CMD16, 0 if not known */
 	uint erase_grp_size;	/* in 512-byte sectors */
 	uint hc_wp_grp_size;	/* in 512-byte sectors */
 	struct sd_ssr	ssr;	/* SD status register */
@@ -529,6 +587,8 @@ struct mmc {
 	u8 is_uhs;
 	u8 uhsmode;
 	u8 forcehs;
+	struct mmc_stats stats;
+	struct mmc_async_read async;
 };
 
 struct mmc_hwpart_conf {
@@ -229,6 +229,14 @@ int usb_eth_initialize(bd_t *bi);
 #endif
 
 int eth_initialize(void);		/* Initialize network subsystem */
+#ifdef CONFIG_NET_LAZY_INIT
+int eth_lazy_initialize(void);		/* eth_initialize() on first use */
+#else
+static inline int eth_lazy_initialize(void)
+{
+	return 0;
+}
+#endif
 void eth_try_another(int first_restart);	/* Change the device */
 void eth_set_current(void);		/* set nterface to ethcur var */
 
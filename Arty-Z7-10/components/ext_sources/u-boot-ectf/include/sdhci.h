@@ -277,6 +277,13 @@ struct sdhci_host {
 
 	struct mmc_config cfg;
 	unsigned int last_cmd;
+
+	/* Data transfer of the command in progress */
+	bool dma;			/* by SDMA rather than PIO */
+	bool dma_bounce;		/* through aligned_buffer */
+	unsigned int dma_addr;		/* where the SDMA engine is writing */
+	unsigned int trans_bytes;	/* rounded up to a cache line for DMA */
+	ulong data_start;		/* timer when a polled transfer began */
 };
 
 #ifdef CONFIG_MMC_SDHCI_IO_ACCESSORS
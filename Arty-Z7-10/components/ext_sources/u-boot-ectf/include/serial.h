@@ -116,6 +116,24 @@ struct dm_serial_ops {
 	 * @return 0 if OK, -ve on error
 	 */
 	int (*putc)(struct udevice *dev, const char ch);
+	/**
+	 * puts() - Write as much of a string as the device can take now
+	 *
+	 * This lets a device with a FIFO be filled in one call rather than a
+	 * call per character. The string contains no '\n' for the uclass to
+	 * expand to "\r\n"; it does that itself.
+	 *
+	 * If no character can be written, this should return -EAGAIN without
+	 * waiting.
+	 *
+	 * This method is optional.
+	 *
+	 * @dev: Device pointer
+	 * @s: characters to write
+	 * @len: number of characters, at least 1
+	 * @return number of characters written, -ve on error
+	 */
+	int (*puts)(struct udevice *dev, const char *s, int len);
 	/**
 	 * pending() - Check if input/output characters are waiting
 	 *
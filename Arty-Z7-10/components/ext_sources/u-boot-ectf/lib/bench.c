@@ -0,0 +1,74 @@
+/*
+ * Latency and throughput statistics for benchmark commands
+ *
+ * Each operation is timed on its own, so that a table shows the spread of
+ * latencies as well as the throughput. The output depends only on the
+ * measurements, so that runs on different boards, or on sandbox, can be
+ * compared line by line.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <bench.h>
+#include <div64.h>
+#include <linux/bitops.h>
+
+void bench_init(struct bench_stats *st)
+{
+	memset(st, '\0', sizeof(*st));
+	st->min_us = ~0UL;
+}
+
+void bench_add(struct bench_stats *st, ulong us, ulong bytes)
+{
+	int bucket = us ? fls(us) : 0;
+
+	st->count++;
+	st->bytes += bytes;
+	st->total_us += us;
+	st->min_us = min(st->min_us, us);
+	st->max_us = max(st->max_us, us);
+	st->hist[min(bucket, BENCH_HIST_BUCKETS - 1)]++;
+}
+
+void bench_print_header(void)
+{
+	printf("%-10s %8s %5s %9s %9s %9s %9s %9s\n", "op", "bytes", "align",
+	       "min us", "avg us", "max us", "IOPS", "MB/s");
+}
+
+void bench_print(const char *name, ulong size, ulong align,
+		 struct bench_stats *st)
+{
+	ulong total_us = max(st->total_us, 1UL);
+	u64 tenths;
+	uint rem;
+	int i;
+
+	if (!st->count) {
+		printf("%-10s %8lu %5lu   not run\n", name, size, align);
+		return;
+	}
+
+	/* bytes per microsecond is MB/s */
+	tenths = lldiv(st->bytes * 10, total_us);
+	rem = do_div(tenths, 10);
+	printf("%-10s %8lu %5lu %9lu %9lu %9lu %9llu %7llu.%u\n", name, size,
+	       align, st->min_us, st->total_us / st->count, st->max_us,
+	       lldiv((u64)st->count * 1000000, total_us), tenths, rem);
+
+	printf("%10s us:", "");
+	for (i = 0; i < BENCH_HIST_BUCKETS; i++) {
+		if (!st->hist[i])
+			continue;
+		if (!i)
+			printf(" 0:%lu", st->hist[i]);
+		else if (i == BENCH_HIST_BUCKETS - 1)
+			printf(" >=%lu:%lu", 1UL << (i - 1), st->hist[i]);
+		else
+			printf(" %lu-%lu:%lu", 1UL << (i - 1), (1UL << i) - 1,
+			       st->hist[i]);
+	}
+	printf("\n");
+}
@@ -8,6 +8,7 @@
 #include <common.h>
 #include <console.h>
 #include <div64.h>
+#include <hexdump.h>
 #include <inttypes.h>
 #include <version.h>
 #include <linux/ctype.h>
@@ -104,26 +105,22 @@ void print_size(uint64_t size, const char *s)
 	printf (" %ciB%s", c, s);
 }
 
-#define MAX_LINE_LENGTH_BYTES (64)
-#define DEFAULT_LINE_LENGTH_BYTES (16)
+#define MAX_LINE_LENGTH_BYTES HEXDUMP_MAX_LINE_BYTES
+#define DEFAULT_LINE_LENGTH_BYTES HEXDUMP_LINE_BYTES
 int print_buffer(ulong addr, const void *data, uint width, uint count,
 		 uint linelen)
 {
 	/* linebuf as a union causes proper alignment */
 	union linebuf {
 #ifdef CONFIG_SYS_SUPPORT_64BIT_DATA
-		uint64_t uq[MAX_LINE_LENGTH_BYTES/sizeof(uint64_t) + 1];
+		uint64_t uq[MAX_LINE_LENGTH_BYTES/sizeof(uint64_t)];
 #endif
-		uint32_t ui[MAX_LINE_LENGTH_BYTES/sizeof(uint32_t) + 1];
-		uint16_t us[MAX_LINE_LENGTH_BYTES/sizeof(uint16_t) + 1];
-		uint8_t  uc[MAX_LINE_LENGTH_BYTES/sizeof(uint8_t) + 1];
+		uint32_t ui[MAX_LINE_LENGTH_BYTES/sizeof(uint32_t)];
+		uint16_t us[MAX_LINE_LENGTH_BYTES/sizeof(uint16_t)];
+		uint8_t  uc[MAX_LINE_LENGTH_BYTES/sizeof(uint8_t)];
 	} lb;
+	char line[HEXDUMP_MAX_LINE_LEN];
 	int i;
-#ifdef CONFIG_SYS_SUPPORT_64BIT_DATA
-	uint64_t __maybe_unused x;
-#else
-	uint32_t __maybe_unused x;
-#endif
 
 	if (linelen*width > MAX_LINE_LENGTH_BYTES)
 		linelen = MAX_LINE_LENGTH_BYTES / width;
@@ -132,46 +129,30 @@ int print_buffer(ulong addr, const void *data, uint width, uint count,
 
 	while (count) {
 		uint thislinelen = linelen;
-		printf("%08lx:", addr);
 
 		/* check for overflow condition */
 		if (count < thislinelen)
 			thislinelen = count;
 
-		/* Copy from memory into linebuf and print hex values */
+		/* Copy from memory into linebuf, reading each item once */
 		for (i = 0; i < thislinelen; i++) {
 			if (width == 4)
-				x = lb.ui[i] = *(volatile uint32_t *)data;
+				lb.ui[i] = *(volatile uint32_t *)data;
 #ifdef CONFIG_SYS_SUPPORT_64BIT_DATA
 			else if (width == 8)
-				x = lb.uq[i] = *(volatile uint64_t *)data;
+				lb.uq[i] = *(volatile uint64_t *)data;
 #endif
 			else if (width == 2)
-				x = lb.us[i] = *(volatile uint16_t *)data;
+				lb.us[i] = *(volatile uint16_t *)data;
 			else
-				x = lb.uc[i] = *(volatile uint8_t *)data;
-#ifdef CONFIG_SYS_SUPPORT_64BIT_DATA
-			printf(" %0*llx", width * 2, (long long)x);
-#else
-			printf(" %0*x", width * 2, x);
-#endif
+				lb.uc[i] = *(volatile uint8_t *)data;
 			data += width;
 		}
 
-		while (thislinelen < linelen) {
-			/* fill line with whitespace for nice ASCII print */
-			for (i=0; i<width*2+1; i++)
-				puts(" ");
-			linelen--;
-		}
-
-		/* Print data in ASCII characters */
-		for (i = 0; i < thislinelen * width; i++) {
-			if (!isprint(lb.uc[i]) || lb.uc[i] >= 0x80)
-				lb.uc[i] = '.';
-		}
-		lb.uc[i] = '\0';
-		printf("    %s\n", lb.uc);
+		/* Format the whole line, hex and ASCII, and print it at once */
+		hexdump_format_line(line, addr, &lb, width, thislinelen,
+				    linelen);
+		puts(line);
 
 		/* update references */
 		addr += thislinelen * width;
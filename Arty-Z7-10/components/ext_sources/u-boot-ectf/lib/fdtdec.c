@@ -342,10 +342,54 @@ enum fdt_compat_id fdtdec_lookup(const void *blob, int node)
 	return COMPAT_UNKNOWN;
 }
 
+int fdtdec_path_offset(const void *blob, const char *path)
+{
+	int node;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_FDTDEC_LOOKUP, "fdtdec_lookup");
+#if CONFIG_IS_ENABLED(OF_INDEX)
+	if (!fdtdec_index_path(blob, path, &node))
+#endif
+		node = fdt_path_offset(blob, path);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_FDTDEC_LOOKUP);
+
+	return node;
+}
+
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle)
+{
+	int node;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_FDTDEC_LOOKUP, "fdtdec_lookup");
+#if CONFIG_IS_ENABLED(OF_INDEX)
+	if (!fdtdec_index_phandle(blob, phandle, &node))
+#endif
+		node = fdt_node_offset_by_phandle(blob, phandle);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_FDTDEC_LOOKUP);
+
+	return node;
+}
+
+int fdtdec_node_offset_by_compatible(const void *blob, int startoffset,
+				     const char *compat)
+{
+	int node;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_FDTDEC_LOOKUP, "fdtdec_lookup");
+#if CONFIG_IS_ENABLED(OF_INDEX)
+	if (!fdtdec_index_compatible(blob, startoffset, compat, &node))
+#endif
+		node = fdt_node_offset_by_compatible(blob, startoffset,
+						     compat);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_FDTDEC_LOOKUP);
+
+	return node;
+}
+
 int fdtdec_next_compatible(const void *blob, int node,
 		enum fdt_compat_id id)
 {
-	return fdt_node_offset_by_compatible(blob, node, compat_names[id]);
+	return fdtdec_node_offset_by_compatible(blob, node, compat_names[id]);
 }
 
 int fdtdec_next_compatible_subnode(const void *blob, int node,
@@ -373,7 +417,7 @@ int fdtdec_next_alias(const void *blob, const char *name,
 	/* snprintf() is not available */
 	assert(strlen(name) < MAX_STR_LEN);
 	sprintf(str, "%.*s%d", MAX_STR_LEN, name, *upto);
-	node = fdt_path_offset(blob, str);
+	node = fdtdec_path_offset(blob, str);
 	if (node < 0)
 		return node;
 	err = fdt_node_check_compatible(blob, node, compat_names[id]);
@@ -406,7 +450,7 @@ int fdtdec_add_aliases_for_id(const void *blob, const char *name,
 	int i, j;
 
 	/* find the alias node if present */
-	alias_node = fdt_path_offset(blob, "/aliases");
+	alias_node = fdtdec_path_offset(blob, "/aliases");
 
 	/*
 	 * start with nothing, and we can assume that the root node can't
@@ -437,7 +481,7 @@ int fdtdec_add_aliases_for_id(const void *blob, const char *name,
 		prop = fdt_get_property_by_offset(blob, offset, NULL);
 		path = fdt_string(blob, fdt32_to_cpu(prop->nameoff));
 		if (prop->len && 0 == strncmp(path, name, name_len))
-			node = fdt_path_offset(blob, prop->data);
+			node = fdtdec_path_offset(blob, prop->data);
 		if (node <= 0)
 			continue;
 
@@ -520,7 +564,7 @@ int fdtdec_get_alias_seq(const void *blob, const char *base, int offset,
 	find_name = fdt_get_name(blob, offset, &find_namelen);
 	debug("Looking for '%s' at %d, name %s\n", base, offset, find_name);
 
-	aliases = fdt_path_offset(blob, "/aliases");
+	aliases = fdtdec_path_offset(blob, "/aliases");
 	for (prop_offset = fdt_first_property_offset(blob, aliases);
 	     prop_offset > 0;
 	     prop_offset = fdt_next_property_offset(blob, prop_offset)) {
@@ -556,7 +600,7 @@ const char *fdtdec_get_chosen_prop(const void *blob, const char *name)
 
 	if (!blob)
 		return NULL;
-	chosen_node = fdt_path_offset(blob, "/chosen");
+	chosen_node = fdtdec_path_offset(blob, "/chosen");
 	return fdt_getprop(blob, chosen_node, name, NULL);
 }
 
@@ -567,7 +611,7 @@ int fdtdec_get_chosen_node(const void *blob, const char *name)
 	prop = fdtdec_get_chosen_prop(blob, name);
 	if (!prop)
 		return -FDT_ERR_NOTFOUND;
-	return fdt_path_offset(blob, prop);
+	return fdtdec_path_offset(blob, prop);
 }
 
 int fdtdec_check_fdt(void)
@@ -618,7 +662,7 @@ int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 	if (!phandle)
 		return -FDT_ERR_NOTFOUND;
 
-	lookup = fdt_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
+	lookup = fdtdec_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
 	return lookup;
 }
 
@@ -746,8 +790,8 @@ int fdtdec_parse_phandle_with_args(const void *blob, int src_node,
 			 * below.
 			 */
 			if (cells_name || cur_index == index) {
-				node = fdt_node_offset_by_phandle(blob,
-								  phandle);
+				node = fdtdec_node_offset_by_phandle(blob,
+								     phandle);
 				if (!node) {
 					debug("%s: could not find phandle\n",
 					      fdt_get_name(blob, src_node,
@@ -872,7 +916,7 @@ int fdtdec_get_config_int(const void *blob, const char *prop_name,
 	int config_node;
 
 	debug("%s: %s\n", __func__, prop_name);
-	config_node = fdt_path_offset(blob, "/config");
+	config_node = fdtdec_path_offset(blob, "/config");
 	if (config_node < 0)
 		return default_val;
 	return fdtdec_get_int(blob, config_node, prop_name, default_val);
@@ -884,7 +928,7 @@ int fdtdec_get_config_bool(const void *blob, const char *prop_name)
 	const void *prop;
 
 	debug("%s: %s\n", __func__, prop_name);
-	config_node = fdt_path_offset(blob, "/config");
+	config_node = fdtdec_path_offset(blob, "/config");
 	if (config_node < 0)
 		return 0;
 	prop = fdt_get_property(blob, config_node, prop_name, NULL);
@@ -899,7 +943,7 @@ char *fdtdec_get_config_string(const void *blob, const char *prop_name)
 	int len;
 
 	debug("%s: %s\n", __func__, prop_name);
-	nodeoffset = fdt_path_offset(blob, "/config");
+	nodeoffset = fdtdec_path_offset(blob, "/config");
 	if (nodeoffset < 0)
 		return NULL;
 
@@ -1032,7 +1076,7 @@ int fdtdec_decode_memory_region(const void *blob, int config_node,
 	int node;
 
 	if (config_node == -1) {
-		config_node = fdt_path_offset(blob, "/config");
+		config_node = fdtdec_path_offset(blob, "/config");
 		if (config_node < 0) {
 			debug("%s: Cannot find /config node\n", __func__);
 			return -ENOENT;
@@ -1050,7 +1094,7 @@ int fdtdec_decode_memory_region(const void *blob, int config_node,
 		mem = "/memory";
 	}
 
-	node = fdt_path_offset(blob, mem);
+	node = fdtdec_path_offset(blob, mem);
 	if (node < 0) {
 		debug("%s: Failed to find node '%s': %s\n", __func__, mem,
 		      fdt_strerror(node));
@@ -1179,7 +1223,7 @@ int fdtdec_setup_memory_size(void)
 	int ret, mem;
 	struct fdt_resource res;
 
-	mem = fdt_path_offset(gd->fdt_blob, "/memory");
+	mem = fdtdec_path_offset(gd->fdt_blob, "/memory");
 	if (mem < 0) {
 		debug("%s: Missing /memory node\n", __func__);
 		return -EINVAL;
@@ -1204,7 +1248,7 @@ int fdtdec_setup_memory_banksize(void)
 	int bank, ret, mem;
 	struct fdt_resource res;
 
-	mem = fdt_path_offset(gd->fdt_blob, "/memory");
+	mem = fdtdec_path_offset(gd->fdt_blob, "/memory");
 	if (mem < 0) {
 		debug("%s: Missing /memory node\n", __func__);
 		return -EINVAL;
@@ -0,0 +1,388 @@
+/*
+ * Index of the control FDT, for lookups by path, phandle and compatible
+ *
+ * libfdt answers these by walking the flattened tree from the start each
+ * time. Once driver model is running the control FDT rarely changes, so
+ * walk it once and keep hash tables of the results. Lookups that the index
+ * cannot answer exactly as libfdt would return false, and the caller falls
+ * back to libfdt.
+ *
+ * Code that writes to the indexed tree calls fdtdec_index_changed(). A
+ * write that moves nodes or strings also changes the sizes in the header,
+ * which are checked on every lookup, so a tree changed behind the index's
+ * back is not trusted either.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <fdtdec.h>
+#include <libfdt.h>
+#include <malloc.h>
+
+#define FDT_INDEX_PATH_MAX	256
+
+struct fdt_index_path {
+	const char *path;	/* Not NUL-terminated at @len if unit-stripped */
+	int len;
+	int offset;
+};
+
+struct fdt_index_phandle {
+	uint32_t phandle;	/* 0 if this slot is empty */
+	int offset;
+};
+
+struct fdt_index_compat {
+	const char *compat;	/* Points into the blob, NULL if slot is empty */
+	int head;		/* First entry in links[], in document order */
+	int tail;
+};
+
+struct fdt_index_link {
+	int offset;
+	int next;		/* Next entry in links[], or -1 */
+};
+
+struct fdt_index {
+	const void *blob;
+	uint32_t totalsize;	/* Header sizes of @blob when it was indexed */
+	uint32_t size_dt_struct;
+	uint32_t size_dt_strings;
+	uint mask;		/* All tables have mask + 1 slots */
+	struct fdt_index_path *paths;
+	struct fdt_index_phandle *phandles;
+	struct fdt_index_compat *compats;
+	struct fdt_index_link *links;
+	int num_links;
+	char *pool;		/* Node paths, NUL-separated */
+};
+
+static struct fdt_index idx;
+
+/* FNV-1a, over @len bytes */
+static uint32_t fdt_index_hash(const char *str, int len)
+{
+	uint32_t hash = 2166136261u;
+
+	while (len--) {
+		hash ^= (uint8_t)*str++;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static void fdt_index_add_path(const char *path, int len, int offset)
+{
+	uint slot = fdt_index_hash(path, len) & idx.mask;
+	struct fdt_index_path *ent;
+
+	/* Keep the first node in document order, as libfdt would find it */
+	for (ent = &idx.paths[slot]; ent->path;
+	     slot = (slot + 1) & idx.mask, ent = &idx.paths[slot]) {
+		if (ent->len == len && !memcmp(ent->path, path, len))
+			return;
+	}
+	ent->path = path;
+	ent->len = len;
+	ent->offset = offset;
+}
+
+static void fdt_index_add_phandle(uint32_t phandle, int offset)
+{
+	uint slot = phandle & idx.mask;
+	struct fdt_index_phandle *ent;
+
+	for (ent = &idx.phandles[slot]; ent->phandle;
+	     slot = (slot + 1) & idx.mask, ent = &idx.phandles[slot]) {
+		if (ent->phandle == phandle)
+			return;
+	}
+	ent->phandle = phandle;
+	ent->offset = offset;
+}
+
+static struct fdt_index_compat *fdt_index_find_compat(const char *compat)
+{
+	uint slot = fdt_index_hash(compat, strlen(compat)) & idx.mask;
+	struct fdt_index_compat *ent;
+
+	for (ent = &idx.compats[slot]; ent->compat;
+	     slot = (slot + 1) & idx.mask, ent = &idx.compats[slot]) {
+		if (!strcmp(ent->compat, compat))
+			break;
+	}
+
+	return ent;
+}
+
+static void fdt_index_add_compat(const char *compat, int offset)
+{
+	struct fdt_index_compat *ent = fdt_index_find_compat(compat);
+	struct fdt_index_link *link = &idx.links[idx.num_links];
+
+	link->offset = offset;
+	link->next = -1;
+	if (ent->compat) {
+		idx.links[ent->tail].next = idx.num_links;
+	} else {
+		ent->compat = compat;
+		ent->head = idx.num_links;
+	}
+	ent->tail = idx.num_links++;
+}
+
+/*
+ * Walk every node in the tree, building up its full path in @path. With
+ * @fill false just count the nodes, path bytes and compatible strings so
+ * that the tables can be sized; with @fill true add them to the index.
+ */
+static int fdt_index_walk(const void *blob, bool fill, int *nodesp,
+			  int *pool_sizep, int *compatsp)
+{
+	char path[FDT_INDEX_PATH_MAX];
+	int plen[FDT_MAX_DEPTH];
+	char *pool = idx.pool;
+	int offset, depth = 0;
+
+	*nodesp = 0;
+	*pool_sizep = 0;
+	*compatsp = 0;
+	for (offset = 0; offset >= 0 && depth >= 0;
+	     offset = fdt_next_node(blob, offset, &depth)) {
+		const char *name, *compat, *at;
+		int len, name_len, compat_len, i;
+		uint32_t phandle;
+
+		if (depth >= FDT_MAX_DEPTH)
+			return -FDT_ERR_BADSTRUCTURE;
+
+		/* Build this node's path from its parent's */
+		name = fdt_get_name(blob, offset, &name_len);
+		if (!name)
+			return name_len;
+		if (depth == 0) {
+			strcpy(path, "/");
+			len = 1;
+		} else {
+			len = depth == 1 ? 1 : plen[depth - 1] + 1;
+			if (len + name_len >= FDT_INDEX_PATH_MAX)
+				return -FDT_ERR_NOSPACE;
+			memcpy(path + len, name, name_len);
+			path[len - 1] = '/';
+			len += name_len;
+			path[len] = '\0';
+		}
+		plen[depth] = len;
+
+		(*nodesp)++;
+		*pool_sizep += len + 1;
+		if (fill) {
+			memcpy(pool, path, len + 1);
+			fdt_index_add_path(pool, len, offset);
+
+			/* Also add the path with the unit address dropped */
+			at = depth ? memchr(name, '@', name_len) : NULL;
+			if (at)
+				fdt_index_add_path(pool, len - (name + name_len - at),
+						   offset);
+			pool += len + 1;
+
+			phandle = fdt_get_phandle(blob, offset);
+			if (phandle)
+				fdt_index_add_phandle(phandle, offset);
+		}
+
+		compat = fdt_getprop(blob, offset, "compatible", &compat_len);
+		for (i = 0; compat && i < compat_len;
+		     i += strlen(compat + i) + 1) {
+			(*compatsp)++;
+			if (fill)
+				fdt_index_add_compat(compat + i, offset);
+		}
+	}
+	if (offset < 0 && offset != -FDT_ERR_NOTFOUND)
+		return offset;
+
+	return 0;
+}
+
+void fdtdec_index_free(void)
+{
+	free(idx.paths);
+	free(idx.phandles);
+	free(idx.compats);
+	free(idx.links);
+	free(idx.pool);
+	memset(&idx, '\0', sizeof(idx));
+}
+
+int fdtdec_index_build(const void *blob)
+{
+	int nodes, pool_size, compats, entries, ret;
+	uint size;
+
+	fdtdec_index_free();
+	ret = fdt_check_header(blob);
+	if (ret)
+		return -EINVAL;
+	ret = fdt_index_walk(blob, false, &nodes, &pool_size, &compats);
+	if (ret) {
+		debug("%s: Cannot index FDT: %s\n", __func__,
+		      fdt_strerror(ret));
+		return -EINVAL;
+	}
+
+	/* Each node may add two paths; keep the tables at most half full */
+	entries = max(nodes * 2, compats);
+	for (size = 16; size < entries * 2; size <<= 1)
+		;
+	idx.mask = size - 1;
+	idx.paths = calloc(size, sizeof(*idx.paths));
+	idx.phandles = calloc(size, sizeof(*idx.phandles));
+	idx.compats = calloc(size, sizeof(*idx.compats));
+	idx.links = malloc(max(compats, 1) * sizeof(*idx.links));
+	idx.pool = malloc(pool_size);
+	if (!idx.paths || !idx.phandles || !idx.compats ||
+	    !idx.links || !idx.pool) {
+		fdtdec_index_free();
+		return -ENOMEM;
+	}
+
+	ret = fdt_index_walk(blob, true, &nodes, &pool_size, &compats);
+	if (ret) {
+		fdtdec_index_free();
+		return -EINVAL;
+	}
+	idx.blob = blob;
+	idx.totalsize = fdt_totalsize(blob);
+	idx.size_dt_struct = fdt_size_dt_struct(blob);
+	idx.size_dt_strings = fdt_size_dt_strings(blob);
+	debug("%s: %d nodes, %d compatible strings, %u slots\n", __func__,
+	      nodes, compats, size);
+
+	return 0;
+}
+
+void fdtdec_index_changed(const void *blob)
+{
+	if (blob && blob == idx.blob)
+		fdtdec_index_build(blob);
+}
+
+/* Check that the index is of @blob, and that @blob looks unchanged since */
+static bool fdt_index_valid(const void *blob)
+{
+	return blob == idx.blob && idx.blob &&
+		fdt_totalsize(blob) == idx.totalsize &&
+		fdt_size_dt_struct(blob) == idx.size_dt_struct &&
+		fdt_size_dt_strings(blob) == idx.size_dt_strings;
+}
+
+/*
+ * A path that was not found in the index is only known to be missing if
+ * libfdt would have looked for exactly the keys that were added: every
+ * component but the last must carry its unit address, and there must be no
+ * empty components or ':' options.
+ */
+static bool fdt_index_path_is_exact(const char *path)
+{
+	const char *p, *q;
+
+	for (p = path + 1; (q = strchr(p, '/')); p = q + 1) {
+		if (q == p || !memchr(p, '@', q - p))
+			return false;
+	}
+
+	return *p && !strchr(path, ':');
+}
+
+bool fdtdec_index_path(const void *blob, const char *path, int *offsetp)
+{
+	const struct fdt_index_path *ent;
+	const char *alias;
+	int len, offset;
+	uint slot;
+
+	if (!fdt_index_valid(blob))
+		return false;
+
+	/* Aliases are resolved through /aliases, itself from the index */
+	if (*path != '/') {
+		if (strchr(path, '/') || strchr(path, ':') ||
+		    !fdtdec_index_path(blob, "/aliases", &offset))
+			return false;
+		alias = offset < 0 ? NULL :
+			fdt_getprop(blob, offset, path, NULL);
+		if (!alias) {
+			*offsetp = -FDT_ERR_BADPATH;
+			return true;
+		}
+		return fdtdec_index_path(blob, alias, offsetp);
+	}
+
+	len = strlen(path);
+	slot = fdt_index_hash(path, len) & idx.mask;
+	for (ent = &idx.paths[slot]; ent->path;
+	     slot = (slot + 1) & idx.mask, ent = &idx.paths[slot]) {
+		if (ent->len == len && !memcmp(ent->path, path, len)) {
+			*offsetp = ent->offset;
+			return true;
+		}
+	}
+	if (!fdt_index_path_is_exact(path))
+		return false;
+	*offsetp = -FDT_ERR_NOTFOUND;
+
+	return true;
+}
+
+bool fdtdec_index_phandle(const void *blob, uint32_t phandle, int *offsetp)
+{
+	const struct fdt_index_phandle *ent;
+	uint slot;
+
+	if (!fdt_index_valid(blob))
+		return false;
+	if (!phandle || phandle == (uint32_t)-1) {
+		*offsetp = -FDT_ERR_BADPHANDLE;
+		return true;
+	}
+
+	*offsetp = -FDT_ERR_NOTFOUND;
+	slot = phandle & idx.mask;
+	for (ent = &idx.phandles[slot]; ent->phandle;
+	     slot = (slot + 1) & idx.mask, ent = &idx.phandles[slot]) {
+		if (ent->phandle == phandle) {
+			*offsetp = ent->offset;
+			break;
+		}
+	}
+
+	return true;
+}
+
+bool fdtdec_index_compatible(const void *blob, int startoffset,
+			     const char *compat, int *offsetp)
+{
+	const struct fdt_index_compat *ent;
+	int i;
+
+	if (!fdt_index_valid(blob))
+		return false;
+
+	*offsetp = -FDT_ERR_NOTFOUND;
+	ent = fdt_index_find_compat(compat);
+	if (!ent->compat)
+		return true;
+	for (i = ent->head; i >= 0; i = idx.links[i].next) {
+		if (idx.links[i].offset > startoffset) {
+			*offsetp = idx.links[i].offset;
+			break;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,188 @@
+/*
+ * Streaming hex and base64 dumps
+ *
+ * Dumps are built a line at a time in a buffer with table lookups, instead
+ * of a printf() per byte, and each line goes to the console in one puts().
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <console.h>
+#include <hexdump.h>
+#include <u-boot/crc.h>
+
+static const char hex_digits[] = "0123456789abcdef";
+
+static const char b64_digits[] =
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static char *hexdump_hex(char *p, u64 x, uint digits)
+{
+	while (digits--)
+		*p++ = hex_digits[(x >> (digits * 4)) & 0xf];
+
+	return p;
+}
+
+int hexdump_format_line(char *buf, ulong addr, const void *data, uint width,
+			uint count, uint linelen)
+{
+	const u8 *bytes = data;
+	char *p = buf;
+	uint digits, i;
+	u64 x;
+
+	/* at least 8 digits of address, more if it needs them */
+	for (digits = 8; digits < 2 * sizeof(addr) && addr >> (digits * 4);
+	     digits++)
+		;
+	p = hexdump_hex(p, addr, digits);
+	*p++ = ':';
+
+	for (i = 0; i < count; i++) {
+		if (width == 8)
+			x = ((const u64 *)data)[i];
+		else if (width == 4)
+			x = ((const u32 *)data)[i];
+		else if (width == 2)
+			x = ((const u16 *)data)[i];
+		else
+			x = bytes[i];
+		*p++ = ' ';
+		p = hexdump_hex(p, x, width * 2);
+	}
+
+	/* line the ASCII column up with that of a full line */
+	for (i = (linelen - count) * (width * 2 + 1); i; i--)
+		*p++ = ' ';
+	for (i = 0; i < 4; i++)
+		*p++ = ' ';
+
+	for (i = 0; i < count * width; i++)
+		*p++ = bytes[i] >= 0x20 && bytes[i] < 0x7f ? bytes[i] : '.';
+	*p++ = '\n';
+	*p = '\0';
+
+	return p - buf;
+}
+
+static int hexdump_b64_line(char *buf, const u8 *data, uint len)
+{
+	char *p = buf;
+	u32 x;
+	uint i;
+
+	for (i = 0; i + 3 <= len; i += 3) {
+		x = data[i] << 16 | data[i + 1] << 8 | data[i + 2];
+		*p++ = b64_digits[x >> 18];
+		*p++ = b64_digits[(x >> 12) & 0x3f];
+		*p++ = b64_digits[(x >> 6) & 0x3f];
+		*p++ = b64_digits[x & 0x3f];
+	}
+	if (i < len) {
+		x = data[i] << 16 | (i + 1 < len ? data[i + 1] << 8 : 0);
+		*p++ = b64_digits[x >> 18];
+		*p++ = b64_digits[(x >> 12) & 0x3f];
+		*p++ = i + 1 < len ? b64_digits[(x >> 6) & 0x3f] : '=';
+		*p++ = '=';
+	}
+	*p++ = '\n';
+	*p = '\0';
+
+	return p - buf;
+}
+
+void hexdump_start(struct hexdump *hd, enum hexdump_mode mode, ulong addr,
+		   uint width)
+{
+	memset(hd, 0, sizeof(*hd));
+	hd->mode = mode;
+	hd->addr = addr;
+	hd->width = width;
+}
+
+/* Print len bytes of a line, which is whole unless the dump is finishing */
+static void hexdump_emit(struct hexdump *hd, const u8 *data, uint len)
+{
+	char buf[HEXDUMP_MAX_LINE_LEN];
+	uint words;
+
+	if (hd->mode == HEXDUMP_BASE64) {
+		hexdump_b64_line(buf, data, len);
+	} else {
+		/* a trailing part word is shown as bytes on a line of its own */
+		words = len / hd->width;
+		if (words) {
+			hexdump_format_line(buf, hd->addr, data, hd->width,
+					    words, HEXDUMP_LINE_BYTES /
+					    hd->width);
+			hd->addr += words * hd->width;
+			if (len % hd->width)
+				puts(buf);
+			data += words * hd->width;
+			len -= words * hd->width;
+		}
+		if (len) {
+			hexdump_format_line(buf, hd->addr, data, 1, len,
+					    HEXDUMP_LINE_BYTES);
+			hd->addr += len;
+		}
+	}
+	puts(buf);
+}
+
+int hexdump_write(struct hexdump *hd, const void *data, size_t len)
+{
+	uint line_bytes = hd->mode == HEXDUMP_BASE64 ?
+		HEXDUMP_B64_LINE_BYTES : HEXDUMP_LINE_BYTES;
+	const u8 *p = data;
+	uint n;
+
+	hd->crc = crc32(hd->crc, p, len);
+	hd->total += len;
+
+	/* complete a line held from the last block first */
+	if (hd->len) {
+		n = min_t(size_t, line_bytes - hd->len, len);
+		memcpy(hd->line + hd->len, p, n);
+		hd->len += n;
+		p += n;
+		len -= n;
+		if (hd->len < line_bytes)
+			return 0;
+		hexdump_emit(hd, hd->line, line_bytes);
+		hd->len = 0;
+		if (ctrlc())
+			return -EINTR;
+	}
+
+	while (len >= line_bytes) {
+		/* words are read in place, so copy unless they're aligned */
+		if ((ulong)p & (hd->width - 1) && hd->mode == HEXDUMP_HEX) {
+			memcpy(hd->line, p, line_bytes);
+			hexdump_emit(hd, hd->line, line_bytes);
+		} else {
+			hexdump_emit(hd, p, line_bytes);
+		}
+		p += line_bytes;
+		len -= line_bytes;
+		if (ctrlc())
+			return -EINTR;
+	}
+
+	memcpy(hd->line, p, len);
+	hd->len = len;
+
+	return 0;
+}
+
+void hexdump_finish(struct hexdump *hd)
+{
+	if (hd->len)
+		hexdump_emit(hd, hd->line, hd->len);
+	hd->len = 0;
+
+	if (hd->mode == HEXDUMP_BASE64)
+		printf("length %lu crc32 %08x\n", hd->total, hd->crc);
+}
@@ -382,11 +382,26 @@ int eth_rx(void)
 	return ret;
 }
 
+#ifdef CONFIG_NET_LAZY_INIT
+static bool eth_initialized;
+
+int eth_lazy_initialize(void)
+{
+	if (eth_initialized)
+		return 0;
+
+	return eth_initialize();
+}
+#endif
+
 int eth_initialize(void)
 {
 	int num_devices = 0;
 	struct udevice *dev;
 
+#ifdef CONFIG_NET_LAZY_INIT
+	eth_initialized = true;
+#endif
 	eth_common_init();
 
 	/*
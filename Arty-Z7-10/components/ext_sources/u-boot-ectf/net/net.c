@@ -395,6 +395,8 @@ int net_loop(enum proto_t protocol)
 {
 	int ret = -EINVAL;
 
+	eth_lazy_initialize();
+
 	net_restarted = 0;
 	net_dev_exists = 0;
 	net_try_count = 1;
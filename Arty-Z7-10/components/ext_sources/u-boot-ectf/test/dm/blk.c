@@ -6,6 +6,8 @@
 
 #include <common.h>
 #include <dm.h>
+#include <os.h>
+#include <sandboxblockdev.h>
 #include <usb.h>
 #include <asm/state.h>
 #include <dm/test.h>
@@ -94,3 +96,44 @@ static int dm_test_blk_usb(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_usb, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Test that reads from a host file can be left in flight */
+static int dm_test_blk_async(struct unit_test_state *uts)
+{
+	const char *fname = "dm_test_blk_async.img";
+	struct blk_desc *dev_desc;
+	struct blk_req req;
+	u8 data[4][512];
+	u8 buf[2][512];
+	int fd, i;
+
+	for (i = 0; i < 4; i++)
+		memset(data[i], 'a' + i, sizeof(data[i]));
+	fd = os_open(fname, OS_O_RDWR | OS_O_CREAT);
+	ut_assert(fd >= 0);
+	ut_asserteq(sizeof(data), os_write(fd, data, sizeof(data)));
+	os_close(fd);
+	ut_assertok(host_dev_bind(0, (char *)fname));
+	ut_assertok(blk_get_device_by_str("host", "0", &dev_desc));
+
+	/* Nothing arrives until the read is polled */
+	memset(buf, '\0', sizeof(buf));
+	blk_dread_start(dev_desc, 1, 2, buf, &req);
+	ut_assert(req.busy);
+	ut_asserteq(0, buf[0][0]);
+	ut_asserteq(2, blk_dread_wait(&req));
+	ut_assert(!req.busy);
+	ut_assertok(memcmp(data[1], buf, sizeof(buf)));
+
+	/* Unbinding the device waits for a read in flight */
+	memset(buf, '\0', sizeof(buf));
+	blk_dread_start(dev_desc, 2, 2, buf, &req);
+	ut_assertok(host_dev_bind(0, NULL));
+	ut_assert(!req.busy);
+	ut_asserteq(2, req.ret);
+	ut_assertok(memcmp(data[2], buf, sizeof(buf)));
+	ut_assertok(os_unlink(fname));
+
+	return 0;
+}
+DM_TEST(dm_test_blk_async, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
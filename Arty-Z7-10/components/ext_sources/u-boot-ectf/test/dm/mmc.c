@@ -44,3 +44,81 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+static int dm_test_mmc_stats(struct unit_test_state *uts)
+{
+	struct mmc_stats before, *st;
+	struct blk_desc *dev_desc;
+	struct udevice *dev;
+	struct mmc *mmc;
+	char buf[1024];
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	mmc = find_mmc_device(0);
+	ut_assertnonnull(mmc);
+	st = &mmc->stats;
+
+	/* The block length is set once and then remembered */
+	ut_asserteq(2, blk_dread(dev_desc, 0, 2, buf));
+	before = *st;
+	ut_asserteq(2, blk_dread(dev_desc, 0, 2, buf));
+	ut_asserteq(1, blk_dread(dev_desc, 4, 1, buf));
+	ut_asserteq(before.set_blocklen, st->set_blocklen);
+	ut_asserteq(before.blocklen_cached + 2, st->blocklen_cached);
+
+	/* The card takes CMD23, so multi-block reads need no CMD12 */
+	ut_asserteq(before.reads + 2, st->reads);
+	ut_asserteq(before.blocks + 3, st->blocks);
+	ut_asserteq(before.read_cmds + 2, st->read_cmds);
+	ut_asserteq(before.set_block_count + 1, st->set_block_count);
+	ut_asserteq(before.stop, st->stop);
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_stats, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+/* Reads can be left in flight, one at a time */
+static int dm_test_mmc_async(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	struct blk_req req[2];
+	struct udevice *dev;
+	char buf[2][1024];
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	memset(buf, '\0', sizeof(buf));
+
+	/* Nothing arrives until the read is polled */
+	blk_dread_start(dev_desc, 0, 2, buf[0], &req[0]);
+	ut_assert(req[0].busy);
+	ut_asserteq_ptr(&req[0], dev_desc->inflight);
+	ut_asserteq(0, buf[0][0]);
+
+	/* Starting another read finishes the first */
+	blk_dread_start(dev_desc, 4, 2, buf[1], &req[1]);
+	ut_assert(!req[0].busy);
+	ut_asserteq(2, blk_dread_wait(&req[0]));
+	ut_assertok(strcmp(buf[0], "this is a test"));
+	ut_assert(blk_dread_poll(&req[1]));
+	ut_asserteq(2, blk_dread_wait(&req[1]));
+	ut_assertok(strcmp(buf[1], "this is a test"));
+	ut_asserteq_ptr(NULL, dev_desc->inflight);
+
+	/* So does any other use of the device */
+	memset(buf, '\0', sizeof(buf));
+	blk_dread_start(dev_desc, 0, 2, buf[0], &req[0]);
+	ut_asserteq(2, blk_dread(dev_desc, 0, 2, buf[1]));
+	ut_assert(!req[0].busy);
+	ut_asserteq(2, blk_dread_wait(&req[0]));
+	ut_assertok(strcmp(buf[0], "this is a test"));
+
+	/* A read past the end fails when started */
+	blk_dread_start(dev_desc, dev_desc->lba, 2, buf[0], &req[0]);
+	ut_assert(!req[0].busy);
+	ut_asserteq(-EIO, blk_dread_wait(&req[0]));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_async, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
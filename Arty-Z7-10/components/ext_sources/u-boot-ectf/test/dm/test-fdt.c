@@ -266,3 +266,108 @@ static int dm_test_fdt_offset(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_fdt_offset, DM_TESTF_SCAN_PDATA | DM_TESTF_SCAN_FDT);
+
+#ifdef CONFIG_OF_INDEX
+/* Test that the FDT index gives the same answers as libfdt */
+static int dm_test_fdt_index(struct unit_test_state *uts)
+{
+	const void *blob = gd->fdt_blob;
+	const char *compat;
+	char path[256], *at;
+	int node, depth, len, i;
+	uint32_t phandle;
+
+	ut_assertok(fdtdec_index_build(blob));
+	for (node = 0, depth = 0; node >= 0 && depth >= 0;
+	     node = fdt_next_node(blob, node, &depth)) {
+		ut_assertok(fdt_get_path(blob, node, path, sizeof(path)));
+		ut_asserteq(node, fdtdec_path_offset(blob, path));
+
+		/* A node can also be found without its unit address */
+		at = strrchr(path, '@');
+		if (at && !strchr(at, '/')) {
+			*at = '\0';
+			ut_asserteq(fdt_path_offset(blob, path),
+				    fdtdec_path_offset(blob, path));
+		}
+
+		phandle = fdt_get_phandle(blob, node);
+		if (phandle)
+			ut_asserteq(node,
+				    fdtdec_node_offset_by_phandle(blob, phandle));
+
+		compat = fdt_getprop(blob, node, "compatible", &len);
+		for (i = 0; compat && i < len; i += strlen(compat + i) + 1) {
+			ut_asserteq(fdt_node_offset_by_compatible(blob, -1,
+								  compat + i),
+				    fdtdec_node_offset_by_compatible(blob, -1,
+								     compat + i));
+			ut_asserteq(fdt_node_offset_by_compatible(blob, node,
+								  compat + i),
+				    fdtdec_node_offset_by_compatible(blob, node,
+								     compat + i));
+		}
+	}
+
+	/* Aliases, misses and paths the index leaves to libfdt */
+	ut_asserteq(fdt_path_offset(blob, "testfdt6"),
+		    fdtdec_path_offset(blob, "testfdt6"));
+	ut_asserteq(fdt_path_offset(blob, "eth3"),
+		    fdtdec_path_offset(blob, "eth3"));
+	ut_asserteq(-FDT_ERR_BADPATH, fdtdec_path_offset(blob, "no-alias"));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdtdec_path_offset(blob, "/no-node"));
+	ut_asserteq(fdt_path_offset(blob, "/some-bus/c-test"),
+		    fdtdec_path_offset(blob, "/some-bus/c-test"));
+	ut_asserteq(fdt_path_offset(blob, "/some-bus/"),
+		    fdtdec_path_offset(blob, "/some-bus/"));
+	ut_asserteq(-FDT_ERR_BADPHANDLE,
+		    fdtdec_node_offset_by_phandle(blob, 0));
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdtdec_node_offset_by_phandle(blob, 0xfffff));
+	ut_asserteq(-FDT_ERR_NOTFOUND,
+		    fdtdec_node_offset_by_compatible(blob, -1, "no,compat"));
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_index, 0);
+
+/* Test that the FDT index is not trusted once the tree is written */
+static int dm_test_fdt_index_write(struct unit_test_state *uts)
+{
+	int size = fdt_totalsize(gd->fdt_blob) + 256;
+	char path[256];
+	void *blob;
+	int node;
+
+	blob = malloc(size);
+	ut_assertnonnull(blob);
+	ut_assertok(fdt_open_into(gd->fdt_blob, blob, size));
+	ut_assertok(fdtdec_index_build(blob));
+
+	/* Adding a node moves the ones after it; the index must notice */
+	node = fdt_first_subnode(blob, 0);
+	ut_assert(node >= 0);
+	ut_assertok(fdt_get_path(blob, node, path, sizeof(path)));
+	ut_assert(fdt_add_subnode(blob, 0, "index-test") >= 0);
+	node = fdt_path_offset(blob, path);
+	ut_asserteq(node, fdtdec_path_offset(blob, path));
+	ut_asserteq(fdt_path_offset(blob, "/index-test"),
+		    fdtdec_path_offset(blob, "/index-test"));
+
+	/* An in-place write keeps the sizes, so the writer must say so */
+	fdtdec_index_changed(blob);
+	ut_asserteq(node, fdtdec_path_offset(blob, path));
+	ut_assertok(fdt_setprop_u32(blob, node, "phandle", 0x1233));
+	fdtdec_index_changed(blob);
+	ut_asserteq(node, fdtdec_node_offset_by_phandle(blob, 0x1233));
+	ut_assertok(fdt_setprop_inplace_u32(blob, node, "phandle", 0x1234));
+	fdtdec_index_changed(blob);
+	ut_asserteq(node, fdtdec_node_offset_by_phandle(blob, 0x1234));
+
+	ut_assertok(fdtdec_index_build(gd->fdt_blob));
+	free(blob);
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_index_write, 0);
+#endif
@@ -20,9 +20,15 @@
 #
 # The test will create a FAT filesystem image, record the CRC of a randomly
 # generated file in the image, build U-Boot sandbox, invoke U-Boot sandbox to
-# read the file and validate that the CRCs match. Expected output is shown
-# below. The important part of the log is the penultimate line that contains
-# either "PASS" or "FAILURE".
+# read the file and validate that the CRCs match. The file is then read again,
+# which uses the cluster runs cached by the first read, and a part of it is
+# read from an offset that is not cluster-aligned. Expected output is shown
+# below, trimmed to the first read. Every check prints either "PASS" or
+# "FAILURE".
+#
+# The "bytes read in" lines give the load times. The second read does not
+# touch the FAT at all, so comparing it with the first shows the cost of
+# following this file's fragmented cluster chain.
 #
 #    mkfs.fat 3.0.26 (2014-03-07)
 #
@@ -59,9 +65,24 @@ mnt=${odir}/mnt
 fill=/dev/urandom
 testfn=noncontig.img
 mnttestfn=${mnt}/${testfn}
+partfn=${odir}/noncontig-part.img
+# U-Boot's load takes these in hex
+partoff=12d687
+partlen=74cbb1
 crcaddr=0
 loadaddr=1000
 
+# Print the CRC of a file in the byte order crc32 stores it in memory
+le_crc32() {
+    local crc=0x`crc32 $1`
+
+    printf %02x%02x%02x%02x \
+        $((${crc} & 0xff)) \
+        $(((${crc} >> 8) & 0xff)) \
+        $(((${crc} >> 16) & 0xff)) \
+        $((${crc} >> 24))
+}
+
 for prereq in fallocate mkfs.fat dd crc32; do
     if [ ! -x "`which $prereq`" ]; then
         echo "Missing $prereq binary. Exiting!"
@@ -119,24 +140,28 @@ if [ $? -ne 0 ]; then
     echo Could not mount test filesystem
     exit $?
 fi
-crc=0x`crc32 ${mnttestfn}`
+crc=`le_crc32 ${mnttestfn}`
+dd if=${mnttestfn} of=${partfn} bs=64k iflag=skip_bytes,count_bytes \
+    skip=$((0x${partoff})) count=$((0x${partlen})) >/dev/null 2>&1
 sudo umount ${mnt}
 if [ $? -ne 0 ]; then
     echo Could not unmount test filesystem
     exit $?
 fi
 
-crc=`printf %02x%02x%02x%02x \
-    $((${crc} & 0xff)) \
-    $(((${crc} >> 8) & 0xff)) \
-    $(((${crc} >> 16) & 0xff)) \
-    $((${crc} >> 24))`
+partcrc=`le_crc32 ${partfn}`
 
 ./sandbox/u-boot << EOF
 host bind 0 ${img}
 load host 0:0 ${loadaddr} ${testfn}
 crc32 ${loadaddr} \$filesize ${crcaddr}
 if itest.l *${crcaddr} != ${crc}; then echo FAILURE; else echo PASS; fi
+load host 0:0 ${loadaddr} ${testfn}
+crc32 ${loadaddr} \$filesize ${crcaddr}
+if itest.l *${crcaddr} != ${crc}; then echo FAILURE; else echo PASS; fi
+load host 0:0 ${loadaddr} ${testfn} ${partlen} ${partoff}
+crc32 ${loadaddr} \$filesize ${crcaddr}
+if itest.l *${crcaddr} != ${partcrc}; then echo FAILURE; else echo PASS; fi
 reset
 EOF
 if [ $? -ne 0 ]; then
@@ -74,6 +74,11 @@ def pytest_addoption(parser):
     parser.addoption('--gdbserver', default=None,
         help='Run sandbox under gdbserver. The argument is the channel '+
         'over which gdbserver should communicate, e.g. localhost:1234')
+    parser.addoption('--perf-update', default=False, action='store_true',
+        help='Store the performance results of this run as the baseline')
+    parser.addoption('--perf-tolerance', default=None, type=float,
+        help='Allowed slowdown against the performance baseline, as a ' +
+        'fraction, e.g. 0.1 for 10%%')
 
 def pytest_configure(config):
     """pytest hook: Perform custom initialization at startup time.
@@ -179,6 +184,8 @@ def pytest_configure(config):
     ubconfig.board_type = board_type
     ubconfig.board_identity = board_identity
     ubconfig.gdbserver = gdbserver
+    ubconfig.perf_update = config.getoption('perf_update')
+    ubconfig.perf_tolerance = config.getoption('perf_tolerance')
     ubconfig.dtb = build_dir + '/arch/sandbox/dts/test.dtb'
 
     env_vars = (
@@ -484,6 +491,27 @@ def setup_buildconfigspec(item):
         if not ubconfig.buildconfig.get('config_' + option.lower(), None):
             pytest.skip('.config feature not enabled')
 
+def setup_notbuildconfigspec(item):
+    """Process any 'notbuildconfigspec' marker for a test.
+
+    Such a marker lists some U-Boot configuration feature that the test
+    cannot run with. If tests are being executed on an U-Boot build that has
+    the feature, the test is marked to be skipped.
+
+    Args:
+        item: The pytest test item.
+
+    Returns:
+        Nothing.
+    """
+
+    mark = item.get_marker('notbuildconfigspec')
+    if not mark:
+        return
+    for option in mark.args:
+        if ubconfig.buildconfig.get('config_' + option.lower(), None):
+            pytest.skip('.config feature enabled')
+
 def start_test_section(item):
     anchors[item.name] = log.start_section(item.name)
 
@@ -504,6 +532,7 @@ def pytest_runtest_setup(item):
     setup_boardspec(item)
     setup_boardidentity(item)
     setup_buildconfigspec(item)
+    setup_notbuildconfigspec(item)
 
 def pytest_runtest_protocol(item, nextitem):
     """pytest hook: Called to execute a test.
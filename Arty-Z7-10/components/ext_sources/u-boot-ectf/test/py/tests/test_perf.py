@@ -0,0 +1,569 @@
+# Performance tests: time SPI flash, MMC, filesystem, image and mesh shell
+# operations, and compare the results with stored baselines.
+#
+# SPDX-License-Identifier: GPL-2.0
+
+import gzip
+import json
+import os
+import re
+import time
+import pytest
+import u_boot_utils
+import zlib
+
+"""
+Each measurement is a metric, e.g. "sf_read_1MiB" in MiB/s or "mesh_list" in
+ms. All metrics of a run are written to perf.json in the result directory.
+
+A metric is checked against the baseline file, which is tests/perf/
+<board_type>.json unless env__perf_baseline names another. A metric that is
+slower than its baseline by more than the tolerance fails its test, and so
+does one with no baseline, unless --perf-update is given. The tolerance is a fraction of the baseline,
+taken from the metric's "tolerance" in the baseline file, else from
+--perf-tolerance, else from env__perf_tolerance, else 0.1. Running with
+--perf-update stores the results as the new baseline.
+
+Commands are run on U-Boot's command line with "run", doubling the number of
+runs until they take at least env__perf_min_time seconds (default 0.5), so
+that short operations are not lost in the timer resolution. They are timed
+by U-Boot's "time" command if it has one, else by the host. Mesh shell
+commands are always timed by the host, one at a time.
+
+SPI flash tests write to the flash, so on real hardware they only run when
+the region to use is given:
+
+env__perf_sf = {
+    "probe": "0",
+    "offset": 0xe00000,
+    "sizes": [0x10000, 0x100000],
+}
+
+"sf bench", if built, is run on the first of those sizes and only checked for
+errors, since its own table is the result.
+
+Other tests read, and may be configured. "blk bench", or "mmc bench" on a
+board, is only checked for errors:
+
+env__perf_mmc = {
+    "dev": 0,
+    "start": 0,
+    "count": 0x2000,
+}
+
+env__perf_ext4 = {
+    "interface": "mmc",
+    "dev": "0:2",
+    "file": "/games/big",
+}
+
+Image tests build their images in the persistent data directory. On real
+hardware they need a command that loads such a file, e.g. with the TFTP root
+pointing at that directory:
+
+env__perf_load_cmd = "tftpboot %(addr)x %(fn)s"
+
+On a board built with the mesh shell, only the mesh tests run. Its commands
+may be chosen:
+
+env__perf_mesh_cmds = ["help", "list", "query"]
+"""
+
+# Where the tests put their data, from the start of RAM
+PERF_BUF_A = 0x1000000
+PERF_BUF_B = 0x2000000
+PERF_IMAGE = 0x3000000
+
+PERF_MAX_LEVEL = 10
+
+re_time = re.compile(r'time: (?:(\d+) minutes, )?(\d+)\.(\d+) seconds')
+
+perf_results = {}
+perf_baseline = None
+
+def perf_size(size):
+    """Name a size for a metric, e.g. 0x100000 as "1MiB"."""
+
+    for shift, unit in ((20, 'MiB'), (10, 'KiB')):
+        if size >= 1 << shift and not size % (1 << shift):
+            return '%d%s' % (size >> shift, unit)
+    return '%dB' % size
+
+def perf_baseline_fn(u_boot_console):
+    """Find the baseline file for this board."""
+
+    config = u_boot_console.config
+    fn = config.env.get('env__perf_baseline', None)
+    if not fn:
+        fn = 'tests/perf/' + config.board_type + '.json'
+    return os.path.join(config.test_py_dir, fn)
+
+def perf_write_json(fn, data):
+    """Write a dictionary to a JSON file, creating its directory."""
+
+    dirname = os.path.dirname(fn)
+    if not os.path.isdir(dirname):
+        os.makedirs(dirname)
+    with open(fn, 'w') as fh:
+        json.dump(data, fh, indent=4, sort_keys=True)
+        fh.write('\n')
+
+def perf_record(u_boot_console, name, value, unit):
+    """Record a metric and check it against its baseline.
+
+    Args:
+        u_boot_console: A console connection to U-Boot.
+        name: The metric's name.
+        value: The measurement.
+        unit: Its unit; throughputs end in "/s", and higher is better for
+            them, lower for anything else.
+
+    Returns:
+        None, or a message if the metric is too slow or has no baseline.
+    """
+
+    global perf_baseline
+    config = u_boot_console.config
+    baseline_fn = perf_baseline_fn(u_boot_console)
+    if perf_baseline is None:
+        perf_baseline = {}
+        if os.path.exists(baseline_fn):
+            with open(baseline_fn) as fh:
+                perf_baseline = json.load(fh)
+
+    higher_is_better = unit.endswith('/s')
+    result = {
+        'value': value,
+        'unit': unit,
+        'higher_is_better': higher_is_better,
+    }
+    base = perf_baseline.get(name, None)
+    status = 'new'
+    if base:
+        tolerance = base.get('tolerance', config.perf_tolerance)
+        if tolerance is None:
+            tolerance = config.env.get('env__perf_tolerance', 0.1)
+        if higher_is_better:
+            limit = base['value'] * (1 - tolerance)
+            slower = value < limit
+        else:
+            limit = base['value'] * (1 + tolerance)
+            slower = value > limit
+        status = 'slower' if slower else 'ok'
+        result.update({
+            'baseline': base['value'],
+            'tolerance': tolerance,
+            'limit': limit,
+        })
+    result['status'] = status
+    perf_results[name] = result
+
+    u_boot_console.log.info('perf %s: %.3f %s (%s)' %
+                            (name, value, unit, status))
+    perf_write_json(config.result_dir + '/perf.json', {
+        'board_type': config.board_type,
+        'board_identity': config.board_identity,
+        'metrics': perf_results,
+    })
+
+    if config.perf_update:
+        entry = {'value': value, 'unit': unit}
+        if base and 'tolerance' in base:
+            entry['tolerance'] = base['tolerance']
+        perf_baseline[name] = entry
+        perf_write_json(baseline_fn, perf_baseline)
+        return None
+
+    if status == 'new':
+        return '%s: no baseline in %s; run with --perf-update' % (name,
+                                                                 baseline_fn)
+    if status == 'slower':
+        return '%s: %.3f %s, limit %.3f %s' % (name, value, unit,
+                                               result['limit'], unit)
+    return None
+
+def perf_time(u_boot_console, cmd):
+    """Time a command, run on U-Boot's command line.
+
+    Args:
+        u_boot_console: A console connection to U-Boot.
+        cmd: The command to run, which must succeed.
+
+    Returns:
+        The time of one run, in seconds.
+    """
+
+    config = u_boot_console.config
+    min_time = config.env.get('env__perf_min_time', 0.5)
+    has_time = config.buildconfig.get('config_cmd_time', 'n') == 'y'
+
+    # perf_<n> runs cmd 2^n times, stopping at the first failure
+    u_boot_console.run_command("setenv perf_0 '%s'" % cmd)
+    for level in range(PERF_MAX_LEVEL + 1):
+        if level:
+            u_boot_console.run_command(
+                "setenv perf_%d 'run perf_%d && run perf_%d'" %
+                (level, level - 1, level - 1))
+        run = 'run perf_%d && echo perf-ok' % level
+        start = time.time()
+        if has_time:
+            output = u_boot_console.run_command('time ' + run)
+        else:
+            output = u_boot_console.run_command(run)
+        secs = time.time() - start
+        assert 'perf-ok' in output, 'failed: ' + cmd
+        if has_time:
+            m = re_time.search(output)
+            assert m, 'no time from: ' + cmd
+            secs = int(m.group(1) or 0) * 60 + int(m.group(2)) + \
+                int(m.group(3)) / 1000.0
+        if secs >= min_time:
+            break
+    u_boot_console.run_command('; '.join(
+        'setenv perf_%d' % i for i in range(level + 1)))
+
+    return secs / (1 << level)
+
+def perf_rate(secs, size):
+    """Turn the time to handle size bytes into MiB/s."""
+
+    return size / float(1 << 20) / max(secs, 1e-6)
+
+def perf_load(u_boot_console, fn, addr):
+    """Load a file from the persistent data directory into RAM."""
+
+    config = u_boot_console.config
+    if config.board_type.startswith('sandbox'):
+        cmd = 'sb load hostfs - %x %s/%s' % (addr, config.persistent_data_dir,
+                                             fn)
+    else:
+        load = config.env.get('env__perf_load_cmd', None)
+        if not load:
+            pytest.skip('No env__perf_load_cmd to load images')
+        cmd = load % {'addr': addr, 'fn': fn}
+    output = u_boot_console.run_command(cmd + ' && echo perf-ok')
+    assert 'perf-ok' in output, 'failed: ' + cmd
+
+def perf_mkimage(u_boot_console, args):
+    """Run the mkimage built with U-Boot."""
+
+    mkimage = u_boot_console.config.build_dir + '/tools/mkimage'
+    u_boot_utils.run_and_log(u_boot_console, [mkimage] + args)
+
+def perf_arch(u_boot_console):
+    """The architecture to put in images, as mkimage names it."""
+
+    return u_boot_console.config.buildconfig['config_sys_arch'].strip('"')
+
+def perf_sf_probe(u_boot_console):
+    """Probe the SPI flash, returning env__perf_sf and the flash size."""
+
+    config = u_boot_console.config
+    f = config.env.get('env__perf_sf', None)
+    if not f:
+        if not config.board_type.startswith('sandbox'):
+            pytest.skip('No env__perf_sf region to write')
+        f = {}
+        fn = config.source_dir + '/spi.bin'
+        if not os.path.exists(fn):
+            with open(fn, 'wb') as fh:
+                fh.write(b'\x00' * (2 * 1024 * 1024))
+
+    output = u_boot_console.run_command('sf probe ' + f.get('probe', ''))
+    m = re.search(r'total (\d+) (KiB|MiB)', output)
+    if not m:
+        pytest.skip('No SPI flash available')
+    total = int(m.group(1)) << (20 if m.group(2) == 'MiB' else 10)
+    return f, total
+
+@pytest.mark.buildconfigspec('cmd_sf')
+@pytest.mark.buildconfigspec('cmd_run')
+@pytest.mark.notbuildconfigspec('mesh_parser')
+@pytest.mark.parametrize('op', ['read', 'update', 'erase'])
+def test_perf_sf(u_boot_console, op):
+    """Time SPI flash reads, updates and erases of each size."""
+
+    f, total = perf_sf_probe(u_boot_console)
+    offset = f.get('offset', 0)
+    sizes = f.get('sizes', [0x10000, 0x100000])
+
+    ram_base = u_boot_utils.find_ram_base(u_boot_console)
+    buf_a = ram_base + PERF_BUF_A
+    buf_b = ram_base + PERF_BUF_B
+    failed = []
+    for size in sizes:
+        if offset + size > total:
+            continue
+        if op == 'read':
+            cmd = 'sf read %x %x %x' % (buf_a, offset, size)
+            count = size
+        elif op == 'update':
+            # alternate between two patterns so that nothing is skipped
+            u_boot_console.run_command('mw.b %x 55 %x' % (buf_a, size))
+            u_boot_console.run_command('mw.b %x aa %x' % (buf_b, size))
+            cmd = 'sf update %x %x %x && sf update %x %x %x' % (
+                buf_a, offset, size, buf_b, offset, size)
+            count = 2 * size
+        else:
+            cmd = 'sf erase %x %x' % (offset, size)
+            count = size
+        secs = perf_time(u_boot_console, cmd)
+        failed.append(perf_record(u_boot_console,
+                                  'sf_%s_%s' % (op, perf_size(size)),
+                                  perf_rate(secs, count), 'MiB/s'))
+    failed = [msg for msg in failed if msg]
+    assert not failed, '; '.join(failed)
+
+@pytest.mark.buildconfigspec('cmd_sf_bench')
+@pytest.mark.notbuildconfigspec('mesh_parser')
+def test_perf_sf_bench(u_boot_console):
+    """Check that sf bench runs every operation on the first region size."""
+
+    f, total = perf_sf_probe(u_boot_console)
+    offset = f.get('offset', 0)
+    size = f.get('sizes', [0x10000])[0]
+    if offset + size > total:
+        pytest.skip('SPI flash region does not fit')
+
+    with u_boot_console.temporary_timeout(600000):
+        output = u_boot_console.run_command('sf bench %x %x 2 && echo ok' %
+                                            (offset, size))
+    assert 'FAILED' not in output
+    assert output.endswith('ok')
+    for op, sizes in (('read', ['16', '256', '4096', '65536']),
+                      ('program', ['16', '256', '4096', '65536']),
+                      ('erase64k', ['65536']),
+                      ('update', ['4096', '65536'])):
+        for op_size in sizes:
+            assert re.search(r'^%s +%s +0 +\d+ ' % (op, op_size), output,
+                             re.M), '%s of %s not run' % (op, op_size)
+
+@pytest.mark.buildconfigspec('cmd_mmc')
+@pytest.mark.buildconfigspec('cmd_run')
+@pytest.mark.notbuildconfigspec('mesh_parser')
+def test_perf_mmc_read(u_boot_console):
+    """Time raw MMC block reads."""
+
+    f = u_boot_console.config.env.get('env__perf_mmc', {})
+    dev = f.get('dev', 0)
+    start = f.get('start', 0)
+    count = f.get('count', 0x2000)
+
+    output = u_boot_console.run_command('mmc dev %d && echo perf-ok' % dev)
+    if 'perf-ok' not in output:
+        pytest.skip('No MMC device %d' % dev)
+    ram_base = u_boot_utils.find_ram_base(u_boot_console)
+    secs = perf_time(u_boot_console, 'mmc read %x %x %x' %
+                     (ram_base + PERF_BUF_A, start, count))
+    size = count * 512
+    failed = perf_record(u_boot_console, 'mmc_read_%s' % perf_size(size),
+                         perf_rate(secs, size), 'MiB/s')
+    assert not failed, failed
+
+@pytest.mark.buildconfigspec('cmd_blk_bench')
+@pytest.mark.notbuildconfigspec('mesh_parser')
+def test_perf_blk_bench(u_boot_console):
+    """Check that blk bench, or mmc bench, times every size and pattern."""
+
+    config = u_boot_console.config
+    f = config.env.get('env__perf_mmc', None)
+    if config.board_type.startswith('sandbox') and not f:
+        data = u_boot_utils.PersistentRandomFile(u_boot_console,
+                                                 'perf-blk.bin', 1 << 20)
+        u_boot_console.run_command('host bind 1 ' + data.abs_fn)
+        cmd = 'blk bench host 1 0 800 4'
+    else:
+        if not config.buildconfig.get('config_cmd_mmc', None):
+            pytest.skip('No mmc command')
+        f = f or {}
+        output = u_boot_console.run_command('mmc dev %d && echo perf-ok' %
+                                            f.get('dev', 0))
+        if 'perf-ok' not in output:
+            pytest.skip('No MMC device %d' % f.get('dev', 0))
+        cmd = 'mmc bench %x %x 4' % (f.get('start', 0),
+                                     f.get('count', 0x2000))
+
+    output = u_boot_console.run_command(cmd + ' && echo ok')
+    assert 'FAILED' not in output
+    assert output.endswith('ok')
+    for pattern in ('seq', 'rand'):
+        assert re.search(r'^%s +512 +0 +\d+ ' % pattern, output, re.M), \
+            '%s reads of one block not run' % pattern
+
+@pytest.mark.buildconfigspec('cmd_ext4')
+@pytest.mark.buildconfigspec('cmd_run')
+@pytest.mark.notbuildconfigspec('mesh_parser')
+def test_perf_ext4load(u_boot_console):
+    """Time loading a file from an ext4 filesystem."""
+
+    config = u_boot_console.config
+    f = config.env.get('env__perf_ext4', None)
+    if not f:
+        if not config.board_type.startswith('sandbox'):
+            pytest.skip('No env__perf_ext4 file to load')
+        # a filesystem holding a 4 MiB file, on the sandbox host device
+        data = u_boot_utils.PersistentRandomFile(u_boot_console,
+                                                 'perf-ext4.bin', 4 << 20)
+        img = config.persistent_data_dir + '/perf-ext4.img'
+        if not os.path.exists(img):
+            tmpdir = config.result_dir + '/perf-ext4'
+            if not os.path.isdir(tmpdir):
+                os.makedirs(tmpdir)
+            u_boot_utils.run_and_log(u_boot_console,
+                                     ['cp', data.abs_fn, tmpdir + '/perf.bin'])
+            u_boot_utils.run_and_log(u_boot_console,
+                                     ['dd', 'if=/dev/zero', 'of=' + img,
+                                      'bs=1M', 'count=16'])
+            u_boot_utils.run_and_log(u_boot_console,
+                                     ['mkfs.ext4', '-q', '-F', '-d', tmpdir,
+                                      img])
+        u_boot_console.run_command('host bind 0 ' + img)
+        f = {'interface': 'host', 'dev': '0', 'file': '/perf.bin'}
+
+    ram_base = u_boot_utils.find_ram_base(u_boot_console)
+    cmd = 'ext4load %s %s %x %s' % (f['interface'], f['dev'],
+                                    ram_base + PERF_BUF_A, f['file'])
+    output = u_boot_console.run_command(cmd)
+    m = re.search(r'(\d+) bytes read', output)
+    assert m, 'failed: ' + cmd
+    size = int(m.group(1))
+    secs = perf_time(u_boot_console, cmd)
+    failed = perf_record(u_boot_console, 'ext4load_%s' % f['interface'],
+                         perf_rate(secs, size), 'MiB/s')
+    assert not failed, failed
+
+FIT_ITS = '''/dts-v1/;
+
+/ {
+	description = "Performance test image";
+	#address-cells = <1>;
+
+	images {
+		kernel@1 {
+			description = "Random data";
+			data = /incbin/("%(data)s");
+			type = "kernel";
+			arch = "%(arch)s";
+			os = "linux";
+			compression = "%(comp)s";
+			load = <0x%(load)x>;
+			entry = <0x%(load)x>;
+			hash@1 {
+				algo = "%(algo)s";
+			};
+		};
+	};
+	configurations {
+		default = "conf@1";
+		conf@1 {
+			kernel = "kernel@1";
+		};
+	};
+};
+'''
+
+def perf_make_fit(u_boot_console, fn, data, comp, algo, load):
+    """Build a FIT holding one kernel image, with one hash."""
+
+    config = u_boot_console.config
+    its = config.persistent_data_dir + '/' + fn + '.its'
+    with open(its, 'w') as fh:
+        fh.write(FIT_ITS % {'data': data, 'arch': perf_arch(u_boot_console),
+                            'comp': comp, 'algo': algo, 'load': load})
+    perf_mkimage(u_boot_console, ['-f', its,
+                                  config.persistent_data_dir + '/' + fn])
+
+@pytest.mark.buildconfigspec('fit')
+@pytest.mark.buildconfigspec('cmd_run')
+@pytest.mark.notbuildconfigspec('mesh_parser')
+@pytest.mark.parametrize('algo', ['crc32', 'sha1', 'sha256'])
+def test_perf_fit_verify(u_boot_console, algo):
+    """Time checking the hash of a 4 MiB image in a FIT."""
+
+    size = 4 << 20
+    data = u_boot_utils.PersistentRandomFile(u_boot_console, 'perf-fit.bin',
+                                             size)
+    fn = 'perf-fit-%s.itb' % algo
+    ram_base = u_boot_utils.find_ram_base(u_boot_console)
+    perf_make_fit(u_boot_console, fn, data.abs_fn, 'none', algo,
+                  ram_base + PERF_BUF_A)
+    perf_load(u_boot_console, fn, ram_base + PERF_IMAGE)
+
+    output = u_boot_console.run_command('iminfo %x' % (ram_base + PERF_IMAGE))
+    assert algo + '+' in output
+    secs = perf_time(u_boot_console, 'iminfo %x' % (ram_base + PERF_IMAGE))
+    failed = perf_record(u_boot_console,
+                         'fit_verify_%s_%s' % (algo, perf_size(size)),
+                         perf_rate(secs, size), 'MiB/s')
+    assert not failed, failed
+
+@pytest.mark.buildconfigspec('fit')
+@pytest.mark.buildconfigspec('cmd_bootm')
+@pytest.mark.buildconfigspec('cmd_run')
+@pytest.mark.notbuildconfigspec('mesh_parser')
+@pytest.mark.parametrize('comp', ['gzip', 'lz4'])
+def test_perf_bootm_decompress(u_boot_console, comp):
+    """Time "bootm loados" decompressing a 4 MiB kernel."""
+
+    config = u_boot_console.config
+    if comp == 'lz4' and config.buildconfig.get('config_lz4', 'n') != 'y':
+        pytest.skip('.config feature not enabled')
+
+    # half random, half zeros, so that it compresses to about half
+    size = 4 << 20
+    raw = config.persistent_data_dir + '/perf-kernel.bin'
+    if not os.path.exists(raw):
+        with open(raw, 'wb') as fh:
+            fh.write(os.urandom(size // 2) + b'\x00' * (size // 2))
+    packed = raw + '.' + comp
+    if not os.path.exists(packed):
+        if comp == 'gzip':
+            with open(raw, 'rb') as fin:
+                fout = gzip.open(packed, 'wb')
+                fout.write(fin.read())
+                fout.close()
+        else:
+            u_boot_utils.run_and_log(u_boot_console,
+                                     ['lz4', '-9', '-f', raw, packed])
+
+    fn = 'perf-kernel-%s.itb' % comp
+    ram_base = u_boot_utils.find_ram_base(u_boot_console)
+    perf_make_fit(u_boot_console, fn, packed, comp, 'crc32',
+                  ram_base + PERF_BUF_A)
+    perf_load(u_boot_console, fn, ram_base + PERF_IMAGE)
+
+    secs = perf_time(u_boot_console, 'bootm start %x && bootm loados' %
+                     (ram_base + PERF_IMAGE))
+    output = u_boot_console.run_command('crc32 %x %x' %
+                                        (ram_base + PERF_BUF_A, size))
+    with open(raw, 'rb') as fh:
+        expected = '%08x' % (zlib.crc32(fh.read()) & 0xffffffff)
+    assert expected in output
+    failed = perf_record(u_boot_console,
+                         'bootm_%s_%s' % (comp, perf_size(size)),
+                         perf_rate(secs, size), 'MiB/s')
+    assert not failed, failed
+
+@pytest.mark.buildconfigspec('mesh_parser')
+def test_perf_mesh(u_boot_console):
+    """Time each command of the mesh shell."""
+
+    config = u_boot_console.config
+    min_time = config.env.get('env__perf_min_time', 0.5)
+    cmds = config.env.get('env__perf_mesh_cmds', ['help', 'list', 'query'])
+
+    failed = []
+    for cmd in cmds:
+        runs = 0
+        start = time.time()
+        while True:
+            u_boot_console.run_command(cmd)
+            runs += 1
+            secs = time.time() - start
+            if secs >= min_time:
+                break
+        failed.append(perf_record(u_boot_console,
+                                  'mesh_' + cmd.replace(' ', '_'),
+                                  secs * 1000 / runs, 'ms'))
+    failed = [msg for msg in failed if msg]
+    assert not failed, '; '.join(failed)
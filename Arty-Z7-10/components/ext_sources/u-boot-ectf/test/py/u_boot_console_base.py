@@ -23,6 +23,8 @@ pattern_stop_autoboot_prompt = re.compile('Hit any key to stop autoboot: ')
 pattern_unknown_command = re.compile('Unknown command \'.*\' - try \'help\'')
 pattern_error_notification = re.compile('## Error: ')
 pattern_error_please_reset = re.compile('### ERROR ### Please RESET the board ###')
+pattern_mesh_username = re.compile('Enter your username: ')
+pattern_mesh_pin = re.compile('Enter your PIN: ')
 
 PAT_ID = 0
 PAT_RE = 1
@@ -353,16 +355,24 @@ class ConsoleBase(object):
                 raise Exception('Bad pattern found on console: ' +
                                 self.bad_pattern_ids[m - 1])
             self.u_boot_version_string = self.p.after
+            mesh_logins = 0
             while True:
                 m = self.p.expect([self.prompt_compiled,
-                    pattern_stop_autoboot_prompt] + self.bad_patterns)
+                    pattern_stop_autoboot_prompt,
+                    pattern_mesh_username] + self.bad_patterns)
                 if m == 0:
                     break
                 if m == 1:
                     self.p.send(' ')
                     continue
+                if m == 2:
+                    if mesh_logins:
+                        raise Exception('mesh login failed')
+                    self.mesh_login()
+                    mesh_logins += 1
+                    continue
                 raise Exception('Bad pattern found on console: ' +
-                                self.bad_pattern_ids[m - 2])
+                                self.bad_pattern_ids[m - 3])
             self.at_prompt = True
             self.at_prompt_logevt = self.logstream.logfile.cur_evt
         except Exception as ex:
@@ -372,6 +382,36 @@ class ConsoleBase(object):
         finally:
             self.log.end_section('Starting U-Boot')
 
+    def mesh_login(self):
+        """Log in to the mesh shell, which replaces U-Boot's command line
+        on boards built with CONFIG_MESH_PARSER.
+
+        The user comes from env__mesh_user in the board environment, e.g.:
+
+        env__mesh_user = {
+            'name': 'demo',
+            'pin': '00000000',
+        }
+
+        This is an internal function and should not be called directly.
+
+        Args:
+            None.
+
+        Returns:
+            Nothing.
+        """
+
+        user = self.config.env.get('env__mesh_user', None)
+        if not user:
+            raise Exception('mesh shell found; set env__mesh_user to log in')
+        self.p.send(user['name'] + '\n')
+        m = self.p.expect([pattern_mesh_pin] + self.bad_patterns)
+        if m != 0:
+            raise Exception('Bad pattern found on console: ' +
+                            self.bad_pattern_ids[m - 1])
+        self.p.send(user['pin'] + '\n')
+
     def cleanup_spawn(self):
         """Shut down all interaction with the U-Boot instance.
 
@@ -0,0 +1,84 @@
+/*
+ * mesh-drm-bench.c: self-test and benchmark the mesh_drm registers
+ *
+ * MIT License, see libmeshdrm.bb
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "meshdrm.h"
+
+#define DEFAULT_ITERATIONS 100000
+
+static void usage(void) {
+    printf("usage: mesh-drm-bench [-h] [-M] [-s] [-d DEVICE] [-n ITERATIONS]\n"
+           "\n"
+           "Self-test the mesh_drm registers, then time accessing them.\n"
+           "\n"
+           "    -d DEVICE      UIO device (default " MESH_DRM_DEV ")\n"
+           "    -M             use registers in memory instead of a device\n"
+           "    -n ITERATIONS  writes and reads of every register to time\n"
+           "                   each way (default %d)\n"
+           "    -s             self-test only\n"
+           "    -h             this help\n", DEFAULT_ITERATIONS);
+}
+
+int main(int argc, char **argv) {
+    static uint32_t mock[MESH_DRM_NUM_REGS];
+    const char *path = MESH_DRM_DEV;
+    unsigned long iterations = DEFAULT_ITERATIONS;
+    int use_mock = 0, selftest_only = 0, opt, ret;
+    struct mesh_drm_bench res;
+    struct mesh_drm d;
+    char *end;
+
+    while ((opt = getopt(argc, argv, "hMsd:n:")) != -1) {
+        switch (opt) {
+        case 'd':
+            path = optarg;
+            break;
+        case 'M':
+            use_mock = 1;
+            break;
+        case 'n':
+            iterations = strtoul(optarg, &end, 0);
+            if (*end || iterations == 0) {
+                fprintf(stderr, "Bad iteration count: %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 's':
+            selftest_only = 1;
+            break;
+        case 'h':
+            usage();
+            return 0;
+        default:
+            usage();
+            return 2;
+        }
+    }
+
+    if (use_mock) {
+        mesh_drm_attach(&d, mock);
+    } else if (mesh_drm_open(&d, path) < 0) {
+        fprintf(stderr, "Couldn't map %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    ret = mesh_drm_selftest(&d);
+    if (ret == 0 && !selftest_only) {
+        mesh_drm_bench(&d, iterations, &res);
+        printf("%lu iterations, accesses/s:\n", res.iterations);
+        printf("  single   %12.0f\n", res.single);
+        printf("  relaxed  %12.0f\n", res.relaxed);
+        printf("  batch    %12.0f\n", res.batch);
+    }
+
+    mesh_drm_close(&d);
+    return ret ? 1 : 0;
+}
@@ -0,0 +1,210 @@
+/*
+ * meshdrm.c: userspace access to the mesh_drm registers
+ *
+ * MIT License, see libmeshdrm.bb
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "meshdrm.h"
+
+#define READ_WRITE_MUL_FACTOR 0x10  /* as in mesh_drm_selftest.c */
+
+/* Map the registers from region 0 of the UIO device at path */
+int mesh_drm_open(struct mesh_drm *d, const char *path) {
+    long page = sysconf(_SC_PAGESIZE);
+
+    memset(d, 0, sizeof(*d));
+    d->fd = open(path ? path : MESH_DRM_DEV, O_RDWR | O_SYNC | O_CLOEXEC);
+    if (d->fd < 0)
+        return -1;
+
+    /* Region 0 is selected by an mmap offset of 0 pages */
+    d->map_len = page;
+    d->base = mmap(NULL, d->map_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   d->fd, 0);
+    if (d->base == MAP_FAILED) {
+        int err = errno;
+
+        close(d->fd);
+        d->fd = -1;
+        errno = err;
+        return -1;
+    }
+    d->regs = d->base;
+    return 0;
+}
+
+/* Use MESH_DRM_REGS_SIZE bytes of other memory, such as a mock, instead */
+void mesh_drm_attach(struct mesh_drm *d, volatile void *regs) {
+    memset(d, 0, sizeof(*d));
+    d->fd = -1;
+    d->regs = regs;
+}
+
+void mesh_drm_close(struct mesh_drm *d) {
+    if (d->fd >= 0) {
+        munmap(d->base, d->map_len);
+        close(d->fd);
+    }
+    d->fd = -1;
+    d->regs = NULL;
+}
+
+/* Check that every offset in a batch is a register, before any access */
+static int mesh_drm_check(const struct mesh_drm_op *ops, size_t n) {
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        if (ops[i].offset % 4 || ops[i].offset >= MESH_DRM_REGS_SIZE) {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Write each register in ops in order, after all earlier accesses. Returns
+ * -1 with errno EINVAL, having written nothing, if an offset is not a
+ * register.
+ */
+int mesh_drm_write_batch(const struct mesh_drm *d,
+                         const struct mesh_drm_op *ops, size_t n) {
+    size_t i;
+
+    if (mesh_drm_check(ops, n) < 0)
+        return -1;
+    mesh_drm_barrier();
+    for (i = 0; i < n; i++)
+        mesh_drm_write_relaxed(d, ops[i].offset, ops[i].value);
+    return 0;
+}
+
+/*
+ * Read each register in ops in order into its value, before all later
+ * accesses. Returns -1 with errno EINVAL, having read nothing, if an offset
+ * is not a register.
+ */
+int mesh_drm_read_batch(const struct mesh_drm *d, struct mesh_drm_op *ops,
+                        size_t n) {
+    size_t i;
+
+    if (mesh_drm_check(ops, n) < 0)
+        return -1;
+    for (i = 0; i < n; i++)
+        ops[i].value = mesh_drm_read_relaxed(d, ops[i].offset);
+    mesh_drm_barrier();
+    return 0;
+}
+
+static void mesh_drm_all(struct mesh_drm_op *ops) {
+    int i;
+
+    for (i = 0; i < MESH_DRM_NUM_REGS; i++)
+        ops[i].offset = i * 4;
+}
+
+/*
+ * Write (i + 1) * 0x10 to register i and read every register back, like
+ * MESH_DRM_Reg_SelfTest does on the bare metal side. Unlike it, the
+ * registers are restored afterwards. Returns 0 if they all read back.
+ */
+int mesh_drm_selftest(const struct mesh_drm *d) {
+    struct mesh_drm_op saved[MESH_DRM_NUM_REGS], ops[MESH_DRM_NUM_REGS];
+    int i, ret = 0;
+
+    printf("******************************\n");
+    printf("* User Peripheral Self Test\n");
+    printf("******************************\n\n");
+    printf("User logic slave module test...\n");
+
+    mesh_drm_all(saved);
+    mesh_drm_read_batch(d, saved, MESH_DRM_NUM_REGS);
+
+    mesh_drm_all(ops);
+    for (i = 0; i < MESH_DRM_NUM_REGS; i++)
+        ops[i].value = (i + 1) * READ_WRITE_MUL_FACTOR;
+    mesh_drm_write_batch(d, ops, MESH_DRM_NUM_REGS);
+    for (i = 0; i < MESH_DRM_NUM_REGS; i++) {
+        if (mesh_drm_read(d, i * 4) != (uint32_t)(i + 1) *
+            READ_WRITE_MUL_FACTOR) {
+            printf("Error reading register value at offset %x\n", i * 4);
+            ret = -1;
+            break;
+        }
+    }
+
+    mesh_drm_write_batch(d, saved, MESH_DRM_NUM_REGS);
+    if (ret == 0)
+        printf("   - slave register write/read passed\n\n");
+    return ret;
+}
+
+static double mesh_drm_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Time iterations of writing and reading back every register, one access
+ * at a time with and without barriers, and as one batch each way. The
+ * registers are restored afterwards. Fills in res in accesses per second.
+ */
+int mesh_drm_bench(const struct mesh_drm *d, unsigned long iterations,
+                   struct mesh_drm_bench *res) {
+    struct mesh_drm_op saved[MESH_DRM_NUM_REGS], ops[MESH_DRM_NUM_REGS];
+    double accesses = 2.0 * MESH_DRM_NUM_REGS * iterations, t;
+    volatile uint32_t sink;
+    unsigned long n;
+    uint32_t r;
+
+    if (iterations == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    memset(res, 0, sizeof(*res));
+    res->iterations = iterations;
+    mesh_drm_all(saved);
+    mesh_drm_read_batch(d, saved, MESH_DRM_NUM_REGS);
+
+    t = mesh_drm_now();
+    for (n = 0; n < iterations; n++) {
+        for (r = 0; r < MESH_DRM_REGS_SIZE; r += 4)
+            mesh_drm_write(d, r, n);
+        for (r = 0; r < MESH_DRM_REGS_SIZE; r += 4)
+            sink = mesh_drm_read(d, r);
+    }
+    res->single = accesses / (mesh_drm_now() - t);
+
+    t = mesh_drm_now();
+    for (n = 0; n < iterations; n++) {
+        for (r = 0; r < MESH_DRM_REGS_SIZE; r += 4)
+            mesh_drm_write_relaxed(d, r, n);
+        for (r = 0; r < MESH_DRM_REGS_SIZE; r += 4)
+            sink = mesh_drm_read_relaxed(d, r);
+    }
+    res->relaxed = accesses / (mesh_drm_now() - t);
+
+    mesh_drm_all(ops);
+    t = mesh_drm_now();
+    for (n = 0; n < iterations; n++) {
+        for (r = 0; r < MESH_DRM_NUM_REGS; r++)
+            ops[r].value = n;
+        mesh_drm_write_batch(d, ops, MESH_DRM_NUM_REGS);
+        mesh_drm_read_batch(d, ops, MESH_DRM_NUM_REGS);
+    }
+    res->batch = accesses / (mesh_drm_now() - t);
+    (void)sink;
+
+    mesh_drm_write_batch(d, saved, MESH_DRM_NUM_REGS);
+    return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * meshdrm.h: userspace access to the mesh_drm registers
+ *
+ * The mesh_drm IP has four 32 bit AXI slave registers. On Linux its UIO
+ * node is renamed to /dev/mesh_drm by startup.sh, and region 0 of it maps
+ * the registers. mesh_drm_open() maps them; mesh_drm_attach() uses any
+ * other memory instead, so that code using this library can be run
+ * against a mock in tests.
+ *
+ * The accessors order each access against all other memory accesses with a
+ * barrier. The _relaxed accessors do not, and the batch functions issue one
+ * barrier for the whole batch, which is enough when the registers are only
+ * used by one thread and the order among the batch does not matter beyond
+ * program order (device memory is not reordered against itself).
+ *
+ * MIT License, see libmeshdrm.bb
+ */
+
+#ifndef MESHDRM_H
+#define MESHDRM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MESH_DRM_DEV "/dev/mesh_drm"
+
+/* Register offsets, as in the mesh_drm_v1_0 driver's mesh_drm.h */
+#define MESH_DRM_S00_AXI_SLV_REG0_OFFSET 0
+#define MESH_DRM_S00_AXI_SLV_REG1_OFFSET 4
+#define MESH_DRM_S00_AXI_SLV_REG2_OFFSET 8
+#define MESH_DRM_S00_AXI_SLV_REG3_OFFSET 12
+
+#define MESH_DRM_NUM_REGS 4
+#define MESH_DRM_REGS_SIZE (MESH_DRM_NUM_REGS * 4)
+
+/* The registers, mapped from the device or attached to a mock */
+struct mesh_drm {
+    int fd;                  /* -1 when attached */
+    void *base;              /* what mmap returned */
+    size_t map_len;
+    volatile uint32_t *regs;
+};
+
+/* One register access in a batch; value is read into for reads */
+struct mesh_drm_op {
+    uint32_t offset;
+    uint32_t value;
+};
+
+/* Accesses per second of each way of accessing the registers */
+struct mesh_drm_bench {
+    unsigned long iterations;
+    double single;           /* barriered write and read of each register */
+    double relaxed;          /* the same without barriers */
+    double batch;            /* one batch write and one batch read */
+};
+
+int mesh_drm_open(struct mesh_drm *d, const char *path);
+void mesh_drm_attach(struct mesh_drm *d, volatile void *regs);
+void mesh_drm_close(struct mesh_drm *d);
+
+static inline void mesh_drm_barrier(void) {
+    __sync_synchronize();
+}
+
+static inline uint32_t mesh_drm_read_relaxed(const struct mesh_drm *d,
+                                             uint32_t offset) {
+    return d->regs[offset / 4];
+}
+
+static inline void mesh_drm_write_relaxed(const struct mesh_drm *d,
+                                          uint32_t offset, uint32_t value) {
+    d->regs[offset / 4] = value;
+}
+
+/* Read a register; later accesses happen after it */
+static inline uint32_t mesh_drm_read(const struct mesh_drm *d,
+                                     uint32_t offset) {
+    uint32_t value = mesh_drm_read_relaxed(d, offset);
+
+    mesh_drm_barrier();
+    return value;
+}
+
+/* Write a register; earlier accesses happen before it */
+static inline void mesh_drm_write(const struct mesh_drm *d, uint32_t offset,
+                                  uint32_t value) {
+    mesh_drm_barrier();
+    mesh_drm_write_relaxed(d, offset, value);
+}
+
+int mesh_drm_write_batch(const struct mesh_drm *d,
+                         const struct mesh_drm_op *ops, size_t n);
+int mesh_drm_read_batch(const struct mesh_drm *d, struct mesh_drm_op *ops,
+                        size_t n);
+
+int mesh_drm_selftest(const struct mesh_drm *d);
+int mesh_drm_bench(const struct mesh_drm *d, unsigned long iterations,
+                   struct mesh_drm_bench *res);
+
+#endif /* MESHDRM_H */
@@ -0,0 +1,221 @@
+/*
+ * pwm-stream.c: stream a PWM waveform from a file or a generator
+ *
+ * Samples are read one per line as "<period> <duty0> ... <duty5>", in PWM
+ * clocks; duties left out keep their value from the line before. With -g
+ * a triangle wave of the given frequency is generated on every channel
+ * instead, for -t seconds.
+ *
+ * MIT License, see libpwmstream.bb
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "pwmstream.h"
+
+#define DEFAULT_PERIOD 4096         /* PWM clocks */
+#define CHUNK 64
+
+static void usage(void) {
+    printf("usage: pwm-stream [-h] [-M] [-D] [-d DEVICE] [-r HZ] [-n SAMPLES]\n"
+           "                  [-c MASK] [-p PRIO] [-a CPU]\n"
+           "                  [-g HZ [-t SECONDS] [-P PERIOD] | FILE]\n"
+           "\n"
+           "Stream PWM samples to the PWM registers at a fixed rate.\n"
+           "\n"
+           "    -d DEVICE   UIO device (default " PWM_DEV ")\n"
+           "    -M          use registers in memory instead of a device\n"
+           "    -r HZ       samples per second (default 1000)\n"
+           "    -n SAMPLES  ring size, a power of two (default 1024)\n"
+           "    -c MASK     channels to write (default 0x3f)\n"
+           "    -p PRIO     run the streaming thread SCHED_FIFO at PRIO\n"
+           "    -a CPU      pin the streaming thread to CPU\n"
+           "    -D          disable the PWM when done\n"
+           "    -g HZ       generate a triangle wave of HZ\n"
+           "    -t SECONDS  how long to generate for (default 1)\n"
+           "    -P PERIOD   PWM period to generate with (default %d)\n"
+           "    FILE        samples to stream, or - for stdin\n"
+           "    -h          this help\n", DEFAULT_PERIOD);
+}
+
+/* Fill samples of the wave in place in the ring, n at a time */
+static void generate(struct pwm_stream *s, double hz, double seconds,
+                     uint32_t period) {
+    unsigned long total = seconds * s->opts.rate_hz, i = 0;
+    struct timespec wait = { 0, 1000000 };
+    struct pwm_sample *dst;
+    unsigned got, j, ch;
+    double phase;
+
+    while (i < total) {
+        got = pwm_stream_reserve(s, &dst, total - i < CHUNK ?
+                                 total - i : CHUNK);
+        if (got == 0) {
+            nanosleep(&wait, NULL);
+            continue;
+        }
+        for (j = 0; j < got; j++, i++) {
+            phase = hz * i / s->opts.rate_hz;
+            phase -= (unsigned long)phase;
+            dst[j].period = period;
+            for (ch = 0; ch < PWM_NUM_CHANNELS; ch++)
+                dst[j].duty[ch] = period * (phase < 0.5 ? 2 * phase :
+                                            2 - 2 * phase);
+        }
+        pwm_stream_commit(s, got);
+    }
+}
+
+/* Read samples from f and queue them; returns -1 on a bad line */
+static int read_samples(struct pwm_stream *s, FILE *f) {
+    struct pwm_sample buf[CHUNK], cur;
+    unsigned long lineno = 0, value;
+    char line[256], *tok, *end;
+    unsigned n = 0;
+    int field;
+
+    memset(&cur, 0, sizeof(cur));
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        line[strcspn(line, "#\n")] = '\0';
+        field = 0;
+        for (tok = strtok(line, " \t,"); tok; tok = strtok(NULL, " \t,")) {
+            value = strtoul(tok, &end, 0);
+            if (*end || field > PWM_NUM_CHANNELS) {
+                fprintf(stderr, "Bad sample on line %lu\n", lineno);
+                return -1;
+            }
+            if (field == 0)
+                cur.period = value;
+            else
+                cur.duty[field - 1] = value;
+            field++;
+        }
+        if (field == 0)
+            continue;
+        buf[n++] = cur;
+        if (n == CHUNK) {
+            pwm_stream_write(s, buf, n);
+            n = 0;
+        }
+    }
+    pwm_stream_write(s, buf, n);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    static uint32_t mock[PWM_REGS_SIZE / 4];
+    const char *path = PWM_DEV;
+    double hz = 0, seconds = 1;
+    uint32_t period = DEFAULT_PERIOD;
+    struct pwm_stream_opts opts;
+    struct pwm_stream_stats st;
+    struct pwm_stream s;
+    int use_mock = 0, opt, ret = 0;
+    FILE *f = NULL;
+    unsigned ch;
+
+    pwm_stream_default_opts(&opts);
+    while ((opt = getopt(argc, argv, "hMDd:r:n:c:p:a:g:t:P:")) != -1) {
+        switch (opt) {
+        case 'd':
+            path = optarg;
+            break;
+        case 'M':
+            use_mock = 1;
+            break;
+        case 'D':
+            opts.disable_at_stop = 1;
+            break;
+        case 'r':
+            opts.rate_hz = strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            opts.ring_samples = strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            opts.channels = strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            opts.fifo_prio = atoi(optarg);
+            break;
+        case 'a':
+            opts.cpu = atoi(optarg);
+            break;
+        case 'g':
+            hz = atof(optarg);
+            break;
+        case 't':
+            seconds = atof(optarg);
+            break;
+        case 'P':
+            period = strtoul(optarg, NULL, 0);
+            break;
+        case 'h':
+            usage();
+            return 0;
+        default:
+            usage();
+            return 2;
+        }
+    }
+    if ((hz > 0) == (optind < argc)) {
+        usage();
+        return 2;
+    }
+    if (optind < argc) {
+        f = strcmp(argv[optind], "-") ? fopen(argv[optind], "r") : stdin;
+        if (!f) {
+            fprintf(stderr, "Couldn't open %s: %s\n", argv[optind],
+                    strerror(errno));
+            return 1;
+        }
+    }
+
+    if (use_mock)
+        ret = pwm_stream_attach(&s, mock, &opts);
+    else
+        ret = pwm_stream_open(&s, path, &opts);
+    if (ret < 0) {
+        fprintf(stderr, "Couldn't set up %s: %s\n",
+                use_mock ? "the mock registers" : path, strerror(errno));
+        return 1;
+    }
+    if (pwm_stream_start(&s) < 0) {
+        fprintf(stderr, "Couldn't start streaming: %s\n", strerror(errno));
+        pwm_stream_close(&s);
+        return 1;
+    }
+
+    if (f)
+        ret = read_samples(&s, f);
+    else
+        generate(&s, hz, seconds, period);
+    pwm_stream_stop(&s, ret == 0);
+
+    pwm_stream_get_stats(&s, &st);
+    printf("ticks %llu played %llu underruns %llu skipped %llu writes %llu\n",
+           (unsigned long long)st.ticks, (unsigned long long)st.played,
+           (unsigned long long)st.underruns, (unsigned long long)st.skipped,
+           (unsigned long long)st.writes);
+    printf("late mean %llu ns max %llu ns\n",
+           (unsigned long long)(st.ticks ? st.total_late_ns / st.ticks : 0),
+           (unsigned long long)st.max_late_ns);
+    if (use_mock) {
+        printf("ctrl %u period %u duty", mock[PWM_AXI_CTRL_REG_OFFSET / 4],
+               mock[PWM_AXI_PERIOD_REG_OFFSET / 4]);
+        for (ch = 0; ch < PWM_NUM_CHANNELS; ch++)
+            printf(" %u", mock[PWM_AXI_DUTY_REG_OFFSET / 4 + ch]);
+        printf("\n");
+    }
+
+    pwm_stream_close(&s);
+    if (f && f != stdin)
+        fclose(f);
+    return ret ? 1 : 0;
+}
@@ -0,0 +1,333 @@
+/*
+ * pwmstream.c: stream PWM waveforms to the PWM_v1_0 registers
+ *
+ * MIT License, see libpwmstream.bb
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "pwmstream.h"
+
+#define NS_PER_SEC 1000000000ull
+
+#define STOP_NOW 1
+#define STOP_DRAINED 2
+
+#define LOAD(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define STORE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define STAT_ADD(s, field, v) \
+    __atomic_store_n(&(s)->stats.field, (s)->stats.field + (v), \
+                     __ATOMIC_RELAXED)
+
+static uint64_t pwm_stream_ns(const struct timespec *ts) {
+    return (uint64_t)ts->tv_sec * NS_PER_SEC + ts->tv_nsec;
+}
+
+static uint32_t pwm_reg_read(const struct pwm_stream *s, uint32_t offset) {
+    return s->regs[offset / 4];
+}
+
+static void pwm_reg_write(struct pwm_stream *s, uint32_t offset,
+                          uint32_t value) {
+    s->regs[offset / 4] = value;
+}
+
+void pwm_stream_default_opts(struct pwm_stream_opts *opts) {
+    memset(opts, 0, sizeof(*opts));
+    opts->rate_hz = 1000;
+    opts->ring_samples = 1024;
+    opts->channels = (1u << PWM_NUM_CHANNELS) - 1;
+    opts->cpu = -1;
+}
+
+/* Set up everything but the registers, which are already mapped */
+static int pwm_stream_init(struct pwm_stream *s,
+                           const struct pwm_stream_opts *opts) {
+    unsigned ch;
+
+    if (opts->rate_hz == 0 || opts->rate_hz > NS_PER_SEC ||
+        opts->ring_samples < 2 ||
+        (opts->ring_samples & (opts->ring_samples - 1)) ||
+        opts->channels == 0 || opts->channels >> PWM_NUM_CHANNELS) {
+        errno = EINVAL;
+        return -1;
+    }
+    s->opts = *opts;
+    s->period_ns = NS_PER_SEC / opts->rate_hz;
+    s->mask = opts->ring_samples - 1;
+
+    s->ring = malloc(opts->ring_samples * sizeof(*s->ring));
+    if (!s->ring)
+        return -1;
+    /* fault the ring in now rather than on the streaming thread */
+    memset(s->ring, 0, opts->ring_samples * sizeof(*s->ring));
+    mlock(s->ring, opts->ring_samples * sizeof(*s->ring));
+
+    /* samples are written as changes from what the registers hold now */
+    s->last.period = pwm_reg_read(s, PWM_AXI_PERIOD_REG_OFFSET);
+    for (ch = 0; ch < PWM_NUM_CHANNELS; ch++)
+        s->last.duty[ch] = pwm_reg_read(s, PWM_AXI_DUTY_REG_OFFSET + 4 * ch);
+    return 0;
+}
+
+/* Map the registers from region 0 of the UIO device at path */
+int pwm_stream_open(struct pwm_stream *s, const char *path,
+                    const struct pwm_stream_opts *opts) {
+    int err;
+
+    memset(s, 0, sizeof(*s));
+    s->fd = open(path ? path : PWM_DEV, O_RDWR | O_SYNC | O_CLOEXEC);
+    if (s->fd < 0)
+        return -1;
+    s->map_len = sysconf(_SC_PAGESIZE);
+    s->base = mmap(NULL, s->map_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   s->fd, 0);
+    if (s->base == MAP_FAILED) {
+        err = errno;
+        close(s->fd);
+        errno = err;
+        return -1;
+    }
+    s->regs = s->base;
+    if (pwm_stream_init(s, opts) < 0) {
+        err = errno;
+        munmap(s->base, s->map_len);
+        close(s->fd);
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+/* Use PWM_REGS_SIZE bytes of other memory, such as a mock, instead */
+int pwm_stream_attach(struct pwm_stream *s, volatile void *regs,
+                      const struct pwm_stream_opts *opts) {
+    memset(s, 0, sizeof(*s));
+    s->fd = -1;
+    s->regs = regs;
+    return pwm_stream_init(s, opts);
+}
+
+void pwm_stream_close(struct pwm_stream *s) {
+    if (s->running)
+        pwm_stream_stop(s, 0);
+    if (s->fd >= 0) {
+        munmap(s->base, s->map_len);
+        close(s->fd);
+    }
+    munlock(s->ring, s->opts.ring_samples * sizeof(*s->ring));
+    free(s->ring);
+    s->ring = NULL;
+    s->regs = NULL;
+}
+
+/* Write what changed from the last sample, with one barrier for them all */
+static void pwm_stream_play(struct pwm_stream *s,
+                            const struct pwm_sample *sample) {
+    unsigned ch, writes = 0;
+
+    __sync_synchronize();
+    if (sample->period != s->last.period) {
+        pwm_reg_write(s, PWM_AXI_PERIOD_REG_OFFSET, sample->period);
+        s->last.period = sample->period;
+        writes++;
+    }
+    for (ch = 0; ch < PWM_NUM_CHANNELS; ch++) {
+        if (!(s->opts.channels & (1u << ch)) ||
+            sample->duty[ch] == s->last.duty[ch])
+            continue;
+        pwm_reg_write(s, PWM_AXI_DUTY_REG_OFFSET + 4 * ch, sample->duty[ch]);
+        s->last.duty[ch] = sample->duty[ch];
+        writes++;
+    }
+    STAT_ADD(s, played, 1);
+    STAT_ADD(s, writes, writes);
+}
+
+static void *pwm_stream_thread(void *arg) {
+    struct pwm_stream *s = arg;
+    struct timespec next, now;
+    uint64_t deadline, late, missed, skip;
+    unsigned tail = s->tail, queued;
+    int stop;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    deadline = pwm_stream_ns(&now);
+    for (;;) {
+        deadline += s->period_ns;
+        next.tv_sec = deadline / NS_PER_SEC;
+        next.tv_nsec = deadline % NS_PER_SEC;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next,
+                               NULL) == EINTR)
+            ;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        late = pwm_stream_ns(&now) - deadline;
+
+        stop = LOAD(&s->stop);
+        if (stop == STOP_NOW)
+            break;
+        queued = LOAD(&s->head) - tail;
+
+        /* catch up with the deadlines passed while we weren't running */
+        missed = late / s->period_ns;
+        if (missed) {
+            deadline += missed * s->period_ns;
+            skip = missed < queued ? missed : queued;
+            tail += skip;
+            queued -= skip;
+            STORE(&s->tail, tail);
+            STAT_ADD(s, skipped, skip);
+        }
+        STAT_ADD(s, ticks, 1 + missed);
+        STAT_ADD(s, total_late_ns, late);
+        if (late > s->stats.max_late_ns)
+            __atomic_store_n(&s->stats.max_late_ns, late, __ATOMIC_RELAXED);
+
+        if (queued == 0) {
+            if (stop == STOP_DRAINED)
+                break;
+            STAT_ADD(s, underruns, 1);
+            continue;
+        }
+        pwm_stream_play(s, &s->ring[tail & s->mask]);
+        STORE(&s->tail, ++tail);
+    }
+    return NULL;
+}
+
+/*
+ * Enable the PWM and start the streaming thread, with the scheduling asked
+ * for. Returns -1 with errno set if the thread couldn't be created, EPERM
+ * most likely meaning SCHED_FIFO isn't allowed.
+ */
+int pwm_stream_start(struct pwm_stream *s) {
+    struct sched_param sp;
+    pthread_attr_t attr;
+    cpu_set_t set;
+    int err;
+
+    if (s->running) {
+        errno = EBUSY;
+        return -1;
+    }
+    pthread_attr_init(&attr);
+    if (s->opts.fifo_prio) {
+        sp.sched_priority = s->opts.fifo_prio;
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        pthread_attr_setschedparam(&attr, &sp);
+    }
+    if (s->opts.cpu >= 0) {
+        CPU_ZERO(&set);
+        CPU_SET(s->opts.cpu, &set);
+        pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+    }
+
+    pwm_reg_write(s, PWM_AXI_CTRL_REG_OFFSET, 1);
+    s->stop = 0;
+    err = pthread_create(&s->thread, &attr, pwm_stream_thread, s);
+    pthread_attr_destroy(&attr);
+    if (err) {
+        errno = err;
+        return -1;
+    }
+    s->running = 1;
+    return 0;
+}
+
+/*
+ * Stop the streaming thread, once every queued sample has been played if
+ * drain is set, else at the next tick.
+ */
+int pwm_stream_stop(struct pwm_stream *s, int drain) {
+    if (!s->running) {
+        errno = EINVAL;
+        return -1;
+    }
+    STORE(&s->stop, drain ? STOP_DRAINED : STOP_NOW);
+    pthread_join(s->thread, NULL);
+    s->running = 0;
+    if (s->opts.disable_at_stop)
+        pwm_reg_write(s, PWM_AXI_CTRL_REG_OFFSET, 0);
+    return 0;
+}
+
+/* Samples that can be queued now */
+unsigned pwm_stream_space(const struct pwm_stream *s) {
+    return s->mask + 1 - (s->head - LOAD(&s->tail));
+}
+
+/* Samples queued but not yet played */
+unsigned pwm_stream_queued(const struct pwm_stream *s) {
+    return s->head - LOAD(&s->tail);
+}
+
+/*
+ * Reserve up to want samples at the end of the queue, to be filled in place
+ * and then queued with pwm_stream_commit(). Returns how many samples there
+ * are at *samples, fewer than want when the ring is nearly full or wraps.
+ */
+unsigned pwm_stream_reserve(struct pwm_stream *s, struct pwm_sample **samples,
+                            unsigned want) {
+    unsigned space = pwm_stream_space(s);
+    unsigned to_end = s->mask + 1 - (s->head & s->mask);
+
+    if (space > to_end)
+        space = to_end;
+    *samples = &s->ring[s->head & s->mask];
+    return want < space ? want : space;
+}
+
+/* Queue n samples filled in after pwm_stream_reserve() */
+void pwm_stream_commit(struct pwm_stream *s, unsigned n) {
+    STORE(&s->head, s->head + n);
+}
+
+/*
+ * Queue a copy of n samples, waiting for space while the stream is running.
+ * Returns how many were queued, fewer than n only if it is not running.
+ */
+size_t pwm_stream_write(struct pwm_stream *s, const struct pwm_sample *samples,
+                        size_t n) {
+    struct timespec wait = { 0, 0 };
+    struct pwm_sample *dst;
+    size_t done = 0;
+    unsigned got;
+
+    wait.tv_nsec = s->period_ns < NS_PER_SEC ? s->period_ns : NS_PER_SEC - 1;
+    while (done < n) {
+        got = pwm_stream_reserve(s, &dst, n - done > s->mask + 1 ?
+                                 s->mask + 1 : n - done);
+        if (got == 0) {
+            if (!s->running)
+                break;
+            nanosleep(&wait, NULL);
+            continue;
+        }
+        memcpy(dst, samples + done, got * sizeof(*dst));
+        pwm_stream_commit(s, got);
+        done += got;
+    }
+    return done;
+}
+
+void pwm_stream_get_stats(const struct pwm_stream *s,
+                          struct pwm_stream_stats *stats) {
+    stats->ticks = __atomic_load_n(&s->stats.ticks, __ATOMIC_RELAXED);
+    stats->played = __atomic_load_n(&s->stats.played, __ATOMIC_RELAXED);
+    stats->underruns = __atomic_load_n(&s->stats.underruns, __ATOMIC_RELAXED);
+    stats->skipped = __atomic_load_n(&s->stats.skipped, __ATOMIC_RELAXED);
+    stats->writes = __atomic_load_n(&s->stats.writes, __ATOMIC_RELAXED);
+    stats->max_late_ns = __atomic_load_n(&s->stats.max_late_ns,
+                                         __ATOMIC_RELAXED);
+    stats->total_late_ns = __atomic_load_n(&s->stats.total_late_ns,
+                                           __ATOMIC_RELAXED);
+}
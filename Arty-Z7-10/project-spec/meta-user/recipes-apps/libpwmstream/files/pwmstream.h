@@ -0,0 +1,108 @@
+/*
+ * pwmstream.h: stream PWM waveforms to the PWM_v1_0 registers
+ *
+ * PWM_0 is a generic-uio device, renamed to /dev/pwm by startup.sh. Its
+ * registers are a control register, a period register and a duty register
+ * per channel, all counted in PWM clocks, as in the driver's PWM.h.
+ *
+ * A stream plays samples of period and duties at a fixed rate from its own
+ * thread, which sleeps to absolute CLOCK_MONOTONIC deadlines so that
+ * lateness never accumulates, and can be pinned to a CPU and run SCHED_FIFO.
+ * Samples are queued in a single producer, single consumer ring. Producers
+ * reserve space in it, fill the samples in place and commit them, so no
+ * sample is copied between the producer and the registers; filling one part
+ * of the ring while the thread plays another is the usual double buffering,
+ * with as many buffers as fit.
+ *
+ * When the ring runs dry the registers keep the last sample and an underrun
+ * is counted. When the thread wakes more than one tick late the samples for
+ * the ticks it missed are skipped, keeping the waveform in time, and counted.
+ *
+ * MIT License, see libpwmstream.bb
+ */
+
+#ifndef PWMSTREAM_H
+#define PWMSTREAM_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PWM_DEV "/dev/pwm"
+
+/* Register offsets, as in the PWM_v1_0 driver's PWM.h */
+#define PWM_AXI_CTRL_REG_OFFSET 0
+#define PWM_AXI_PERIOD_REG_OFFSET 8
+#define PWM_AXI_DUTY_REG_OFFSET 64
+
+#define PWM_NUM_CHANNELS 6          /* NUM_PWM of PWM_0 */
+#define PWM_REGS_SIZE 128           /* C_PWM_AXI_ADDR_WIDTH of 7 */
+
+/* What to write on one tick; a duty or period is only written if changed */
+struct pwm_sample {
+    uint32_t period;
+    uint32_t duty[PWM_NUM_CHANNELS];
+};
+
+struct pwm_stream_opts {
+    unsigned long rate_hz;      /* samples per second */
+    unsigned ring_samples;      /* a power of two */
+    unsigned channels;          /* mask of the duties to write */
+    int fifo_prio;              /* SCHED_FIFO priority, or 0 to not change */
+    int cpu;                    /* CPU to pin the thread to, or -1 */
+    int disable_at_stop;        /* write 0 to the control register at stop */
+};
+
+struct pwm_stream_stats {
+    uint64_t ticks;             /* deadlines passed */
+    uint64_t played;            /* samples written to the registers */
+    uint64_t underruns;         /* ticks with no sample queued */
+    uint64_t skipped;           /* samples skipped for ticks missed */
+    uint64_t writes;            /* register writes */
+    uint64_t max_late_ns;       /* latest wake after a deadline */
+    uint64_t total_late_ns;
+};
+
+struct pwm_stream {
+    int fd;                     /* -1 when attached */
+    void *base;
+    size_t map_len;
+    volatile uint32_t *regs;
+
+    struct pwm_stream_opts opts;
+    uint64_t period_ns;
+    struct pwm_sample *ring;
+    unsigned mask;
+    unsigned head;              /* written only by the producer */
+    unsigned tail;              /* written only by the thread */
+    struct pwm_sample last;     /* what the registers hold */
+
+    pthread_t thread;
+    int running;
+    int stop;
+    struct pwm_stream_stats stats;
+};
+
+void pwm_stream_default_opts(struct pwm_stream_opts *opts);
+
+int pwm_stream_open(struct pwm_stream *s, const char *path,
+                    const struct pwm_stream_opts *opts);
+int pwm_stream_attach(struct pwm_stream *s, volatile void *regs,
+                      const struct pwm_stream_opts *opts);
+void pwm_stream_close(struct pwm_stream *s);
+
+int pwm_stream_start(struct pwm_stream *s);
+int pwm_stream_stop(struct pwm_stream *s, int drain);
+
+unsigned pwm_stream_space(const struct pwm_stream *s);
+unsigned pwm_stream_queued(const struct pwm_stream *s);
+unsigned pwm_stream_reserve(struct pwm_stream *s, struct pwm_sample **samples,
+                            unsigned want);
+void pwm_stream_commit(struct pwm_stream *s, unsigned n);
+size_t pwm_stream_write(struct pwm_stream *s, const struct pwm_sample *samples,
+                        size_t n);
+
+void pwm_stream_get_stats(const struct pwm_stream *s,
+                          struct pwm_stream_stats *stats);
+
+#endif /* PWMSTREAM_H */
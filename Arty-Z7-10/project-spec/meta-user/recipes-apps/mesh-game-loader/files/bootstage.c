@@ -0,0 +1,131 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "bootstage.h"
+
+// these match common/bootstage.c in U-Boot, which is built for 32-bit ARM
+#define BOOTSTAGE_VERSION 0
+#define BOOTSTAGE_MAGIC 0xb00757a3
+
+// name of the record U-Boot marks right before jumping to the kernel
+#define BOOTSTAGE_HANDOFF_NAME "start_kernel"
+
+// ids given to records appended from Linux, well clear of U-Boot's
+#define BOOTSTAGE_LINUX_ID 0x1000
+
+struct bootstage_hdr {
+    uint32_t version;
+    uint32_t count;
+    uint32_t size;
+    uint32_t magic;
+};
+
+struct bootstage_record {
+    uint32_t time_us;
+    uint32_t start_us;
+    uint32_t name;      // U-Boot pointer, meaningless here
+    int32_t flags;
+    uint32_t id;
+};
+
+// this function validates the stash header and returns it, or NULL if U-Boot
+// did not leave a usable stash behind
+static struct bootstage_hdr *bootstage_header(unsigned char *stash, unsigned int size)
+{
+    struct bootstage_hdr *hdr = (struct bootstage_hdr *) stash;
+
+    if (size < sizeof(*hdr) ||
+        hdr->magic != BOOTSTAGE_MAGIC ||
+        hdr->version != BOOTSTAGE_VERSION ||
+        hdr->size > size ||
+        sizeof(*hdr) + hdr->count * sizeof(struct bootstage_record) > hdr->size) {
+        return NULL;
+    }
+
+    return hdr;
+}
+
+// this function finds the time U-Boot handed off to the kernel. Names are
+// stored in record order after the last record.
+static uint32_t bootstage_handoff_us(struct bootstage_hdr *hdr)
+{
+    struct bootstage_record *rec = (struct bootstage_record *) (hdr + 1);
+    char *name = (char *) (rec + hdr->count);
+    char *end = (char *) hdr + hdr->size;
+
+    for (uint32_t i = 0; i < hdr->count && name < end; i++) {
+        if (strcmp(name, BOOTSTAGE_HANDOFF_NAME) == 0) {
+            return rec[i].time_us;
+        }
+        name += strnlen(name, end - name) + 1;
+    }
+
+    return 0;
+}
+
+/*
+    This function appends a mark called name to the bootstage stash left by
+    U-Boot. Linux resets the global timer when it takes it over, so the mark
+    is the U-Boot handoff time plus CLOCK_MONOTONIC, which starts counting
+    shortly after the kernel is entered.
+
+    Returns 0 on success, -1 if there is no stash or no space left in it.
+*/
+int bootstage_append(unsigned char *stash, unsigned int size, const char *name)
+{
+    struct bootstage_hdr *hdr = bootstage_header(stash, size);
+    struct bootstage_record rec;
+    struct timespec ts;
+    unsigned char *names;
+    unsigned int name_len = strlen(name) + 1;
+
+    if (hdr == NULL) {
+        return -1;
+    }
+    if (hdr->size + sizeof(rec) + name_len > size) {
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    memset(&rec, 0, sizeof(rec));
+    rec.time_us = bootstage_handoff_us(hdr) + ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    rec.id = BOOTSTAGE_LINUX_ID + hdr->count;
+
+    // make room for the record in front of the names, then add the name
+    names = stash + sizeof(*hdr) + hdr->count * sizeof(rec);
+    memmove(names + sizeof(rec), names, stash + hdr->size - names);
+    memcpy(names, &rec, sizeof(rec));
+    memcpy(stash + hdr->size + sizeof(rec), name, name_len);
+
+    hdr->count++;
+    hdr->size += sizeof(rec) + name_len;
+
+    return 0;
+}
+
+/*
+    This function writes the stash to path so it can be copied off the board
+    and rendered with tools/bootstageReport.py.
+*/
+int bootstage_save(unsigned char *stash, const char *path)
+{
+    struct bootstage_hdr *hdr = bootstage_header(stash, BOOTSTAGE_SIZE);
+    FILE *fp;
+    size_t written;
+
+    if (hdr == NULL) {
+        return -1;
+    }
+
+    fp = fopen(path, "wb");
+    if (fp == NULL) {
+        return -1;
+    }
+    written = fwrite(stash, 1, hdr->size, fp);
+    fclose(fp);
+
+    return written == hdr->size ? 0 : -1;
+}
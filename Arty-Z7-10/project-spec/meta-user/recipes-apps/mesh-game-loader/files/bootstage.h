@@ -0,0 +1,19 @@
+#ifndef __BOOTSTAGE_H__
+#define __BOOTSTAGE_H__
+
+// offset of the U-Boot bootstage stash from the start of the reserved ddr
+// region. zynq_ectf_defconfig puts the stash in the page below the region,
+// and U-Boot reserves it as a bootstage@<addr> node of its own. The stash
+// is only used if its header checks out.
+#define BOOTSTAGE_OFFSET (-0x1000)
+
+// CONFIG_BOOTSTAGE_STASH_SIZE
+#define BOOTSTAGE_SIZE 0x1000
+
+// where the combined U-Boot and Linux timeline is saved for collection
+#define BOOTSTAGE_PATH "/tmp/bootstage.bin"
+
+int bootstage_append(unsigned char *stash, unsigned int size, const char *name);
+int bootstage_save(unsigned char *stash, const char *path);
+
+#endif
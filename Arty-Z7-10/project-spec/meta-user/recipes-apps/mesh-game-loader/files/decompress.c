@@ -0,0 +1,156 @@
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "decompress.h"
+#include "handoff.h"
+
+// decompressed data is written out in pieces of this size
+#define OUT_SIZE 0x40000
+
+static unsigned char out_buf[OUT_SIZE] __attribute__((aligned(64)));
+
+// this function writes len bytes to fd, retrying short writes
+static int write_all(int fd, const unsigned char *buf, size_t len)
+{
+    ssize_t written;
+
+    while (len > 0) {
+        written = write(fd, buf, len);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf += written;
+        len -= written;
+    }
+
+    return 0;
+}
+
+/*
+    This function sets up d to write a payload stored with codec to fd.
+
+    Returns 0 on success, -1 if the codec is unknown or cannot be set up.
+*/
+int decompress_init(struct decompress *d, uint32_t codec, int fd)
+{
+    memset(d, 0, sizeof(*d));
+    d->codec = codec;
+    d->fd = fd;
+
+    switch (codec) {
+    case MESH_HANDOFF_COMP_NONE:
+        return 0;
+    case MESH_HANDOFF_COMP_GZIP:
+        // 16 + MAX_WBITS: expect a gzip header, as written by gzip
+        return inflateInit2(&d->zs, 16 + MAX_WBITS) == Z_OK ? 0 : -1;
+    case MESH_HANDOFF_COMP_LZ4:
+        return LZ4F_isError(LZ4F_createDecompressionContext(&d->lz4,
+                                                            LZ4F_VERSION)) ? -1 : 0;
+    default:
+        printf("Unsupported game compression %u\r\n", codec);
+        return -1;
+    }
+}
+
+// this function writes out_len bytes of decompressed data to the file
+static int decompress_out(struct decompress *d, size_t out_len)
+{
+    d->out_len += out_len;
+
+    return write_all(d->fd, out_buf, out_len);
+}
+
+static int decompress_gzip(struct decompress *d, const unsigned char *buf,
+                           size_t len)
+{
+    int ret;
+
+    d->zs.next_in = (unsigned char *) buf;
+    d->zs.avail_in = len;
+    do {
+        d->zs.next_out = out_buf;
+        d->zs.avail_out = OUT_SIZE;
+        ret = inflate(&d->zs, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            return -1;
+        }
+        if (decompress_out(d, OUT_SIZE - d->zs.avail_out) < 0) {
+            return -1;
+        }
+        d->done = ret == Z_STREAM_END;
+    } while (!d->done && ret != Z_BUF_ERROR &&
+             (d->zs.avail_in > 0 || d->zs.avail_out == 0));
+
+    return d->zs.avail_in > 0 ? -1 : 0;
+}
+
+static int decompress_lz4(struct decompress *d, const unsigned char *buf,
+                          size_t len)
+{
+    size_t in_len, out_len, hint;
+
+    do {
+        in_len = len;
+        out_len = OUT_SIZE;
+        hint = LZ4F_decompress(d->lz4, out_buf, &out_len, buf, &in_len, NULL);
+        if (LZ4F_isError(hint) || decompress_out(d, out_len) < 0) {
+            return -1;
+        }
+        d->done = hint == 0;
+        buf += in_len;
+        len -= in_len;
+    } while (!d->done && (len > 0 || out_len == OUT_SIZE));
+
+    return len > 0 ? -1 : 0;
+}
+
+/*
+    This function decompresses the next len bytes of the payload and writes
+    the result to the file. Bytes after the end of a compressed stream are
+    an error.
+
+    Returns 0 on success, -1 on a decompression or write error.
+*/
+int decompress_write(struct decompress *d, const unsigned char *buf, size_t len)
+{
+    if (d->done && len > 0) {
+        return -1;
+    }
+
+    switch (d->codec) {
+    case MESH_HANDOFF_COMP_GZIP:
+        return decompress_gzip(d, buf, len);
+    case MESH_HANDOFF_COMP_LZ4:
+        return decompress_lz4(d, buf, len);
+    default:
+        d->out_len += len;
+        return write_all(d->fd, buf, len);
+    }
+}
+
+/*
+    This function finishes decompression and frees d. Everything is written
+    out by decompress_write already.
+
+    Returns 0 if the compressed stream was complete, -1 if not.
+*/
+int decompress_end(struct decompress *d)
+{
+    switch (d->codec) {
+    case MESH_HANDOFF_COMP_GZIP:
+        inflateEnd(&d->zs);
+        break;
+    case MESH_HANDOFF_COMP_LZ4:
+        LZ4F_freeDecompressionContext(d->lz4);
+        break;
+    default:
+        return 0;
+    }
+
+    return d->done ? 0 : -1;
+}
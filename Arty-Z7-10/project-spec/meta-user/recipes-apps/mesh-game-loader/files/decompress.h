@@ -0,0 +1,23 @@
+#ifndef __DECOMPRESS_H__
+#define __DECOMPRESS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zlib.h>
+#include <lz4frame.h>
+
+// state for writing a payload to a file, decompressing it on the way
+struct decompress {
+    uint32_t codec;     // MESH_HANDOFF_COMP_*
+    int fd;
+    uint64_t out_len;   // bytes written to fd so far
+    int done;           // the compressed stream has ended
+    z_stream zs;
+    LZ4F_dctx *lz4;
+};
+
+int decompress_init(struct decompress *d, uint32_t codec, int fd);
+int decompress_write(struct decompress *d, const unsigned char *buf, size_t len);
+int decompress_end(struct decompress *d);
+
+#endif
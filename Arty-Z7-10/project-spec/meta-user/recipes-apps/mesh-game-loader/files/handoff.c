@@ -0,0 +1,73 @@
+#include <stdio.h>
+
+#include "handoff.h"
+
+/*
+    This function checks that a descriptor left by U-Boot is one this loader
+    understands and that its lengths add up, so that the segments can be
+    mapped and copied without further checks.
+
+    Returns 0 if the descriptor is usable, -1 if not.
+*/
+int handoff_check(const struct mesh_handoff *desc)
+{
+    uint32_t total = 0;
+
+    if (desc->magic != MESH_HANDOFF_MAGIC) {
+        printf("No game handoff descriptor found\r\n");
+        return -1;
+    }
+    if (desc->version != MESH_HANDOFF_VERSION ||
+        desc->desc_len != sizeof(*desc)) {
+        printf("Unsupported game handoff version %u\r\n", desc->version);
+        return -1;
+    }
+    if (desc->num_segments == 0 ||
+        desc->num_segments > MESH_HANDOFF_MAX_SEGMENTS) {
+        printf("Bad game segment count %u\r\n", desc->num_segments);
+        return -1;
+    }
+    for (uint32_t i = 0; i < desc->num_segments; i++) {
+        if (desc->segments[i].addr & (MESH_HANDOFF_SIZE - 1) ||
+            desc->segments[i].len > UINT32_MAX - total) {
+            printf("Bad game segment %u\r\n", i);
+            return -1;
+        }
+        total += desc->segments[i].len;
+    }
+    if (total != desc->stream_len ||
+        desc->payload_offset > desc->stream_len ||
+        desc->payload_len > desc->stream_len - desc->payload_offset) {
+        printf("Game lengths do not add up\r\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+    This function updates crc with len bytes from buf. It is the same crc32
+    as U-Boot's and zlib's, start with crc 0.
+*/
+uint32_t handoff_crc32(uint32_t crc, const unsigned char *buf, size_t len)
+{
+    static uint32_t table[256];
+    uint32_t c;
+
+    if (table[1] == 0) {
+        for (uint32_t n = 0; n < 256; n++) {
+            c = n;
+            for (int k = 0; k < 8; k++) {
+                c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+    }
+
+    crc = ~crc;
+    while (len--) {
+        crc = table[(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
@@ -0,0 +1,45 @@
+#ifndef __HANDOFF_H__
+#define __HANDOFF_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+// these match include/mesh_handoff.h in U-Boot, which writes the descriptor
+// at the start of the reserved ddr region
+#define MESH_HANDOFF_MAGIC 0x4d475631 /* "MGV1" */
+#define MESH_HANDOFF_VERSION 2
+
+// the descriptor gets a page to itself, the segments start after it
+#define MESH_HANDOFF_SIZE 0x1000
+
+#define MESH_HANDOFF_MAX_SEGMENTS 8
+
+// how the payload is stored
+#define MESH_HANDOFF_COMP_NONE 0
+#define MESH_HANDOFF_COMP_GZIP 1
+#define MESH_HANDOFF_COMP_LZ4 2
+
+struct mesh_handoff_segment {
+    uint32_t addr;           // physical address, page aligned
+    uint32_t len;            // bytes of the stream in this segment
+};
+
+struct mesh_handoff {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t desc_len;       // sizeof(struct mesh_handoff)
+    uint32_t stream_len;     // bytes stored across all segments
+    uint32_t header_len;     // length of the text header lines of the game
+    uint32_t payload_offset; // offset of the payload in the stream
+    uint32_t payload_len;    // bytes of payload as stored
+    uint32_t compression;    // MESH_HANDOFF_COMP_*
+    uint32_t uncompressed_len; // bytes of payload once decompressed
+    uint32_t payload_crc32;  // crc32 of the payload as stored
+    uint32_t num_segments;
+    struct mesh_handoff_segment segments[MESH_HANDOFF_MAX_SEGMENTS];
+};
+
+int handoff_check(const struct mesh_handoff *desc);
+uint32_t handoff_crc32(uint32_t crc, const unsigned char *buf, size_t len);
+
+#endif
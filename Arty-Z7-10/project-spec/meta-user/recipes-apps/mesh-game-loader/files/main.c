@@ -1,35 +1,236 @@
 #include <sys/wait.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <glob.h>
+#include <time.h>
 #include <sys/mman.h>
 
+#include "bootstage.h"
+#include "decompress.h"
+#include "handoff.h"
+
 // this is the path where the game will be written to
 #define GAMEPATH "/usr/bin/game"
 
-// this is the linux device representing the Zynq ram
-#define MEMPATH "/dev/mem"
+// this is the device the mesh-game-mem driver offers the reserved region
+// through, mapped cacheable. Offset 0 is the start of the region
+#define MEMPATH "/dev/mesh_game"
+#define MEMBASE_PATH "/sys/class/misc/mesh_game/base"
+
+// this is the linux device representing the Zynq ram, used if the driver is
+// missing. It maps the region uncached, which is much slower to read
+#define DEVMEM_PATH "/dev/mem"
+
+// this is the reserved-memory node U-Boot adds for the region it writes the
+// game to
+#define DT_REGION_DIR "/proc/device-tree/reserved-memory"
+#define DT_REGION_GLOB DT_REGION_DIR "/mesh-game@*/reg"
+
+// the game is copied out in chunks of this size, aligned in the source
+#define CHUNK_SIZE 0x40000
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+extern char **environ;
+
+// this function returns CLOCK_MONOTONIC in microseconds
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+    This function passes len bytes from buf to the decompressor, going
+    through a bounce buffer CHUNK_SIZE at a time. Each chunk is read from
+    the reserved region once, in a large aligned burst, and its crc is taken
+    from the copy.
+
+    Returns 0 on success, -1 on error.
+*/
+static int copy_chunked(struct decompress *d, const unsigned char *buf,
+                        size_t len, uint32_t *crc)
+{
+    static unsigned char bounce[CHUNK_SIZE] __attribute__((aligned(64)));
+    size_t chunk;
+
+    while (len > 0) {
+        chunk = len < CHUNK_SIZE ? len : CHUNK_SIZE;
+        memcpy(bounce, buf, chunk);
+        *crc = handoff_crc32(*crc, bounce, chunk);
+        if (decompress_write(d, bounce, chunk) < 0) {
+            return -1;
+        }
+        buf += chunk;
+        len -= chunk;
+    }
+
+    return 0;
+}
+
+/*
+    This function writes the payload described by desc to game_fd,
+    decompressing it if it was stored compressed, mapping one segment at a
+    time from mem_fd. phys_off is what to add to a physical address to get
+    its offset in mem_fd.
+
+    Returns 0 on success, -1 on error or if the payload does not check out.
+*/
+static int copy_payload(int mem_fd, off_t phys_off,
+                        const struct mesh_handoff *desc, int game_fd)
+{
+    uint32_t start = desc->payload_offset;
+    uint32_t end = desc->payload_offset + desc->payload_len;
+    uint32_t pos = 0, from, to, crc = 0;
+    struct decompress d;
+    unsigned char *seg;
+    int ret = 0;
+
+    if (decompress_init(&d, desc->compression, game_fd) < 0) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < desc->num_segments && ret == 0;
+         i++, pos += to - from) {
+        from = pos;
+        to = pos + desc->segments[i].len;
+        if (to <= start || from >= end) {
+            continue;
+        }
+
+        seg = mmap(0, desc->segments[i].len, PROT_READ, MAP_SHARED, mem_fd,
+                   desc->segments[i].addr + phys_off);
+        if (seg == MAP_FAILED) {
+            printf("mem map failed\r\n");
+            ret = -1;
+            break;
+        }
+        ret = copy_chunked(&d,
+                           seg + (start > from ? start - from : 0),
+                           (to < end ? to : end) - (start > from ? start : from),
+                           &crc);
+        munmap(seg, desc->segments[i].len);
+        if (ret < 0) {
+            printf("Game write or decompression error\r\n");
+        }
+    }
+    if (decompress_end(&d) < 0 && ret == 0) {
+        printf("Game payload is truncated\r\n");
+        ret = -1;
+    }
+    if (ret < 0) {
+        return -1;
+    }
+
+    if (crc != desc->payload_crc32) {
+        printf("Game checksum mismatch\r\n");
+        return -1;
+    }
+    if (d.out_len != desc->uncompressed_len) {
+        printf("Game is %llu bytes, expected %u\r\n",
+               (unsigned long long) d.out_len, desc->uncompressed_len);
+        return -1;
+    }
+
+    return 0;
+}
+
+// this function reads a big-endian device tree cell from path, returning
+// the cell at index, or -1
+static long long read_dt_cell(const char *path, int index)
+{
+    unsigned char cell[4];
+    FILE *fp;
+    int ok;
+
+    fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return -1;
+    }
+    ok = fseek(fp, index * 4, SEEK_SET) == 0 && fread(cell, 4, 1, fp) == 1;
+    fclose(fp);
+    if (!ok) {
+        return -1;
+    }
+
+    return ((uint32_t) cell[0] << 24) | (cell[1] << 16) | (cell[2] << 8) |
+           cell[3];
+}
 
-// the reserved address in ram where uboot writes the game to
-#define BASE_ADDR 0x1fc00000
+/*
+    This function returns the physical address of the reserved region, from
+    the mesh-game-mem driver if it is loaded, else from the device tree.
 
-// the size of the reserved memory in ram where uboot writes the game to
-#define MAPSIZE 0x400000
+    Returns -1 if neither knows.
+*/
+static off_t region_addr(void)
+{
+    unsigned long addr;
+    long long cells;
+    glob_t g;
+    FILE *fp;
+    off_t ret = -1;
+    int ok;
 
-// this funciton advances the 
-unsigned char *skip_line(unsigned char *buf){
-    int i=0;
+    fp = fopen(MEMBASE_PATH, "r");
+    if (fp != NULL) {
+        ok = fscanf(fp, "%li", &addr) == 1;
+        fclose(fp);
+        if (ok) {
+            return addr;
+        }
+    }
 
-    while (buf[i++] != '\n'){
-        continue;
+    // the address is the last of #address-cells cells; the Zynq's fits in
+    // one
+    cells = read_dt_cell(DT_REGION_DIR "/#address-cells", 0);
+    if (cells < 1 || glob(DT_REGION_GLOB, 0, NULL, &g) != 0) {
+        return -1;
     }
+    ret = read_dt_cell(g.gl_pathv[0], cells - 1);
+    globfree(&g);
+
+    return ret;
+}
+
+// this function creates an anonymous in-memory file to run the game from
+static int create_memfd(void)
+{
+#ifdef SYS_memfd_create
+    return syscall(SYS_memfd_create, "game", MFD_CLOEXEC);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
 
-    return buf + i;
+static void usage(const char *prog)
+{
+    printf("Usage: %s [-x] [-n] [-g <path>] [-m <path>] [-o <offset>] [-a <addr>]\r\n"
+           "  -x           run the game, from memory rather than from a file if possible\r\n"
+           "  -n           with -x, stop just before running the game\r\n"
+           "  -g <path>    write the game to <path> (default %s)\r\n"
+           "  -m <path>    read the reserved region from <path> (default %s, or\r\n"
+           "               %s if that is missing)\r\n"
+           "  -o <offset>  offset of the reserved region in <path> (default 0 for\r\n"
+           "               %s, else its physical address)\r\n"
+           "  -a <addr>    physical address of the reserved region (default from\r\n"
+           "               the device tree)\r\n",
+           prog, GAMEPATH, MEMPATH, DEVMEM_PATH, MEMPATH);
 }
 
 /*
@@ -40,57 +241,192 @@ unsigned char *skip_line(unsigned char *buf){
  */
 int main(int argc, char **argv)
 {
-    int fd;
+    const char *mempath = NULL;
+    const char *gamepath = GAMEPATH;
+    off_t base = -1;
+    off_t region = -1;
+    bool run = false;
+    bool dry_run = false;
+    bool in_memory;
+    char *game_argv[] = { "game", NULL };
+    struct mesh_handoff desc;
+    uint64_t start_us, copy_us;
+    int fd = -1, stash_fd, game_fd, opt;
     unsigned char *map;
-    unsigned char *map_tmp;
-    int gameSize;
-    FILE * gameFp;
-    int written;
+    unsigned char *stash;
+    off_t phys_off, stash_off;
 
-    // open the memory device
-    fd = open(MEMPATH, O_RDWR | O_SYNC);
+    start_us = now_us();
+
+    while ((opt = getopt(argc, argv, "xng:m:o:a:")) != -1) {
+        switch (opt) {
+        case 'x':
+            run = true;
+            break;
+        case 'n':
+            dry_run = true;
+            break;
+        case 'g':
+            gamepath = optarg;
+            break;
+        case 'm':
+            mempath = optarg;
+            break;
+        case 'o':
+            base = strtoul(optarg, NULL, 0);
+            break;
+        case 'a':
+            region = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // open the memory device: the driver's cacheable mapping of the region
+    // if it is there, else /dev/mem. A plain image file given with -m can
+    // stand in for /dev/mem
+    if (region < 0) {
+        region = region_addr();
+    }
+    if (region < 0) {
+        printf("Cannot find the reserved region in the device tree\r\n");
+        return 1;
+    }
+    if (mempath == NULL) {
+        fd = open(MEMPATH, O_RDWR | O_CLOEXEC);
+        if (fd != -1) {
+            mempath = MEMPATH;
+            if (base < 0) {
+                base = 0;
+            }
+        } else {
+            printf("%s missing, reading the game uncached from %s\r\n",
+                   MEMPATH, DEVMEM_PATH);
+            mempath = DEVMEM_PATH;
+        }
+    }
+    if (base < 0) {
+        base = region;
+    }
+    if (fd == -1) {
+        fd = open(mempath, O_RDWR | O_CLOEXEC);
+    }
 
     if (fd == -1) {
         printf("mem open failed\r\n");
         return 1;
     }
+    phys_off = base - region;
 
-    // map the memory device so your can access it like a chunk of memory
-    map = mmap(0, MAPSIZE, (PROT_READ | PROT_WRITE), MAP_SHARED, fd, BASE_ADDR);
+    // map the bootstage stash and record when linux userspace picked up
+    // the game. It is outside the region, so the driver does not offer it
+    if (strcmp(mempath, MEMPATH) == 0) {
+        stash_fd = open(DEVMEM_PATH, O_RDWR | O_CLOEXEC);
+        stash_off = region + BOOTSTAGE_OFFSET;
+    } else {
+        stash_fd = fd;
+        stash_off = base + BOOTSTAGE_OFFSET;
+    }
+    stash = MAP_FAILED;
+    if (stash_fd != -1 && stash_off >= 0) {
+        stash = mmap(0, BOOTSTAGE_SIZE, (PROT_READ | PROT_WRITE), MAP_SHARED,
+                     stash_fd, stash_off);
+    }
+    if (stash_fd != fd && stash_fd != -1) {
+        close(stash_fd);
+    }
+    if (stash == MAP_FAILED) {
+        stash = NULL;
+    } else {
+        bootstage_append(stash, BOOTSTAGE_SIZE, "loader_start");
+    }
 
-    gameSize = *(int *)map;
-    gameFp = NULL;
+    // read the descriptor U-Boot left at the start of the region
+    map = mmap(0, MESH_HANDOFF_SIZE, PROT_READ, MAP_SHARED, fd, base);
+    if (map == MAP_FAILED) {
+        printf("mem map failed\r\n");
+        return 1;
+    }
+    memcpy(&desc, map, sizeof(desc));
+    munmap(map, MESH_HANDOFF_SIZE);
+    if (handoff_check(&desc) < 0) {
+        return 1;
+    }
 
-    gameFp = fopen(GAMEPATH, "w+b");
+    printf("Launching game from reserved ddr. Game Size: %u\r\n",
+           desc.stream_len);
 
-    if (gameFp == NULL) {
-        printf("Error opening game file\r\n");
-        return 1;
+    // copy the game into memory to run it from there if the kernel allows,
+    // otherwise write it out to gamepath
+    game_fd = run ? create_memfd() : -1;
+    in_memory = game_fd >= 0;
+    if (!in_memory) {
+        if (run) {
+            printf("memfd_create failed, writing %s\r\n", gamepath);
+        }
+        game_fd = open(gamepath, O_WRONLY | O_CREAT | O_TRUNC, 0755);
+        if (game_fd < 0) {
+            printf("Error opening game file\r\n");
+            return 1;
+        }
     }
 
-    printf("Launching game from reserved ddr. Game Size: %d\r\n", gameSize);
+    copy_us = now_us();
+    if (copy_payload(fd, phys_off, &desc, game_fd) < 0) {
+        // do not leave a partial game behind to be run
+        if (!in_memory) {
+            ftruncate(game_fd, 0);
+        }
+        return 1;
+    }
+    copy_us = now_us() - copy_us;
 
-    // jump ahead to the reserved region for the game binary
-    map += 0x40;
+    printf("%u bytes written in %llu us (%llu MB/s)\r\n", desc.uncompressed_len,
+           (unsigned long long) copy_us,
+           (unsigned long long) (desc.uncompressed_len / (copy_us ? copy_us : 1)));
+    if (desc.compression != MESH_HANDOFF_COMP_NONE) {
+        printf("%u bytes read from reserved ddr (%llu MB/s)\r\n",
+               desc.payload_len,
+               (unsigned long long) (desc.payload_len / (copy_us ? copy_us : 1)));
+    }
 
-    // dump first 3 header lines of the game so it is executable
-    map_tmp = map;
-    for (int i=0; i < 3; i++){
-        map_tmp = skip_line(map_tmp);   
+    // record the hand off to the game and keep the combined timeline
+    if (stash != NULL) {
+        bootstage_append(stash, BOOTSTAGE_SIZE, "game_exec");
+        bootstage_save(stash, BOOTSTAGE_PATH);
     }
 
-    // write the game
-    written = fwrite(map_tmp, sizeof(char), gameSize - (map_tmp - map), gameFp);
+    if (!in_memory) {
+        close(game_fd);
+    }
+    if (!run) {
+        return 0;
+    }
 
-    if (ferror(gameFp)) {
-        printf("fwrite error.\r\n");
+    printf("time to exec: %llu us\r\n",
+           (unsigned long long) (now_us() - start_us));
+    fflush(stdout);
+    if (dry_run) {
+        return 0;
     }
-    
-    printf("%d bytes written\r\n", written);
-    
 
-    fclose(gameFp);
+    if (in_memory) {
+        fexecve(game_fd, game_argv, environ);
+
+        // fexecve needs /proc; without it run the game from a file
+        printf("fexecve failed, writing %s\r\n", gamepath);
+        close(game_fd);
+        game_fd = open(gamepath, O_WRONLY | O_CREAT | O_TRUNC, 0755);
+        if (game_fd < 0 || copy_payload(fd, phys_off, &desc, game_fd) < 0) {
+            printf("Error writing game file\r\n");
+            return 1;
+        }
+        close(game_fd);
+    }
+    execv(gamepath, game_argv);
+    printf("exec failed\r\n");
 
     return 1;
 }
-
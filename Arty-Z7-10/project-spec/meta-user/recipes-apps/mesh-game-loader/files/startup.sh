@@ -20,6 +20,10 @@ start ()
     if [ ! -z "$a" ]; then
         mv /dev/$a /dev/mesh_drm
     fi
+    a=$(grep PWM /sys/class/uio/uio*/maps/map*/name | cut -d'/' -f5)
+    if [ ! -z "$a" ]; then
+        mv /dev/$a /dev/pwm
+    fi
 
     # set tty device with correct baud
     stty -F /dev/ttyPS0 speed 115200
@@ -27,9 +31,8 @@ start ()
     # login ectf
     /bin/login -f ectf
 
-    # load and launch game
-    mesh-game-loader
-    game
+    # load and launch game, straight from memory when the kernel allows
+    mesh-game-loader -x
 
     # restart so user doesnt fall through to petalinux shell
     echo "Game over. Restarting system..."
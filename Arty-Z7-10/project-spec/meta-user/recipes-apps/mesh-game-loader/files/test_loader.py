@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""Host test of the loader's copy path.
+
+Builds region images the way U-Boot's mesh shell leaves them, with a plain
+file standing in for the reserved region, and checks that the loader writes
+out the game byte for byte. Run it with "make CC=gcc test".
+"""
+
+import os
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+import zlib
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                *[os.pardir] * 6, "tools"))
+import provisionGames
+
+# these match handoff.h
+MESH_HANDOFF_MAGIC = 0x4d475631
+MESH_HANDOFF_VERSION = 2
+MESH_HANDOFF_SIZE = 0x1000
+MESH_HANDOFF_MAX_SEGMENTS = 8
+compressions = {"none": 0, "gzip": 1, "lz4": 2}
+
+# where the region is on the board, and how big
+region_addr = 0x1fc00000
+region_size = 0x400000
+
+
+def make_game():
+    """Return the bytes of a test game: some that compress and some that do
+    not, more than one of the loader's chunks in all.
+    """
+    rand = random.Random(0)
+    noise = bytes(rand.getrandbits(8) for _ in range(0x40000))
+    text = b"".join(b"line %d of the game\n" % i for i in range(0x8000))
+    return noise + text + noise[:0x1234]
+
+
+def make_region(game, codec, splits):
+    """Return a region image holding game behind its header lines, stored
+    with codec and split into segments.
+
+    game: bytes of the game binary
+    codec: one of compressions
+    splits: offsets in the stream at which to start a new segment
+    """
+    header = b"version:1.0\nname:test\nusers:demo\n"
+    payload = game
+    if codec != "none":
+        header += b"compression:%s %d\n" % (codec.encode(), len(game))
+        payload = provisionGames.compress_payload(game, codec)
+    stream = header + payload
+
+    image = bytearray(region_size)
+    segments = []
+    addr = MESH_HANDOFF_SIZE
+    assert not splits or splits[-1] < len(stream)
+    for start, end in zip([0] + splits, splits + [len(stream)]):
+        image[addr:addr + end - start] = stream[start:end]
+        segments.append((region_addr + addr, end - start))
+        # leave a gap, and start each segment on a page
+        addr += (end - start + 2 * MESH_HANDOFF_SIZE - 1) & \
+            ~(MESH_HANDOFF_SIZE - 1)
+    assert addr <= region_size and len(segments) <= MESH_HANDOFF_MAX_SEGMENTS
+
+    desc = struct.pack("<IHHIIIIIIII", MESH_HANDOFF_MAGIC,
+                       MESH_HANDOFF_VERSION,
+                       40 + 8 * MESH_HANDOFF_MAX_SEGMENTS, len(stream),
+                       len(header), len(header), len(payload),
+                       compressions[codec], len(game),
+                       zlib.crc32(payload) & 0xffffffff, len(segments))
+    segments += [(0, 0)] * (MESH_HANDOFF_MAX_SEGMENTS - len(segments))
+    for seg in segments:
+        desc += struct.pack("<II", *seg)
+    image[:len(desc)] = desc
+    return image, len(header)
+
+
+def run_loader(loader, image, out, *args):
+    """Run the loader on a region image, writing the game to out, and return
+    its exit code.
+    """
+    with tempfile.NamedTemporaryFile() as fh:
+        fh.write(image)
+        fh.flush()
+        return subprocess.run([loader, "-m", fh.name, "-o", "0",
+                               "-a", "%#x" % region_addr, "-g", out] +
+                              list(args), stdout=subprocess.DEVNULL).returncode
+
+
+def main():
+    loader = os.path.abspath(sys.argv[1] if len(sys.argv) > 1 else
+                             "mesh-game-loader")
+    game = make_game()
+    failed = 0
+
+    with tempfile.TemporaryDirectory() as tmp:
+        out = os.path.join(tmp, "game")
+        for codec in compressions:
+            # one segment, then segments split inside the header, inside
+            # the payload and just past a chunk boundary
+            for splits in ([], [10, 0x12345, 0x40001]):
+                image, header_len = make_region(game, codec, splits)
+                name = "%s, %d segment(s)" % (codec, len(splits) + 1)
+                if os.path.exists(out):
+                    os.remove(out)
+                ret = run_loader(loader, image, out)
+                ok = ret == 0
+                if ok:
+                    with open(out, "rb") as fh:
+                        ok = fh.read() == game
+                print("%s: %s" % ("PASS" if ok else "FAIL", name))
+                failed += not ok
+
+            # a corrupted payload must fail and leave no game behind
+            image, header_len = make_region(game, codec, [])
+            image[MESH_HANDOFF_SIZE + header_len + 0x100] ^= 0xff
+            ret = run_loader(loader, image, out)
+            ok = ret != 0 and os.path.getsize(out) == 0
+            print("%s: %s, corrupted" % ("PASS" if ok else "FAIL", codec))
+            failed += not ok
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
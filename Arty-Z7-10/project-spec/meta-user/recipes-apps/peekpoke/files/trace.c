@@ -0,0 +1,423 @@
+/*
+* trace utility - sample a set of registers at a fixed rate
+*
+* Maps every page holding one of the registers once, then reads all of
+* them at a fixed rate from a sampling thread woken by an absolute
+* CLOCK_MONOTONIC timer. Samples go through a single producer, single
+* consumer lock-free ring to the main thread, which streams them out as
+* CSV or binary, so slow output never holds up sampling: when the ring is
+* full the sample is dropped and counted instead. At the end it reports
+* the rate achieved, the samples dropped and the ticks missed because the
+* sampler ran late.
+*
+* A file can stand in for /dev/mem (-m), with register addresses taken as
+* offsets into it plus a base address (-b).
+*
+* Binary output is a header, then one record per sample, all little
+* endian on the Zynq:
+*	char magic[4] = "PKTR"; u32 version = 1; u32 count; u32 rate_hz;
+*	then count times { u64 addr; u32 width; u32 pad; }
+*	then per sample { u64 time_ns; u64 seq; u64 value[count]; }
+*
+* Permission is hereby granted, free of charge, to any person
+* obtaining a copy of this software and associated documentation
+* files (the "Software"), to deal in the Software without restriction,
+* including without limitation the rights to use, copy, modify, merge,
+* publish, distribute, sublicense, and/or sell copies of the Software,
+* and to permit persons to whom the Software is furnished to do so,
+* subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*
+*/
+
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#define MAX_TARGETS	32
+#define DEFAULT_RATE	1000
+#define DEFAULT_RING	4096	/* samples, a power of two */
+
+struct target {
+	uint64_t addr;
+	unsigned width;
+	volatile uint8_t *ptr;
+};
+
+struct sample {
+	uint64_t time_ns;
+	uint64_t seq;
+	uint64_t value[MAX_TARGETS];
+};
+
+/* Written only by the sampler (head) or only by the writer (tail) */
+struct ring {
+	struct sample *buf;
+	unsigned mask;
+	unsigned head;
+	unsigned tail;
+	int done;
+};
+
+static struct target targets[MAX_TARGETS];
+static unsigned ntargets;
+static struct ring ring;
+
+static volatile sig_atomic_t stop;
+
+/* Results of the sampler */
+static uint64_t taken, dropped, missed, elapsed_ns;
+
+static uint64_t rate_hz = DEFAULT_RATE;
+static uint64_t max_samples;
+static double duration;
+
+static void on_sigint(int sig)
+{
+	(void)sig;
+	stop = 1;
+}
+
+static uint64_t ts_ns(const struct timespec *ts)
+{
+	return (uint64_t)ts->tv_sec * 1000000000ull + ts->tv_nsec;
+}
+
+static uint64_t read_target(const struct target *t)
+{
+	switch (t->width) {
+	case 1:
+		return *t->ptr;
+	case 2:
+		return *(volatile uint16_t *)t->ptr;
+	case 8:
+		return *(volatile uint64_t *)t->ptr;
+	default:
+		return *(volatile uint32_t *)t->ptr;
+	}
+}
+
+/* Take one sample of every target into the ring, or count it dropped */
+static void take_sample(uint64_t now, uint64_t seq)
+{
+	unsigned head = ring.head;
+	struct sample *s;
+	unsigned i;
+
+	if (head - __atomic_load_n(&ring.tail, __ATOMIC_ACQUIRE) > ring.mask) {
+		dropped++;
+		return;
+	}
+	s = &ring.buf[head & ring.mask];
+	s->time_ns = now;
+	s->seq = seq;
+	for (i = 0; i < ntargets; i++)
+		s->value[i] = read_target(&targets[i]);
+	__atomic_store_n(&ring.head, head + 1, __ATOMIC_RELEASE);
+}
+
+static void *sampler(void *arg)
+{
+	uint64_t period = 1000000000ull / rate_hz;
+	uint64_t start, next, now, end = 0, seq = 0;
+	struct timespec ts;
+
+	(void)arg;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	start = next = ts_ns(&ts);
+	if (duration > 0)
+		end = start + (uint64_t)(duration * 1e9);
+
+	while (!stop && (!max_samples || taken < max_samples)) {
+		ts.tv_sec = next / 1000000000ull;
+		ts.tv_nsec = next % 1000000000ull;
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		now = ts_ns(&ts);
+		if (end && now >= end)
+			break;
+
+		take_sample(now, seq);
+		taken++;
+
+		/*
+		 * if we woke up late, skip the ticks that have gone by; seq
+		 * counts ticks, so they show up as gaps in it
+		 */
+		next += period;
+		seq++;
+		if (now >= next + period) {
+			missed += (now - next) / period;
+			seq += (now - next) / period;
+			next += (now - next) / period * period;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	elapsed_ns = ts_ns(&ts) - start;
+	__atomic_store_n(&ring.done, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+static void write_header(FILE *out, int binary)
+{
+	uint32_t hdr[3] = { 1, ntargets, (uint32_t)rate_hz };
+	uint32_t width[2];
+	unsigned i;
+
+	if (!binary) {
+		fprintf(out, "time_ns,seq");
+		for (i = 0; i < ntargets; i++)
+			fprintf(out, ",0x%08" PRIx64, targets[i].addr);
+		fprintf(out, "\n");
+		return;
+	}
+	fwrite("PKTR", 4, 1, out);
+	fwrite(hdr, sizeof(hdr), 1, out);
+	for (i = 0; i < ntargets; i++) {
+		width[0] = targets[i].width;
+		width[1] = 0;
+		fwrite(&targets[i].addr, sizeof(targets[i].addr), 1, out);
+		fwrite(width, sizeof(width), 1, out);
+	}
+}
+
+static void write_sample(FILE *out, int binary, const struct sample *s)
+{
+	unsigned i;
+
+	if (binary) {
+		fwrite(s, sizeof(uint64_t) * (2 + ntargets), 1, out);
+		return;
+	}
+	fprintf(out, "%" PRIu64 ",%" PRIu64, s->time_ns, s->seq);
+	for (i = 0; i < ntargets; i++)
+		fprintf(out, ",0x%0*" PRIx64, targets[i].width * 2, s->value[i]);
+	fprintf(out, "\n");
+}
+
+/* Write out samples until the sampler is done and the ring is empty */
+static void drain(FILE *out, int binary)
+{
+	unsigned head, tail = ring.tail;
+	int done;
+
+	for (;;) {
+		done = __atomic_load_n(&ring.done, __ATOMIC_ACQUIRE);
+		head = __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE);
+		if (tail == head) {
+			if (done)
+				break;
+			fflush(out);
+			usleep(1000);
+			continue;
+		}
+		for (; tail != head; tail++)
+			write_sample(out, binary, &ring.buf[tail & ring.mask]);
+		__atomic_store_n(&ring.tail, tail, __ATOMIC_RELEASE);
+	}
+	fflush(out);
+}
+
+/* Parse ADDR[:WIDTH] */
+static int parse_target(const char *arg, struct target *t)
+{
+	char *end;
+
+	errno = 0;
+	t->addr = strtoull(arg, &end, 0);
+	t->width = 4;
+	if (*end == ':')
+		t->width = strtoul(end + 1, &end, 0);
+	if (errno || *end || (t->width != 1 && t->width != 2 &&
+			      t->width != 4 && t->width != 8) ||
+	    t->addr % t->width)
+		return -1;
+	return 0;
+}
+
+/* Map the page of every target, each page only once */
+static int map_targets(int fd, uint64_t base)
+{
+	static struct {
+		uint64_t page;
+		uint8_t *ptr;
+	} pages[MAX_TARGETS];
+	struct stat st;
+	unsigned page_size = sysconf(_SC_PAGESIZE);
+	unsigned i, j, npages = 0;
+	uint64_t off;
+	void *ptr;
+
+	for (i = 0; i < ntargets; i++) {
+		off = targets[i].addr - base;
+		/* reading past the end of a stand-in file would fault */
+		if (targets[i].addr < base ||
+		    (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+		     off + targets[i].width > (uint64_t)st.st_size)) {
+			errno = EINVAL;
+			return -1;
+		}
+		for (j = 0; j < npages; j++)
+			if (pages[j].page == (off & ~(uint64_t)(page_size - 1)))
+				break;
+		if (j == npages) {
+			ptr = mmap(NULL, page_size, PROT_READ, MAP_SHARED, fd,
+				   off & ~(uint64_t)(page_size - 1));
+			if (ptr == MAP_FAILED)
+				return -1;
+			pages[npages].page = off & ~(uint64_t)(page_size - 1);
+			pages[npages++].ptr = ptr;
+		}
+		targets[i].ptr = pages[j].ptr + (off & (page_size - 1));
+	}
+	return 0;
+}
+
+void usage(char *prog)
+{
+	printf("usage: %s [options] ADDR[:WIDTH]...\n", prog);
+	printf("\n");
+	printf("Sample the registers at each ADDR, WIDTH bytes wide (1, 2, 4 or 8,\n");
+	printf("default 4), at a fixed rate until interrupted\n");
+	printf("\n");
+	printf("  -r HZ     samples per second (default %d)\n", DEFAULT_RATE);
+	printf("  -d SECS   stop after this long\n");
+	printf("  -n COUNT  stop after this many samples\n");
+	printf("  -o FILE   write the samples here (default stdout)\n");
+	printf("  -B        write binary instead of CSV\n");
+	printf("  -s COUNT  samples the ring holds, a power of two (default %d)\n",
+	       DEFAULT_RING);
+	printf("  -m FILE   read FILE instead of /dev/mem\n");
+	printf("  -b ADDR   address of the start of FILE (default 0)\n");
+	printf("  -p PRIO   sample at this SCHED_FIFO priority\n");
+}
+
+int main(int argc, char *argv[])
+{
+	const char *mem = "/dev/mem";
+	const char *outpath = NULL;
+	unsigned ring_size = DEFAULT_RING;
+	uint64_t base = 0;
+	int binary = 0, prio = 0;
+	struct sched_param sp;
+	pthread_attr_t attr;
+	pthread_t thread;
+	FILE *out = stdout;
+	int c, fd;
+
+	while ((c = getopt(argc, argv, "hr:d:n:o:Bs:m:b:p:")) != -1) {
+		switch (c) {
+		case 'r':
+			rate_hz = strtoull(optarg, NULL, 0);
+			break;
+		case 'd':
+			duration = strtod(optarg, NULL);
+			break;
+		case 'n':
+			max_samples = strtoull(optarg, NULL, 0);
+			break;
+		case 'o':
+			outpath = optarg;
+			break;
+		case 'B':
+			binary = 1;
+			break;
+		case 's':
+			ring_size = strtoul(optarg, NULL, 0);
+			break;
+		case 'm':
+			mem = optarg;
+			break;
+		case 'b':
+			base = strtoull(optarg, NULL, 0);
+			break;
+		case 'p':
+			prio = strtoul(optarg, NULL, 0);
+			break;
+		case 'h':
+			usage(argv[0]);
+			exit(0);
+		default:
+			usage(argv[0]);
+			exit(-1);
+		}
+	}
+	if (optind == argc || argc - optind > MAX_TARGETS || !rate_hz ||
+	    rate_hz > 1000000000ull || !ring_size ||
+	    (ring_size & (ring_size - 1))) {
+		usage(argv[0]);
+		exit(-1);
+	}
+	for (; optind < argc; optind++) {
+		if (parse_target(argv[optind], &targets[ntargets++]) < 0) {
+			fprintf(stderr, "%s: bad register %s\n", argv[0],
+				argv[optind]);
+			exit(-1);
+		}
+	}
+
+	fd = open(mem, O_RDONLY | O_SYNC);
+	if (fd < 0 || map_targets(fd, base) < 0) {
+		perror(mem);
+		exit(-1);
+	}
+	if (outpath) {
+		out = fopen(outpath, "w");
+		if (!out) {
+			perror(outpath);
+			exit(-1);
+		}
+	}
+	ring.buf = malloc(ring_size * sizeof(*ring.buf));
+	if (!ring.buf) {
+		perror(argv[0]);
+		exit(-1);
+	}
+	/* fault the ring in now rather than in the sampler */
+	memset(ring.buf, 0, ring_size * sizeof(*ring.buf));
+	ring.mask = ring_size - 1;
+
+	signal(SIGINT, on_sigint);
+	write_header(out, binary);
+
+	pthread_attr_init(&attr);
+	if (prio) {
+		sp.sched_priority = prio;
+		pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+		pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+		pthread_attr_setschedparam(&attr, &sp);
+	}
+	if (pthread_create(&thread, &attr, sampler, NULL)) {
+		fprintf(stderr, "%s: couldn't start the sampler\n", argv[0]);
+		exit(-1);
+	}
+	drain(out, binary);
+	pthread_join(thread, NULL);
+
+	fprintf(stderr, "%" PRIu64 " samples in %.3f s: %.1f Hz of %" PRIu64
+		" Hz asked for, %" PRIu64 " dropped, %" PRIu64 " ticks missed\n",
+		taken, elapsed_ns / 1e9,
+		elapsed_ns ? taken * 1e9 / elapsed_ns : 0.0, rate_hz,
+		dropped, missed);
+
+	if (out != stdout)
+		fclose(out);
+	return 0;
+}
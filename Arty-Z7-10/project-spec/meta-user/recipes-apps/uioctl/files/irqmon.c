@@ -0,0 +1,406 @@
+/*
+ * irqmon.c: interrupt monitor for UIO devices
+ *
+ * Waits on any number of UIO devices at once with epoll, timestamps every
+ * interrupt with CLOCK_MONOTONIC_RAW and keeps interval, latency and
+ * service time statistics for each device. eventfds can stand in for the
+ * devices, which is how irqmon_selftest() checks all of this without any
+ * hardware.
+ *
+ * GPLv3 License, see uioctl.c
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "irqmon.h"
+
+static volatile sig_atomic_t irqmon_stop;
+
+static void irqmon_sigint(int sig) {
+    (void)sig;
+    irqmon_stop = 1;
+}
+
+uint64_t irqmon_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int irqmon_bucket(uint64_t v) {
+    int i = 0;
+
+    while (v > 1 && i < IRQMON_HIST_BUCKETS - 1) {
+        v >>= 1;
+        i++;
+    }
+    return i;
+}
+
+void irqmon_stats_add(struct irqmon_stats *s, uint64_t v) {
+    double d;
+
+    if (s->n == 0 || v < s->min)
+        s->min = v;
+    if (v > s->max)
+        s->max = v;
+    s->n++;
+    d = v - s->mean;
+    s->mean += d / s->n;
+    s->m2 += d * (v - s->mean);
+    s->hist[irqmon_bucket(v)]++;
+}
+
+static double irqmon_stddev(const struct irqmon_stats *s) {
+    return s->n > 1 ? sqrt(s->m2 / (s->n - 1)) : 0;
+}
+
+void irqmon_source_init(struct irqmon_source *src, const char *name, int fd,
+                        int is_eventfd) {
+    memset(src, 0, sizeof(*src));
+    src->name = name;
+    src->fd = fd;
+    src->is_eventfd = is_eventfd;
+}
+
+int irqmon_source_open(struct irqmon_source *src, const char *path) {
+    int fd;
+
+    fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        perror("uioctl");
+        fprintf(stderr, "Couldn't open UIO device file: %s\n", path);
+        return -1;
+    }
+    irqmon_source_init(src, path, fd, 0);
+    return 0;
+}
+
+/* Re-enable a UIO device's interrupt; eventfds need nothing */
+static int irqmon_arm(struct irqmon_source *src) {
+    uint32_t one = 1;
+
+    if (src->is_eventfd)
+        return 0;
+    if (pwrite(src->fd, &one, sizeof(one), 0) != sizeof(one)) {
+        perror("uioctl");
+        fprintf(stderr, "Problem clearing device file %s\n", src->name);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Read how many interrupts there were. Returns 0 if there were none after
+ * all, -1 on error.
+ */
+static int irqmon_ack(struct irqmon_source *src, uint32_t *count,
+                      uint64_t *n) {
+    uint64_t val;
+    uint32_t cnt;
+
+    if (src->is_eventfd) {
+        if (read(src->fd, &val, sizeof(val)) != sizeof(val))
+            return errno == EAGAIN ? 0 : -1;
+        src->last_count += val;
+        *count = src->last_count;
+        *n = val;
+        return 1;
+    }
+    if (pread(src->fd, &cnt, sizeof(cnt), 0) != sizeof(cnt))
+        return errno == EAGAIN ? 0 : -1;
+    *n = src->events ? (uint32_t)(cnt - src->last_count) : 1;
+    src->last_count = cnt;
+    *count = cnt;
+    return 1;
+}
+
+/*
+ * Record one wake-up of src at wake_ns. Returns how many interrupts it
+ * stands for, 0 if none, -1 on error.
+ */
+static int irqmon_event(struct irqmon_source *src, uint64_t wake_ns,
+                        const struct irqmon_opts *opts) {
+    uint64_t n, fired, done_ns, interval = 0, latency = 0;
+    uint32_t count;
+    int ret;
+
+    ret = irqmon_ack(src, &count, &n);
+    if (ret <= 0) {
+        if (ret < 0) {
+            perror("uioctl");
+            fprintf(stderr, "Problem reading from device file %s\n",
+                    src->name);
+        }
+        return ret;
+    }
+    if (irqmon_arm(src) < 0)
+        return -1;
+    done_ns = irqmon_now_ns();
+
+    if (n > 1)
+        src->missed += n - 1;
+    if (src->events) {
+        interval = wake_ns - src->last_ns;
+        irqmon_stats_add(&src->interval, interval);
+    }
+    // a stamp from after we woke up belongs to the next event
+    fired = __atomic_load_n(&src->fired_ns, __ATOMIC_ACQUIRE);
+    if (fired && fired <= wake_ns) {
+        __atomic_compare_exchange_n(&src->fired_ns, &fired, 0, 0,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        latency = wake_ns - fired;
+        irqmon_stats_add(&src->latency, latency);
+    }
+    irqmon_stats_add(&src->service, done_ns - wake_ns);
+    src->last_ns = wake_ns;
+    src->events++;
+
+    if (!opts->quiet)
+        printf("[%" PRIu64 ".%09" PRIu64 "] %s interrupt: %u\n",
+               wake_ns / 1000000000, wake_ns % 1000000000, src->name,
+               count);
+    if (opts->csv)
+        fprintf(opts->csv, "%s,%" PRIu64 ",%u,%" PRIu64 ",%" PRIu64 ",%"
+                PRIu64 ",%" PRIu64 "\n", src->name, src->events, count,
+                wake_ns, interval, latency, done_ns - wake_ns);
+    return n > 0xffff ? 0xffff : (int)n;
+}
+
+/* Apply the scheduling policy and CPU affinity asked for to this thread */
+int irqmon_setup_thread(const struct irqmon_opts *opts) {
+    struct sched_param sp;
+    cpu_set_t set;
+
+    if (opts->cpu >= 0) {
+        CPU_ZERO(&set);
+        CPU_SET(opts->cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) < 0) {
+            perror("sched_setaffinity");
+            return -1;
+        }
+    }
+    if (opts->fifo_prio > 0) {
+        memset(&sp, 0, sizeof(sp));
+        sp.sched_priority = opts->fifo_prio;
+        if (sched_setscheduler(0, SCHED_FIFO, &sp) < 0) {
+            perror("sched_setscheduler");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Wait for interrupts on all n sources until opts says to stop or SIGINT.
+ * Returns 0, or -1 on error.
+ */
+int irqmon_run(struct irqmon_source *srcs, int n,
+               const struct irqmon_opts *opts) {
+    struct epoll_event ev, evs[IRQMON_MAX_SOURCES];
+    uint64_t total = 0, start_ns, end_ns = 0, wake_ns;
+    int epfd, i, ready, timeout = -1, ret = 0;
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        perror("epoll_create1");
+        return -1;
+    }
+    for (i = 0; i < n; i++) {
+        ev.events = EPOLLIN;
+        ev.data.ptr = &srcs[i];
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, srcs[i].fd, &ev) < 0 ||
+            irqmon_arm(&srcs[i]) < 0) {
+            perror("epoll_ctl");
+            close(epfd);
+            return -1;
+        }
+    }
+
+    irqmon_stop = 0;
+    signal(SIGINT, irqmon_sigint);
+    start_ns = irqmon_now_ns();
+    if (opts->duration > 0)
+        end_ns = start_ns + (uint64_t)(opts->duration * 1e9);
+
+    while (!irqmon_stop) {
+        if (end_ns) {
+            wake_ns = irqmon_now_ns();
+            if (wake_ns >= end_ns)
+                break;
+            timeout = (end_ns - wake_ns + 999999) / 1000000;
+        }
+        ready = epoll_wait(epfd, evs, IRQMON_MAX_SOURCES, timeout);
+        wake_ns = irqmon_now_ns();
+        if (ready < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("epoll_wait");
+            ret = -1;
+            break;
+        }
+        for (i = 0; i < ready; i++) {
+            ret = irqmon_event(evs[i].data.ptr, wake_ns, opts);
+            if (ret < 0)
+                break;
+            total += ret;
+            ret = 0;
+        }
+        if (ret < 0 || (opts->max_events && total >= opts->max_events))
+            break;
+    }
+
+    signal(SIGINT, SIG_DFL);
+    close(epfd);
+    return ret;
+}
+
+static void irqmon_report_stats(FILE *f, const char *what,
+                                const struct irqmon_stats *s) {
+    if (!s->n)
+        return;
+    fprintf(f, "  %-9s n %-8" PRIu64 " min %-10" PRIu64 " mean %-12.0f "
+            "max %-10" PRIu64 " jitter %.0f (ns)\n", what, s->n, s->min,
+            s->mean, s->max, irqmon_stddev(s));
+}
+
+/* Print a summary, and the latency histogram where there is one */
+void irqmon_report(FILE *f, const struct irqmon_source *srcs, int n) {
+    const struct irqmon_stats *h;
+    int i, b;
+
+    for (i = 0; i < n; i++) {
+        fprintf(f, "%s: %" PRIu64 " interrupts, %" PRIu64 " missed\n",
+                srcs[i].name, srcs[i].events, srcs[i].missed);
+        irqmon_report_stats(f, "interval", &srcs[i].interval);
+        irqmon_report_stats(f, "latency", &srcs[i].latency);
+        irqmon_report_stats(f, "service", &srcs[i].service);
+
+        h = srcs[i].latency.n ? &srcs[i].latency : &srcs[i].interval;
+        if (!h->n)
+            continue;
+        fprintf(f, "  %s histogram:\n", h == &srcs[i].latency ?
+                "latency" : "interval");
+        for (b = 0; b < IRQMON_HIST_BUCKETS; b++) {
+            if (h->hist[b])
+                fprintf(f, "    < %-12llu ns %" PRIu64 "\n",
+                        2ull << b, h->hist[b]);
+        }
+    }
+}
+
+struct irqmon_gen {
+    struct irqmon_source *srcs;
+    int n;
+    unsigned period_us;
+    unsigned events;
+};
+
+/* Raise events round robin on the stand-ins, one every period_us */
+static void *irqmon_gen_thread(void *arg) {
+    struct irqmon_gen *gen = arg;
+    struct irqmon_source *src;
+    struct timespec next;
+    uint64_t one = 1;
+    unsigned i;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (i = 0; i < gen->events; i++) {
+        next.tv_nsec += gen->period_us * 1000L;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        src = &gen->srcs[i % gen->n];
+        __atomic_store_n(&src->fired_ns, irqmon_now_ns(), __ATOMIC_RELEASE);
+        if (write(src->fd, &one, sizeof(one)) != sizeof(one))
+            break;
+    }
+    return NULL;
+}
+
+/*
+ * Monitor n eventfds while a thread raises events on them, round robin
+ * every period_us, and check that every event was seen with its latency.
+ * Returns 0 if so.
+ */
+int irqmon_selftest(int n, unsigned period_us, unsigned events,
+                    const struct irqmon_opts *opts) {
+    struct irqmon_source srcs[IRQMON_MAX_SOURCES];
+    char names[IRQMON_MAX_SOURCES][16];
+    struct irqmon_opts run = *opts;
+    struct irqmon_gen gen;
+    pthread_t thread;
+    uint64_t seen = 0;
+    int i, fd, ret = 0;
+
+    if (n < 1 || n > IRQMON_MAX_SOURCES || !events) {
+        fprintf(stderr, "Self-test needs 1 to %d sources and some events\n",
+                IRQMON_MAX_SOURCES);
+        return -1;
+    }
+    for (i = 0; i < n; i++) {
+        fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fd < 0) {
+            perror("eventfd");
+            return -1;
+        }
+        snprintf(names[i], sizeof(names[i]), "eventfd%d", i);
+        irqmon_source_init(&srcs[i], names[i], fd, 1);
+    }
+
+    // give up after twice as long as the events should take, plus a second
+    run.max_events = events;
+    run.duration = 2.0 * events * period_us / 1e6 + 1;
+    if (irqmon_setup_thread(opts) < 0)
+        return -1;
+    gen.srcs = srcs;
+    gen.n = n;
+    gen.period_us = period_us;
+    gen.events = events;
+    if (pthread_create(&thread, NULL, irqmon_gen_thread, &gen)) {
+        fprintf(stderr, "Couldn't start the event thread\n");
+        return -1;
+    }
+    if (irqmon_run(srcs, n, &run) < 0)
+        ret = -1;
+    pthread_join(thread, NULL);
+
+    irqmon_report(stdout, srcs, n);
+    for (i = 0; i < n; i++) {
+        seen += srcs[i].events + srcs[i].missed;
+        if (srcs[i].events + srcs[i].missed !=
+            events / n + ((unsigned)i < events % n)) {
+            fprintf(stderr, "%s: saw %" PRIu64 " events\n", srcs[i].name,
+                    srcs[i].events + srcs[i].missed);
+            ret = -1;
+        }
+        if (srcs[i].latency.n != srcs[i].events) {
+            fprintf(stderr, "%s: no latency for %" PRIu64 " events\n",
+                    srcs[i].name, srcs[i].events - srcs[i].latency.n);
+            ret = -1;
+        }
+        close(srcs[i].fd);
+    }
+    printf("Self-test %s: %" PRIu64 " of %u events seen\n",
+           ret ? "FAILED" : "passed", seen, events);
+    return ret;
+}
@@ -0,0 +1,71 @@
+/*
+ * irqmon.h: interrupt monitor for UIO devices
+ *
+ * GPLv3 License, see uioctl.c
+ */
+
+#ifndef IRQMON_H
+#define IRQMON_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define IRQMON_MAX_SOURCES 32
+
+/* histogram bucket i counts values in [2^i, 2^(i+1)) ns, bucket 0 also 0 */
+#define IRQMON_HIST_BUCKETS 40
+
+struct irqmon_stats {
+    uint64_t n;
+    uint64_t min;
+    uint64_t max;
+    double mean;        /* running mean and sum of squared differences */
+    double m2;
+    uint64_t hist[IRQMON_HIST_BUCKETS];
+};
+
+/*
+ * One thing to wait on: a /dev/uioX device, or an eventfd standing in for
+ * one. A UIO read gives the total interrupt count and the interrupt has to
+ * be re-enabled with a write after each one; an eventfd read gives the
+ * number of events since the last read.
+ */
+struct irqmon_source {
+    const char *name;
+    int fd;
+    int is_eventfd;
+    uint32_t last_count;    /* UIO interrupt count at the last event */
+    uint64_t events;
+    uint64_t missed;        /* interrupts that came while we were busy */
+    uint64_t last_ns;
+    uint64_t fired_ns;      /* when the event was raised, if known */
+    struct irqmon_stats interval;
+    struct irqmon_stats latency;    /* raised to woken up, when known */
+    struct irqmon_stats service;    /* woken up to re-armed */
+};
+
+struct irqmon_opts {
+    uint64_t max_events;    /* stop after this many in total, 0: never */
+    double duration;        /* stop after this many seconds, 0: never */
+    int quiet;              /* do not print every interrupt */
+    int fifo_prio;          /* run at this SCHED_FIFO priority, 0: don't */
+    int cpu;                /* pin to this CPU, -1: don't */
+    FILE *csv;              /* write every interrupt here, if set */
+};
+
+uint64_t irqmon_now_ns(void);
+void irqmon_stats_add(struct irqmon_stats *s, uint64_t v);
+
+int irqmon_source_open(struct irqmon_source *src, const char *path);
+void irqmon_source_init(struct irqmon_source *src, const char *name, int fd,
+                        int is_eventfd);
+
+int irqmon_setup_thread(const struct irqmon_opts *opts);
+int irqmon_run(struct irqmon_source *srcs, int n,
+               const struct irqmon_opts *opts);
+void irqmon_report(FILE *f, const struct irqmon_source *srcs, int n);
+
+int irqmon_selftest(int n, unsigned period_us, unsigned events,
+                    const struct irqmon_opts *opts);
+
+#endif /* IRQMON_H */
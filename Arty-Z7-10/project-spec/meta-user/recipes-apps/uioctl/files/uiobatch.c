@@ -0,0 +1,158 @@
+/*
+ * uiobatch.c: run a script of register accesses within one mapping
+ *
+ * Each line of the script is one operation; # starts a comment:
+ *
+ *   r[W] <addr> [<count>]              read count words (default 1)
+ *   w[W] <addr> <value> [<value> ...]  write consecutive words
+ *   p[W] <addr> <mask> <value> [<timeout_us>]
+ *                                      poll until (word & mask) == value
+ *   s <us>                             sleep
+ *
+ * W is the word width in bytes, 1, 2, 4 or 8, and defaults to uioctl's -w.
+ * Any operation can be prefixed with @<n> to run it n times. Reads print
+ * what they read, from the last run, and every operation prints how long
+ * it took, as "# <ns> ns", or "# min/mean/max <ns> ns" when repeated.
+ *
+ * GPLv3 License, see uioctl.c
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "uiomap.h"
+
+#define UIOBATCH_MAX_ARGS 64
+#define UIOBATCH_POLL_TIMEOUT_US 1000000
+
+static uint64_t uiobatch_now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/*
+ * Run one operation once. Reads go to out when print is set. Returns 0, 1
+ * if a poll timed out, or -1 if the operation is not valid.
+ */
+static int uiobatch_op(const struct uiomap *m, char op, int width,
+                       uint64_t *args, int nargs, FILE *out, int print) {
+    uint64_t i, val, deadline;
+    size_t addr = args[0];
+
+    switch (op) {
+    case 'r':
+        if (nargs > 2 || uiomap_check(m, addr, width,
+                                      nargs > 1 ? args[1] : 1) < 0)
+            return -1;
+        for (i = 0; i < (nargs > 1 ? args[1] : 1); i++) {
+            val = uiomap_read(m, addr + i * width, width);
+            if (print)
+                uiomap_print(out, addr + i * width, width, val);
+        }
+        return 0;
+    case 'w':
+        if (nargs < 2 || uiomap_check(m, addr, width, nargs - 1) < 0)
+            return -1;
+        for (i = 1; i < (uint64_t)nargs; i++)
+            uiomap_write(m, addr + (i - 1) * width, width, args[i]);
+        return 0;
+    case 'p':
+        if (nargs < 3 || nargs > 4 || uiomap_check(m, addr, width, 1) < 0)
+            return -1;
+        deadline = uiobatch_now_ns() +
+            (nargs > 3 ? args[3] : UIOBATCH_POLL_TIMEOUT_US) * 1000;
+        do {
+            val = uiomap_read(m, addr, width);
+            if ((val & args[1]) == args[2])
+                return 0;
+        } while (uiobatch_now_ns() < deadline);
+        fprintf(out, "# timeout, last read:\n");
+        uiomap_print(out, addr, width, val);
+        return 1;
+    case 's':
+        if (nargs != 1)
+            return -1;
+        usleep(args[0]);
+        return 0;
+    }
+    return -1;
+}
+
+/* Run every operation in in, writing the results to out */
+int uiobatch_run(const struct uiomap *m, FILE *in, FILE *out, int width) {
+    uint64_t args[UIOBATCH_MAX_ARGS], t, min, max, total, start;
+    unsigned long repeat, r, lineno = 0, ops = 0;
+    char line[1024], *tok, *end, op;
+    int nargs, w, ret, failed = 0;
+
+    start = uiobatch_now_ns();
+    while (fgets(line, sizeof(line), in)) {
+        lineno++;
+        line[strcspn(line, "#\n")] = '\0';
+        tok = strtok(line, " \t");
+        if (!tok)
+            continue;
+
+        repeat = 1;
+        if (tok[0] == '@') {
+            repeat = strtoul(tok + 1, NULL, 0);
+            tok = strtok(NULL, " \t");
+            if (!tok || !repeat)
+                goto bad;
+        }
+        op = tok[0];
+        w = tok[1] ? (int)strtol(tok + 1, &end, 10) : width;
+        if (strchr("rwps", op) == NULL || (tok[1] && *end))
+            goto bad;
+
+        for (nargs = 0; (tok = strtok(NULL, " \t")) != NULL; nargs++) {
+            errno = 0;
+            if (nargs == UIOBATCH_MAX_ARGS)
+                goto bad;
+            args[nargs] = strtoull(tok, &end, 0);
+            if (errno || *end)
+                goto bad;
+        }
+        if (nargs == 0)
+            goto bad;
+
+        min = UINT64_MAX;
+        max = total = 0;
+        for (r = 0; r < repeat; r++) {
+            t = uiobatch_now_ns();
+            ret = uiobatch_op(m, op, w, args, nargs, out, r == repeat - 1);
+            t = uiobatch_now_ns() - t;
+            if (ret < 0)
+                goto bad;
+            min = t < min ? t : min;
+            max = t > max ? t : max;
+            total += t;
+            if (ret > 0) {
+                failed = 1;
+                r++;
+                break;
+            }
+        }
+        ops++;
+        if (r == 1)
+            fprintf(out, "# %" PRIu64 " ns\n", total);
+        else
+            fprintf(out, "# min/mean/max %" PRIu64 "/%" PRIu64 "/%" PRIu64
+                    " ns\n", min, total / r, max);
+        continue;
+bad:
+        fprintf(stderr, "Bad operation on line %lu; try -h\n", lineno);
+        return -1;
+    }
+
+    fprintf(out, "# %lu operations in %" PRIu64 " ns\n", ops,
+            uiobatch_now_ns() - start);
+    return failed ? -1 : 0;
+}
@@ -29,87 +29,126 @@
 #include <fcntl.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <unistd.h>
-#include <sys/mman.h>
-#include <sys/timeb.h>
+
+#include "irqmon.h"
+#include "uiomap.h"
 
 #define DEFAULT_WIDTH 4
+#define DEFAULT_PERIOD_US 1000
+#define MAX_VALUES 256
+#define DEFAULT_SELFTEST_EVENTS 1000
 #define PROGRAM_NAME "uioctl"
 
 enum mode_type {
     MODE_READ,
     MODE_WRITE,
-    MODE_MONITOR
+    MODE_MONITOR,
+    MODE_LIST,
+    MODE_BATCH
 };
 
 static void usage(int exit_status) {
     fprintf(exit_status == EXIT_SUCCESS ? stdout : stderr,
-        "Usage: %s [options] [/dev/uioX [-m] [<addr> [<value>]]]\n"
+        "Usage: %s [options] [/dev/uioX [-m] [<addr> [<value>...]]]\n"
+        "       %s -m [monitor options] /dev/uioX [/dev/uioY ...]\n"
+        "       %s -T <n> [monitor options]\n"
         "\n"
         "Functions:\n"
-        "  monitor (-m) the device for interrupts\n"
+        "  monitor (-m) the devices for interrupts\n"
+        "  list (-l) the device's memory regions\n"
         "  read words from <addr>\n"
-        "  write <value> to <addr> (will zero-pad word width)\n"
+        "  write <value> to <addr>, or several values to consecutive words\n"
+        "  (will zero-pad word width)\n"
+        "  run a batch (-b) of operations from a file (- for stdin), one\n"
+        "  per line, each timed:\n"
+        "    r[W] <addr> [<count>]               read words\n"
+        "    w[W] <addr> <value> [<value>...]    write consecutive words\n"
+        "    p[W] <addr> <mask> <value> [<timeout_us>]  poll for a value\n"
+        "    s <us>                              sleep\n"
+        "  with W an optional width and an optional @<n> prefix to repeat\n"
+        "  self-test (-T) the monitor on <n> eventfds standing in for devices\n"
         "\n"
         "Options:\n"
         "  -r\tselect the device's memory region to map (default: 0)\n"
-        "  -w\tword size (in bytes; default: %d)\n"
-        "  -n\tnumber of words to read (in words; default: 1)\n"
+        "  -w\tword size (in bytes, 1, 2, 4 or 8; default: %d)\n"
+        "  -n\tnumber of words to read, or to fill with one written value\n"
+        "    \t(in words; default: 1)\n"
+        "  -b\trun the operations in this file\n"
         "  -x\texit with success after the first interrupt (implies -m mode)\n"
+        "\n"
+        "Monitor options:\n"
+        "  -e\tstop after this many interrupts in total\n"
+        "  -t\tstop after this many seconds\n"
+        "  -q\tonly print the statistics, not every interrupt\n"
+        "  -c\twrite every interrupt to this CSV file\n"
+        "  -p\trun at this SCHED_FIFO priority\n"
+        "  -a\tpin to this CPU\n"
+        "  -i\tself-test: microseconds between events (default: %d)\n"
         ,
-        PROGRAM_NAME, DEFAULT_WIDTH);
+        PROGRAM_NAME, PROGRAM_NAME, PROGRAM_NAME, DEFAULT_WIDTH,
+        DEFAULT_PERIOD_US);
     exit(exit_status);
 }
 
-static void monitor(char *fpath, int forever) {
-    char buf[4];
-    int bytes;
-    int fd;
-    struct timeb tp;
-    char startval[] = {0,0,0,1};
-   
-    printf("Waiting for interrupts on %s\n", fpath);
-    fd = open(fpath, O_RDWR|O_SYNC);
-    if (fd < 1) {
-        perror("uioctl");
-        fprintf(stderr, "Couldn't open UIO device file: %s\n", fpath);
+static void monitor(char **paths, int n, struct irqmon_opts *opts) {
+    struct irqmon_source srcs[IRQMON_MAX_SOURCES];
+    int i, ret;
+
+    if (n > IRQMON_MAX_SOURCES) {
+        fprintf(stderr, "Can't monitor more than %d devices\n",
+                IRQMON_MAX_SOURCES);
         exit(EXIT_FAILURE);
     }
-    do {
-        bytes = pwrite(fd, &startval, 4, 0);
-        if (bytes != 4) {
-            perror("uioctl");
-            fprintf(stderr, "Problem clearing device file\n");
-            exit(EXIT_FAILURE);
-        }
-        //lseek(fd, 0, SEEK_SET);
-        bytes = pread(fd, buf, 4, 0);
-        ftime(&tp);
-        if (bytes != 4) {
-            perror("uioctl");
-            fprintf(stderr, "Problem reading from device file\n");
+    for (i = 0; i < n; i++) {
+        if (irqmon_source_open(&srcs[i], paths[i]) < 0)
             exit(EXIT_FAILURE);
-        }
-        printf("[%ld.%03d] interrupt: %d\n", tp.time, tp.millitm,
-            (buf[3] * 16777216 + buf[2] * 65536 + buf[1] * 256 + buf[0]));
-    } while (forever);
-    close(fd);
-    exit(EXIT_SUCCESS);
+        printf("Waiting for interrupts on %s\n", paths[i]);
+    }
+    if (irqmon_setup_thread(opts) < 0)
+        exit(EXIT_FAILURE);
+
+    ret = irqmon_run(srcs, n, opts);
+    if (opts->max_events != 1)
+        irqmon_report(stdout, srcs, n);
+    for (i = 0; i < n; i++)
+        close(srcs[i].fd);
+    exit(ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+static FILE *open_csv(const char *path) {
+    FILE *f;
+
+    f = fopen(path, "w");
+    if (!f) {
+        perror("uioctl");
+        fprintf(stderr, "Couldn't open CSV file: %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    fprintf(f, "device,seq,count,time_ns,interval_ns,latency_ns,service_ns\n");
+    return f;
 }
 
 int main(int argc, char *argv[]) {
     int c;
-    int fd;
     enum mode_type mode = MODE_READ;
     char *fpath;
-    void *ptr;
-    int map_size, value, addr;
+    char *batch = NULL;
+    struct uiomap map;
+    uint64_t values[MAX_VALUES];
+    size_t addr;
+    int nvalues = 0;
     int region = 0;
     int count = 1;
     int width = DEFAULT_WIDTH;
-    int forever = 1;
+    int i, ret = EXIT_SUCCESS;
+    FILE *f;
+    int selftest = 0;
+    unsigned period_us = DEFAULT_PERIOD_US;
+    struct irqmon_opts opts = { .cpu = -1 };
 
-    while((c = getopt(argc, argv, "hlmxr:n:w:")) != -1) {
+    while((c = getopt(argc, argv, "hlmxqr:n:w:b:e:t:c:p:a:T:i:")) != -1) {
         errno = 0;
         switch(c) {
         case 'h':
@@ -117,9 +156,40 @@ int main(int argc, char *argv[]) {
         case 'm':
             mode = MODE_MONITOR;
             break;
+        case 'l':
+            mode = MODE_LIST;
+            break;
+        case 'b':
+            mode = MODE_BATCH;
+            batch = optarg;
+            break;
         case 'x':
             mode = MODE_MONITOR;
-            forever = 0;
+            opts.max_events = 1;
+            break;
+        case 'q':
+            opts.quiet = 1;
+            break;
+        case 'e':
+            opts.max_events = strtoull(optarg, NULL, 0);
+            break;
+        case 't':
+            opts.duration = strtod(optarg, NULL);
+            break;
+        case 'c':
+            opts.csv = open_csv(optarg);
+            break;
+        case 'p':
+            opts.fifo_prio = strtoul(optarg, NULL, 0);
+            break;
+        case 'a':
+            opts.cpu = strtoul(optarg, NULL, 0);
+            break;
+        case 'T':
+            selftest = strtoul(optarg, NULL, 0);
+            break;
+        case 'i':
+            period_us = strtoul(optarg, NULL, 0);
             break;
         case 'r':
             region = strtoul(optarg, NULL, 0);
@@ -127,8 +197,9 @@ int main(int argc, char *argv[]) {
                 perror("uioctl");
                 exit(EXIT_FAILURE);
             }
-            if (region != 0) {
-                fprintf(stderr, "region != 0 not yet implemented\n");
+            if (region < 0 || region >= UIOMAP_MAX_MAPS) {
+                fprintf(stderr, "region must be 0 to %d\n",
+                        UIOMAP_MAX_MAPS - 1);
                 exit(EXIT_FAILURE);
             }
             break;
@@ -145,8 +216,8 @@ int main(int argc, char *argv[]) {
                 perror("uioctl");
                 exit(EXIT_FAILURE);
             }
-            if (width != 4) {
-                fprintf(stderr, "width != 4 not yet implemented\n");
+            if (width != 1 && width != 2 && width != 4 && width != 8) {
+                fprintf(stderr, "width must be 1, 2, 4 or 8\n");
                 exit(EXIT_FAILURE);
             }
             break;
@@ -156,75 +227,84 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    if (selftest) {
+        if (!opts.max_events)
+            opts.max_events = DEFAULT_SELFTEST_EVENTS;
+        opts.quiet = 1;
+        c = irqmon_selftest(selftest, period_us, opts.max_events, &opts);
+        if (opts.csv)
+            fclose(opts.csv);
+        return c < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
     if (mode == MODE_MONITOR) {
+        if ((argc - optind) < 1) {
+            fprintf(stderr, "Wrong number of arguments; try -h\n");
+            exit(EXIT_FAILURE);
+        }
+        monitor(&argv[optind], argc - optind, &opts);
+    }
+    if (mode == MODE_LIST) {
         if ((argc - optind) != 1) {
             fprintf(stderr, "Wrong number of arguments; try -h\n");
             exit(EXIT_FAILURE);
         }
-        fpath = argv[optind];
-        monitor(fpath, forever);
+        return uiomap_list(stdout, argv[optind]) < 0 ?
+            EXIT_FAILURE : EXIT_SUCCESS;
     }
-    if (mode == MODE_READ) {
-        if ((argc - optind) == 2) {
-            fpath = argv[optind++];
-            errno = 0;
-            addr = strtoul(argv[optind++], NULL, 0);
-            if (errno) {
-                perror("uioctl");
-                exit(EXIT_FAILURE);
-            }
-            //printf("addr: 0x%08x\n", addr);
-        } else
-        if ((argc - optind) == 3) {
-            mode = MODE_WRITE;
-            fpath = argv[optind++];
-            errno = 0;
-            addr = strtoul(argv[optind++], NULL, 0);
-            value = strtoul(argv[optind++], NULL, 0);
-            if (errno) {
-                perror("uioctl");
-                exit(EXIT_FAILURE);
-            }
-            //printf("addr: 0x%08x\n", addr);
-            //printf("value: 0x%08x\n", value);
-        } else {
+    if (mode == MODE_BATCH) {
+        if ((argc - optind) != 1) {
             fprintf(stderr, "Wrong number of arguments; try -h\n");
             exit(EXIT_FAILURE);
         }
+        fpath = argv[optind];
+    } else if ((argc - optind) >= 2 && (argc - optind) <= 2 + MAX_VALUES) {
+        fpath = argv[optind++];
+        errno = 0;
+        addr = strtoul(argv[optind++], NULL, 0);
+        for (; optind < argc; optind++)
+            values[nvalues++] = strtoull(argv[optind], NULL, 0);
+        if (errno) {
+            perror("uioctl");
+            exit(EXIT_FAILURE);
+        }
+        if (nvalues > 0)
+            mode = MODE_WRITE;
+        if (nvalues > 1)
+            count = nvalues;
+    } else {
+        fprintf(stderr, "Wrong number of arguments; try -h\n");
+        exit(EXIT_FAILURE);
     }
 
-    map_size = count * width;
-
-    fd = open(fpath, O_RDWR|O_SYNC);
-    if (fd < 1) {
-        perror("uioctl");
-        fprintf(stderr, "Couldn't open UIO device file: %s\n", fpath);
-        return EXIT_FAILURE;
-    }
-    /* NOTE: with UIO the offset is not a normal offset; it's a region
-     * selector.
-     */
-    ptr = mmap(NULL, map_size + addr, PROT_READ|PROT_WRITE,
-               MAP_SHARED, fd, 0);
-    if (ptr == MAP_FAILED) {
-        perror("mmap");
-        fprintf(stderr, "Couldn't mmap.\n");
+    if (uiomap_open(&map, fpath, region) < 0)
         return EXIT_FAILURE;
-    }
 
-    if (mode == MODE_READ) {
-        for (; count > 0; count--) {
-            value = *((unsigned *) (ptr + addr));
-            printf("0x%08x\t%08x\n", addr, value);
-            addr += width;
+    if (mode == MODE_BATCH) {
+        f = strcmp(batch, "-") ? fopen(batch, "r") : stdin;
+        if (!f) {
+            perror("uioctl");
+            fprintf(stderr, "Couldn't open batch file: %s\n", batch);
+            ret = EXIT_FAILURE;
+        } else {
+            if (uiobatch_run(&map, f, stdout, width) < 0)
+                ret = EXIT_FAILURE;
+            if (f != stdin)
+                fclose(f);
         }
+    } else if (uiomap_check(&map, addr, width, count) < 0) {
+        ret = EXIT_FAILURE;
+    } else if (mode == MODE_READ) {
+        for (i = 0; i < count; i++)
+            uiomap_print(stdout, addr + i * width, width,
+                         uiomap_read(&map, addr + i * width, width));
     } else {
-        *((unsigned *)(ptr + addr)) = value;
+        for (i = 0; i < count; i++)
+            uiomap_write(&map, addr + i * width, width,
+                         values[nvalues > 1 ? i : 0]);
     }
 
     /* clean up */
-    munmap(ptr, map_size);
-    close(fd);
+    uiomap_close(&map);
 
-    return EXIT_SUCCESS;
+    return ret;
 }
@@ -0,0 +1,200 @@
+/*
+ * uiomap.c: mapping and accessing UIO device memory regions
+ *
+ * A UIO device has up to UIOMAP_MAX_MAPS memory regions, described in
+ * /sys/class/uio/uioX/maps/mapN. Region N is mapped with an mmap offset
+ * of N pages, and starts offset bytes into that mapping when it is not
+ * page aligned. A plain file can stand in for a device, in which case it
+ * is treated as a single region the size of the file.
+ *
+ * GPLv3 License, see uioctl.c
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <libgen.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "uiomap.h"
+
+/*
+ * Read one attribute of map region of the device at path, as a number, or
+ * as a string into buf if it is set. Returns -1 if there is no such map.
+ */
+static int uiomap_attr(const char *path, int region, const char *attr,
+                       unsigned long long *val, char *buf, size_t len) {
+    char *copy, sysfs[256], line[128];
+    FILE *f;
+
+    copy = strdup(path);
+    if (!copy)
+        return -1;
+    snprintf(sysfs, sizeof(sysfs), "/sys/class/uio/%s/maps/map%d/%s",
+             basename(copy), region, attr);
+    free(copy);
+
+    f = fopen(sysfs, "r");
+    if (!f)
+        return -1;
+    if (!fgets(line, sizeof(line), f)) {
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+    line[strcspn(line, "\n")] = '\0';
+    if (buf)
+        snprintf(buf, len, "%s", line);
+    else
+        *val = strtoull(line, NULL, 0);
+    return 0;
+}
+
+/* Print every memory region of a device */
+int uiomap_list(FILE *f, const char *path) {
+    unsigned long long addr, size, offset;
+    char name[128];
+    int region, found = 0;
+
+    for (region = 0; region < UIOMAP_MAX_MAPS; region++) {
+        if (uiomap_attr(path, region, "size", &size, NULL, 0) < 0)
+            break;
+        if (uiomap_attr(path, region, "addr", &addr, NULL, 0) < 0)
+            addr = 0;
+        if (uiomap_attr(path, region, "offset", &offset, NULL, 0) < 0)
+            offset = 0;
+        if (uiomap_attr(path, region, "name", NULL, name, sizeof(name)) < 0)
+            name[0] = '\0';
+        if (!found)
+            fprintf(f, "region\taddr\t\tsize\t\toffset\tname\n");
+        fprintf(f, "%d\t0x%08llx\t0x%08llx\t0x%llx\t%s\n", region, addr,
+                size, offset, name);
+        found = 1;
+    }
+    if (!found) {
+        fprintf(stderr, "No memory regions found for %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/* Map one memory region of a device, or all of a plain file */
+int uiomap_open(struct uiomap *m, const char *path, int region) {
+    unsigned long long size, offset = 0;
+    long page = sysconf(_SC_PAGESIZE);
+    struct stat st;
+
+    memset(m, 0, sizeof(*m));
+    m->path = path;
+    m->region = region;
+    m->fd = open(path, O_RDWR | O_SYNC | O_CLOEXEC);
+    if (m->fd < 0) {
+        perror("uioctl");
+        fprintf(stderr, "Couldn't open UIO device file: %s\n", path);
+        return -1;
+    }
+
+    if (fstat(m->fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        if (region != 0) {
+            fprintf(stderr, "%s is a file, it only has region 0\n", path);
+            close(m->fd);
+            return -1;
+        }
+        size = st.st_size;
+    } else if (uiomap_attr(path, region, "size", &size, NULL, 0) < 0) {
+        fprintf(stderr, "%s has no region %d; try -l\n", path, region);
+        close(m->fd);
+        return -1;
+    } else {
+        uiomap_attr(path, region, "offset", &offset, NULL, 0);
+    }
+
+    /* NOTE: with UIO the offset is not a normal offset; it's a region
+     * selector.
+     */
+    m->map_len = offset + size;
+    m->base = mmap(NULL, m->map_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   m->fd, (off_t)region * page);
+    if (m->base == MAP_FAILED) {
+        perror("mmap");
+        fprintf(stderr, "Couldn't mmap.\n");
+        close(m->fd);
+        return -1;
+    }
+    m->regs = (volatile uint8_t *)m->base + offset;
+    m->size = size;
+    return 0;
+}
+
+void uiomap_close(struct uiomap *m) {
+    munmap(m->base, m->map_len);
+    close(m->fd);
+}
+
+/*
+ * Check that count accesses of width bytes from addr are aligned and within
+ * the region, printing why not if they are not.
+ */
+int uiomap_check(const struct uiomap *m, size_t addr, int width,
+                 size_t count) {
+    if (width != 1 && width != 2 && width != 4 && width != 8) {
+        fprintf(stderr, "Width must be 1, 2, 4 or 8\n");
+        return -1;
+    }
+    if (addr % width) {
+        fprintf(stderr, "0x%zx is not aligned to the width\n", addr);
+        return -1;
+    }
+    if (addr > m->size || count > (m->size - addr) / width) {
+        fprintf(stderr, "0x%zx + %zu words is outside region %d (0x%zx "
+                "bytes)\n", addr, count, m->region, m->size);
+        return -1;
+    }
+    return 0;
+}
+
+/* Read one register of width bytes; check it with uiomap_check first */
+uint64_t uiomap_read(const struct uiomap *m, size_t addr, int width) {
+    volatile uint8_t *p = m->regs + addr;
+
+    switch (width) {
+    case 1:
+        return *p;
+    case 2:
+        return *(volatile uint16_t *)p;
+    case 4:
+        return *(volatile uint32_t *)p;
+    default:
+        return *(volatile uint64_t *)p;
+    }
+}
+
+/* Write one register of width bytes; check it with uiomap_check first */
+void uiomap_write(const struct uiomap *m, size_t addr, int width,
+                  uint64_t value) {
+    volatile uint8_t *p = m->regs + addr;
+
+    switch (width) {
+    case 1:
+        *p = value;
+        break;
+    case 2:
+        *(volatile uint16_t *)p = value;
+        break;
+    case 4:
+        *(volatile uint32_t *)p = value;
+        break;
+    default:
+        *(volatile uint64_t *)p = value;
+        break;
+    }
+}
+
+void uiomap_print(FILE *f, size_t addr, int width, uint64_t value) {
+    fprintf(f, "0x%08zx\t%0*" PRIx64 "\n", addr, width * 2, value);
+}
@@ -0,0 +1,40 @@
+/*
+ * uiomap.h: mapping and accessing UIO device memory regions
+ *
+ * GPLv3 License, see uioctl.c
+ */
+
+#ifndef UIOMAP_H
+#define UIOMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define UIOMAP_MAX_MAPS 5   /* what the UIO core supports */
+
+/* One memory region of a UIO device, mapped */
+struct uiomap {
+    const char *path;
+    int fd;
+    int region;
+    void *base;             /* what mmap returned */
+    size_t map_len;
+    volatile uint8_t *regs; /* the start of the region within the mapping */
+    size_t size;            /* bytes of registers in the region */
+};
+
+int uiomap_list(FILE *f, const char *path);
+int uiomap_open(struct uiomap *m, const char *path, int region);
+void uiomap_close(struct uiomap *m);
+
+int uiomap_check(const struct uiomap *m, size_t addr, int width,
+                 size_t count);
+uint64_t uiomap_read(const struct uiomap *m, size_t addr, int width);
+void uiomap_write(const struct uiomap *m, size_t addr, int width,
+                  uint64_t value);
+void uiomap_print(FILE *f, size_t addr, int width, uint64_t value);
+
+int uiobatch_run(const struct uiomap *m, FILE *in, FILE *out, int width);
+
+#endif /* UIOMAP_H */
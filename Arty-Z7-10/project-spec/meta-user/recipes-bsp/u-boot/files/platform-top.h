@@ -25,7 +25,7 @@
 #define CONFIG_ENV_SIZE	0x20000
 
 #undef CONFIG_PREBOOT
-#define CONFIG_PREBOOT	"echo U-BOOT for Arty Z7; setenv preboot; setenv bootenv uEnv.txt;  setenv loadbootenv_addr 0x1EE00000; if test $modeboot = sdboot && env run sd_uEnvtxt_existence_test; then if env run loadbootenv; then env run importbootenv; fi; fi; dhcp"
+#define CONFIG_PREBOOT	"echo U-BOOT for Arty Z7; setenv preboot; setenv bootenv uEnv.txt;  setenv loadbootenv_addr 0x1EE00000; if test $modeboot = sdboot && env run sd_uEnvtxt_existence_test; then if env run loadbootenv; then env run importbootenv; fi; fi"
 #endif
 
 //#undef CONFIG_BOOTCOMMAND
@@ -0,0 +1,183 @@
+/*
+ * Cacheable access to the reserved region U-Boot loads the game into
+ *
+ * /dev/mem maps memory the kernel does not own uncached on ARM, which makes
+ * reading a game out of the region slow. This driver maps the region named
+ * by its memory-region phandle write-back cacheable and offers it as
+ * /dev/mesh_game, where offset 0 is the start of the region. Its physical
+ * address and size are in /sys/class/misc/mesh_game/{base,size}.
+ *
+ * SPDX-License-Identifier:	GPL-2.0
+ */
+
+#include <linux/device.h>
+#include <linux/fs.h>
+#include <linux/io.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/of_address.h>
+#include <linux/platform_device.h>
+
+struct mesh_game_mem {
+	struct miscdevice misc;
+	phys_addr_t base;
+	size_t size;
+	void *virt;		/* Kernel mapping, for read() and write() */
+};
+
+static struct mesh_game_mem *file_to_mgm(struct file *file)
+{
+	/* misc_open() points private_data at our miscdevice */
+	return container_of(file->private_data, struct mesh_game_mem, misc);
+}
+
+static loff_t mesh_game_llseek(struct file *file, loff_t offset, int whence)
+{
+	return fixed_size_llseek(file, offset, whence, file_to_mgm(file)->size);
+}
+
+static ssize_t mesh_game_read(struct file *file, char __user *buf,
+			      size_t count, loff_t *ppos)
+{
+	struct mesh_game_mem *mgm = file_to_mgm(file);
+
+	return simple_read_from_buffer(buf, count, ppos, mgm->virt, mgm->size);
+}
+
+static ssize_t mesh_game_write(struct file *file, const char __user *buf,
+			       size_t count, loff_t *ppos)
+{
+	struct mesh_game_mem *mgm = file_to_mgm(file);
+
+	return simple_write_to_buffer(mgm->virt, mgm->size, ppos, buf, count);
+}
+
+static int mesh_game_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct mesh_game_mem *mgm = file_to_mgm(file);
+	unsigned long len = vma->vm_end - vma->vm_start;
+	unsigned long pages = mgm->size >> PAGE_SHIFT;
+
+	if (vma->vm_pgoff >= pages ||
+	    len > (pages - vma->vm_pgoff) << PAGE_SHIFT)
+		return -EINVAL;
+
+	/* Unlike /dev/mem, keep the default cacheable vm_page_prot */
+	return remap_pfn_range(vma, vma->vm_start,
+			       PHYS_PFN(mgm->base) + vma->vm_pgoff, len,
+			       vma->vm_page_prot);
+}
+
+static const struct file_operations mesh_game_fops = {
+	.owner		= THIS_MODULE,
+	.llseek		= mesh_game_llseek,
+	.read		= mesh_game_read,
+	.write		= mesh_game_write,
+	.mmap		= mesh_game_mmap,
+};
+
+static struct mesh_game_mem *dev_to_mgm(struct device *dev)
+{
+	struct miscdevice *misc = dev_get_drvdata(dev);
+
+	return container_of(misc, struct mesh_game_mem, misc);
+}
+
+static ssize_t base_show(struct device *dev, struct device_attribute *attr,
+			 char *buf)
+{
+	return sprintf(buf, "%pa\n", &dev_to_mgm(dev)->base);
+}
+static DEVICE_ATTR_RO(base);
+
+static ssize_t size_show(struct device *dev, struct device_attribute *attr,
+			 char *buf)
+{
+	return sprintf(buf, "0x%zx\n", dev_to_mgm(dev)->size);
+}
+static DEVICE_ATTR_RO(size);
+
+static struct attribute *mesh_game_attrs[] = {
+	&dev_attr_base.attr,
+	&dev_attr_size.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(mesh_game);
+
+static int mesh_game_probe(struct platform_device *pdev)
+{
+	struct device *dev = &pdev->dev;
+	struct mesh_game_mem *mgm;
+	struct device_node *np;
+	struct resource res;
+	int ret;
+
+	np = of_parse_phandle(dev->of_node, "memory-region", 0);
+	if (!np) {
+		dev_err(dev, "no memory-region\n");
+		return -ENODEV;
+	}
+	ret = of_address_to_resource(np, 0, &res);
+	of_node_put(np);
+	if (ret)
+		return ret;
+
+	mgm = devm_kzalloc(dev, sizeof(*mgm), GFP_KERNEL);
+	if (!mgm)
+		return -ENOMEM;
+	mgm->base = res.start;
+	mgm->size = resource_size(&res);
+	if (!PAGE_ALIGNED(mgm->base) || !PAGE_ALIGNED(mgm->size)) {
+		dev_err(dev, "region %pR is not page aligned\n", &res);
+		return -EINVAL;
+	}
+
+	mgm->virt = devm_memremap(dev, mgm->base, mgm->size, MEMREMAP_WB);
+	if (IS_ERR(mgm->virt))
+		return PTR_ERR(mgm->virt);
+
+	mgm->misc.minor = MISC_DYNAMIC_MINOR;
+	mgm->misc.name = "mesh_game";
+	mgm->misc.fops = &mesh_game_fops;
+	mgm->misc.parent = dev;
+	mgm->misc.groups = mesh_game_groups;
+	platform_set_drvdata(pdev, mgm);
+
+	ret = misc_register(&mgm->misc);
+	if (ret)
+		return ret;
+
+	dev_info(dev, "game region %pR\n", &res);
+
+	return 0;
+}
+
+static int mesh_game_remove(struct platform_device *pdev)
+{
+	struct mesh_game_mem *mgm = platform_get_drvdata(pdev);
+
+	misc_deregister(&mgm->misc);
+
+	return 0;
+}
+
+static const struct of_device_id mesh_game_of_match[] = {
+	{ .compatible = "mitre,mesh-game-mem" },
+	{ }
+};
+MODULE_DEVICE_TABLE(of, mesh_game_of_match);
+
+static struct platform_driver mesh_game_driver = {
+	.probe	= mesh_game_probe,
+	.remove	= mesh_game_remove,
+	.driver	= {
+		.name		= "mesh-game-mem",
+		.of_match_table	= mesh_game_of_match,
+	},
+};
+module_platform_driver(mesh_game_driver);
+
+MODULE_DESCRIPTION("Cacheable access to the reserved game region");
+MODULE_LICENSE("GPL v2");
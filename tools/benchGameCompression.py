@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+
+import argparse
+import gzip
+import re
+import time
+
+import bootstageReport
+import provisionGames
+
+# how long to keep decompressing each game for, to get a stable time
+bench_seconds = 0.5
+
+
+def decompress_payload(data, codec):
+    """Decompress a payload compressed by provisionGames.compress_payload.
+
+    data: compressed bytes
+    codec: the codec it was compressed with
+    """
+    if codec == "gzip":
+        return gzip.decompress(data)
+
+    import lz4.frame
+    return lz4.frame.decompress(data)
+
+
+def time_decompress(data, codec):
+    """Return how many seconds one decompression of data takes on this host.
+
+    data: compressed bytes
+    codec: the codec it was compressed with
+    """
+    runs = 0
+    start = time.perf_counter()
+    while True:
+        decompress_payload(data, codec)
+        runs += 1
+        elapsed = time.perf_counter() - start
+        if elapsed >= bench_seconds:
+            return elapsed / runs
+
+
+def bench_game(path, codecs):
+    """Compress one game binary with each codec and return a list of
+    (codec, stored bytes, host decompress MB/s) with None for "none".
+
+    path: path to the game binary
+    codecs: codecs to try
+    """
+    with open(path, "rb") as f:
+        raw = f.read()
+
+    results = [("none", len(raw), None)]
+    for codec in codecs:
+        if codec == "none":
+            continue
+        try:
+            packed = provisionGames.compress_payload(raw, codec)
+            secs = time_decompress(packed, codec)
+        except (ImportError, OSError) as e:
+            print("    %s not available: %s" % (codec, e))
+            continue
+        if decompress_payload(packed, codec) != raw:
+            raise ValueError("%s does not round trip %s" % (codec, path))
+        results.append((codec, len(packed), len(raw) / secs / 1e6))
+
+    return results
+
+
+def print_boot_times(stashes):
+    """Print the game load times measured on the board, one boot per codec.
+    mesh_game_load is the time U-Boot took to read (and with
+    CONFIG_MESH_GAME_DECOMPRESS, decompress) the game; the loader time is
+    from loader_start to game_exec in Linux.
+
+    stashes: list of (codec, path to a bootstage stash from that boot)
+    """
+    print("")
+    print("%-8s%16s%16s%16s" % ("Codec", "U-Boot load us", "Loader us",
+                                "Total us"))
+    for codec, path in stashes:
+        records = bootstage_records(path)
+        load = sum(r["time_us"] for r in records
+                   if r["accum"] and r["name"] == "mesh_game_load")
+        marks = {r["name"]: r["time_us"] for r in records if not r["accum"]}
+        loader = marks.get("game_exec", 0) - marks.get("loader_start", 0)
+        print("%-8s%16s%16s%16s" % (codec, "{:,}".format(load),
+                                    "{:,}".format(loader),
+                                    "{:,}".format(load + loader)))
+
+
+def bootstage_records(path):
+    """Read a bootstage stash, exiting with a message if it is unusable.
+
+    path: path to the stash
+    """
+    try:
+        return bootstageReport.read_stash(path)
+    except (IOError, ValueError) as e:
+        print("Error, could not read bootstage stash: %s" % (e))
+        exit(2)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('games',
+                        help=("A text file containing game information in "
+                              "the format provisionGames.py takes."))
+    parser.add_argument('--stash', action='append', default=[],
+                        metavar='CODEC=PATH',
+                        help=("A bootstage stash from playing a game "
+                              "provisioned with CODEC, as saved by "
+                              "mesh-game-loader. Give one per codec to "
+                              "compare the load times measured on the "
+                              "board."))
+    args = parser.parse_args()
+
+    try:
+        f_games = open(args.games, "r")
+    except Exception as e:
+        print("Couldn't open file %s" % (args.games))
+        exit(2)
+
+    # each binary once, games.txt lists every version of a game
+    paths = []
+    for line in f_games:
+        m = re.match(r'^\s*(\S+)\s', line)
+        if m and m.group(1) not in paths:
+            paths.append(m.group(1))
+    f_games.close()
+
+    print("%-24s%-8s%12s%8s%16s" % ("Game", "Codec", "Bytes", "Ratio",
+                                    "Host MB/s"))
+    for path in paths:
+        results = bench_game(path, provisionGames.codecs)
+        raw = results[0][1]
+        for codec, size, mbps in results:
+            print("%-24s%-8s%12s%8.2f%16s" % (
+                path[-24:], codec, "{:,}".format(size), raw / size,
+                "-" if mbps is None else "%.1f" % (mbps)))
+
+    stashes = []
+    for stash in args.stash:
+        codec, _, path = stash.partition("=")
+        if codec not in provisionGames.codecs or not path:
+            print("Error, --stash takes CODEC=PATH, got %s" % (stash))
+            exit(2)
+        stashes.append((codec, path))
+    if stashes:
+        print_boot_times(stashes)
+
+    exit(0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+
+import argparse
+import json
+import struct
+
+# These match common/bootstage.c in U-Boot (32-bit ARM layout)
+BOOTSTAGE_VERSION = 0
+BOOTSTAGE_MAGIC = 0xb00757a3
+HDR_FMT = "<IIII"
+REC_FMT = "<IIIiI"
+
+
+def read_stash(path):
+    """Parse a bootstage stash and return a list of records, in stash order.
+    Each record is a dict with the stage name, its time in microseconds and
+    whether it is an accumulated time rather than a mark.
+
+    path: path to a stash, either /tmp/bootstage.bin saved by
+          mesh-game-loader or a raw dump of CONFIG_BOOTSTAGE_STASH_ADDR
+    """
+    with open(path, "rb") as f:
+        data = f.read()
+
+    hdr_size = struct.calcsize(HDR_FMT)
+    rec_size = struct.calcsize(REC_FMT)
+    if len(data) < hdr_size:
+        raise ValueError("%s is too short for a bootstage stash" % (path))
+
+    version, count, size, magic = struct.unpack_from(HDR_FMT, data)
+    if magic != BOOTSTAGE_MAGIC:
+        raise ValueError("%s has no bootstage magic" % (path))
+    if version != BOOTSTAGE_VERSION:
+        raise ValueError("%s has bootstage version %d" % (path, version))
+    if size > len(data) or hdr_size + count * rec_size > size:
+        raise ValueError("%s is truncated" % (path))
+
+    records = []
+    names = data[hdr_size + count * rec_size:size].split(b"\0")
+    for i in range(count):
+        time_us, start_us, _, flags, rec_id = struct.unpack_from(
+            REC_FMT, data, hdr_size + i * rec_size)
+        records.append({"name": names[i].decode("utf-8", "replace"),
+                        "id": rec_id,
+                        "time_us": time_us,
+                        "accum": start_us != 0,
+                        "error": bool(flags & 1)})
+
+    return records
+
+
+def stage_times(records):
+    """Turn records into a dict of stage name -> microseconds, where a mark
+    is the time since the previous mark and an accumulated record is its
+    total. This is what is compared against a baseline.
+
+    records: list of records from read_stash
+    """
+    stages = {}
+    prev = 0
+    for rec in sorted((r for r in records if not r["accum"]),
+                      key=lambda r: r["time_us"]):
+        stages[rec["name"]] = rec["time_us"] - prev
+        prev = rec["time_us"]
+    for rec in records:
+        if rec["accum"]:
+            stages[rec["name"]] = rec["time_us"]
+
+    return stages
+
+
+def print_report(records):
+    """Print the combined timeline in the same layout as U-Boot's
+    'bootstage report'.
+
+    records: list of records from read_stash
+    """
+    print("Timer summary in microseconds:")
+    print("%12s%12s  %s" % ("Mark", "Elapsed", "Stage"))
+    print("%12s%12s  %s" % ("{:,}".format(0), "{:,}".format(0), "reset"))
+    prev = 0
+    for rec in sorted((r for r in records if not r["accum"]),
+                      key=lambda r: r["time_us"]):
+        print("%12s%12s  %s%s" % ("{:,}".format(rec["time_us"]),
+                                  "{:,}".format(rec["time_us"] - prev),
+                                  rec["name"],
+                                  " (error)" if rec["error"] else ""))
+        prev = rec["time_us"]
+
+    print("")
+    print("Accumulated time:")
+    for rec in records:
+        if rec["accum"]:
+            print("%12s%12s  %s" % ("", "{:,}".format(rec["time_us"]),
+                                    rec["name"]))
+
+
+def compare(stages, baseline, tolerance, slack_us):
+    """Compare stage times against a baseline and return a list of
+    (stage, baseline_us, now_us) for every stage that got slower than the
+    tolerance allows.
+
+    stages: dict from stage_times for this boot
+    baseline: dict from stage_times for the reference boot
+    tolerance: allowed slowdown as a fraction, ie 0.1 for 10%
+    slack_us: absolute slowdown always allowed, so tiny stages do not flap
+    """
+    regressions = []
+    for name, base_us in sorted(baseline.items()):
+        if name not in stages:
+            continue
+        if stages[name] > base_us * (1 + tolerance) + slack_us:
+            regressions.append((name, base_us, stages[name]))
+
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('stash',
+                        help=("A bootstage stash copied from the board, ie "
+                              "/tmp/bootstage.bin written by "
+                              "mesh-game-loader."))
+    parser.add_argument('--json',
+                        help=("Write per-stage times to this file, for use "
+                              "as a later --baseline."))
+    parser.add_argument('--baseline',
+                        help=("Per-stage times from a reference boot. The "
+                              "script fails if any stage got slower."))
+    parser.add_argument('--tolerance', type=float, default=10.0,
+                        help=("Allowed slowdown per stage in percent "
+                              "(default: 10)."))
+    parser.add_argument('--slack', type=int, default=1000,
+                        help=("Allowed slowdown per stage in microseconds, "
+                              "on top of --tolerance (default: 1000)."))
+    args = parser.parse_args()
+
+    try:
+        records = read_stash(args.stash)
+    except (IOError, ValueError) as e:
+        print("Error, could not read bootstage stash: %s" % (e))
+        exit(2)
+
+    print_report(records)
+    stages = stage_times(records)
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(stages, f, indent=4, sort_keys=True)
+
+    if args.baseline:
+        with open(args.baseline, "r") as f:
+            baseline = json.load(f)
+        regressions = compare(stages, baseline, args.tolerance / 100.0,
+                              args.slack)
+        if regressions:
+            print("")
+            print("Stages slower than baseline:")
+            for (name, base_us, now_us) in regressions:
+                print("    %s: %d -> %d us" % (name, base_us, now_us))
+            exit(1)
+
+    exit(0)
+
+
+if __name__ == '__main__':
+    main()
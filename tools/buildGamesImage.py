@@ -0,0 +1,320 @@
+#!/usr/bin/env python3
+
+import argparse
+import os
+import shutil
+import subprocess
+import tempfile
+
+# ext4 block size of the games partition
+BLOCK_SIZE = 4096
+
+# blocks in an ext4 block group with BLOCK_SIZE blocks
+BLOCKS_PER_GROUP = 8 * BLOCK_SIZE
+
+# an extent covers at most this many blocks
+MAX_EXTENT_BLOCKS = 32768
+
+# free space left on an image sized to fit its games, on top of the room
+# mke2fs needs for its own metadata
+SLACK_BYTES = 16 * 1024 * 1024
+
+
+def game_files(games):
+    """
+    This function returns the names of the games to put on the games
+    partition, in the order they go on it. That is byte order, which is the
+    order mke2fs -d adds them to the root directory in, so it is also the
+    order the mesh query command lists them in and reads their headers.
+
+    games: the path to the directory that contains the provisioned games.
+            Every regular file in the root of it is a game.
+    """
+
+    return sorted(f for f in os.listdir(games)
+                  if os.path.isfile(os.path.join(games, f)))
+
+
+def image_size(games, names):
+    """
+    This function returns the smallest image size, in bytes, that holds the
+    games with SLACK_BYTES to spare, rounded up to a MiB.
+
+    games: the path to the directory that contains the games.
+    names: the names of the games in that directory.
+    """
+
+    blocks = 0
+    for name in names:
+        size = os.path.getsize(os.path.join(games, name))
+        blocks += (size + BLOCK_SIZE - 1) // BLOCK_SIZE
+
+    # mke2fs -T default puts a 256 byte inode in the inode tables for every
+    # 16KiB, which is most of its metadata
+    size = blocks * BLOCK_SIZE * 65 // 64 + SLACK_BYTES
+    return (size + 0xfffff) & ~0xfffff
+
+
+def build_image(games, image, size=None, dir_index=False):
+    """
+    This function builds a complete games partition image from a directory
+    of provisioned games, without mounting anything, and checks its layout.
+
+    The filesystem is made so that every game is a single extent and the
+    games are laid out back to back in the order U-Boot's mesh commands
+    scan them:
+      - there is no journal, nor any backup superblocks, in the middle of
+        the data (the partition is only ever rewritten whole, from here)
+      - the metadata of every block group is packed at the start (one
+        flex group)
+      - the root directory is not indexed unless dir_index is set, so it
+        stays in byte order. U-Boot's ext4 reader scans directories
+        linearly either way, indexing only helps Linux.
+
+    games: the path to the directory that contains the games.
+    image: the path to write the image to. It is overwritten.
+    size: the size of the image in bytes, by default just enough for the
+            games.
+    dir_index: whether to index the root directory.
+    """
+
+    names = game_files(games)
+    if size is None:
+        size = image_size(games, names)
+    groups = (size // BLOCK_SIZE + BLOCKS_PER_GROUP - 1) // BLOCKS_PER_GROUP
+    flex_bg = 1
+    while flex_bg < groups:
+        flex_bg *= 2
+
+    # stage hard links to only the regular files, falling back to copies
+    # when the image is on another filesystem
+    stage = tempfile.mkdtemp(prefix="games-")
+    try:
+        for name in names:
+            src = os.path.join(os.path.abspath(games), name)
+            try:
+                os.link(src, os.path.join(stage, name))
+            except OSError:
+                shutil.copy(src, os.path.join(stage, name))
+
+        if os.path.exists(image):
+            os.remove(image)
+        with open(image, "wb") as f:
+            f.truncate(size)
+        subprocess.check_call(
+            "mke2fs -q -F -t ext4 -T default -L games -b %d -G %d -m 0 "
+            "-O ^has_journal,sparse_super2,%sdir_index "
+            "-E num_backup_sb=0,root_owner=0:0 -d %s %s"
+            % (BLOCK_SIZE, flex_bg, "" if dir_index else "^", stage, image),
+            shell=True)
+    finally:
+        shutil.rmtree(stage)
+
+    # e2fsck returns 1 when it has changed the filesystem
+    if dir_index and subprocess.call("e2fsck -fyD %s > /dev/null 2>&1"
+                                     % (image), shell=True) > 1:
+        raise IOError("Could not index the games directory of %s" % (image))
+    subprocess.check_call("e2fsck -fn %s > /dev/null 2>&1" % (image),
+                          shell=True)
+
+    check_layout(image, names, sorted_dir=not dir_index)
+
+    return names
+
+
+def sudo_for(target):
+    """
+    This function returns "sudo " if target cannot be read and written as it
+    is, like a device, and "" otherwise. A target that does not exist yet
+    only needs its directory to be writable.
+
+    target: the path to a device or file.
+    """
+
+    if not os.path.exists(target):
+        parent = os.path.dirname(os.path.abspath(target))
+        return "" if os.access(parent, os.W_OK | os.X_OK) else "sudo "
+    return "" if os.access(target, os.R_OK | os.W_OK) else "sudo "
+
+
+def debugfs(image, commands, write=False):
+    """
+    This function runs debugfs commands on an image and returns the output
+    of each one.
+
+    image: the path to the image, or to a device with one on it.
+    commands: a list of debugfs commands.
+    write: whether to open the image read-write.
+    """
+
+    with tempfile.NamedTemporaryFile("w") as f:
+        f.write("\n".join(commands) + "\n")
+        f.flush()
+        out = subprocess.check_output("%sdebugfs %s-f %s %s 2> /dev/null"
+                                      % (sudo_for(image),
+                                         "-w " if write else "", f.name,
+                                         image), shell=True)
+
+    # debugfs echoes each command on a line of its own before its output
+    outputs = out.decode().split("debugfs: ")[1:]
+    return [o.split("\n", 1)[1] if "\n" in o else "" for o in outputs]
+
+
+def check_layout(image, names, sorted_dir=True):
+    """
+    This function checks that each game in an image is one extent, that the
+    games follow each other on disk in order and, for an unindexed root
+    directory, that its entries are in that order too.
+
+    image: the path to the image.
+    names: the games, in order.
+    sorted_dir: whether to check the order of the directory entries.
+    """
+
+    outputs = debugfs(image, ["ls -p /"] + ["ex /%s" % (n) for n in names])
+
+    # ls -p prints /inode/mode/uid/gid/name/size/
+    entries = [l.split("/")[5] for l in outputs[0].splitlines()
+               if l.count("/") >= 7]
+    entries = [e for e in entries if e not in (".", "..", "lost+found")]
+    if sorted(entries) != names:
+        raise IOError("%s does not hold exactly the games" % (image))
+    if sorted_dir and entries != names:
+        raise IOError("The games directory of %s is not in order" % (image))
+
+    last = 0
+    for name, out in zip(names, outputs[1:]):
+        # "Level Entries Logical Physical Length Flags" then a line per
+        # extent, ie " 0/ 0   1/  1     0 -    45   898 -   943     46"
+        extents = [l.split() for l in out.splitlines()[1:] if l.strip()]
+        if not extents:
+            # an empty game has no blocks
+            continue
+        if len(extents) != 1 or int(extents[0][10]) > MAX_EXTENT_BLOCKS:
+            raise IOError("%s is not a single extent in %s" % (name, image))
+        start = int(extents[0][7])
+        if start < last:
+            raise IOError("%s is out of order in %s" % (name, image))
+        last = start
+
+
+def write_image(image, target, offset=0):
+    """
+    This function writes an image to a device or file in one sequential
+    write, then reads it back to verify it. sudo is only used when the
+    target is not accessible as it is.
+
+    image: the path to the image.
+    target: the path to the device or file to write it to, ie /dev/sdb2.
+    offset: where in target to write the image, in bytes.
+    """
+
+    size = os.path.getsize(image)
+    sudo = sudo_for(target)
+
+    subprocess.check_call(
+        "%sdd if=%s of=%s bs=4M seek=%d oflag=seek_bytes conv=notrunc,fsync "
+        "status=none" % (sudo, image, target, offset), shell=True)
+
+    # read back from the device rather than from the page cache
+    if not os.path.isfile(target):
+        subprocess.check_call("%sblockdev --flushbufs %s" % (sudo, target),
+                              shell=True)
+    if subprocess.call("%scmp -s -n %d -i 0:%d %s %s"
+                       % (sudo, size, offset, image, target), shell=True):
+        raise IOError("Verifying %s on %s failed" % (image, target))
+
+
+def update_files(target, games, copy, remove):
+    """
+    This function changes the games on an existing games partition in
+    place, without mounting it: it deletes the games in remove and copies
+    the games in copy over, then reads those back to verify them.
+
+    Only the games that changed are written, but new games go wherever
+    there is room, so the layout build_image makes is not kept up.
+
+    target: the path to the games partition, ie /dev/sdb2, or an image.
+    games: the path to the directory that contains the games.
+    copy: the names of the games to copy, new or changed.
+    remove: the names of the games to delete.
+    """
+
+    present = debugfs(target, ["ls -p /"])[0]
+    present = [l.split("/")[5] for l in present.splitlines()
+               if l.count("/") >= 7]
+
+    commands = []
+    for name in list(remove) + list(copy):
+        if name in present:
+            commands.append("rm /%s" % (name))
+    for name in copy:
+        commands.append('write "%s" %s'
+                        % (os.path.abspath(os.path.join(games, name)), name))
+    if commands:
+        debugfs(target, commands, write=True)
+
+    sudo = sudo_for(target)
+    if subprocess.call("%se2fsck -fn %s > /dev/null 2>&1" % (sudo, target),
+                       shell=True):
+        raise IOError("%s does not check out after the update" % (target))
+    for name in copy:
+        with open(os.path.join(games, name), "rb") as f:
+            want = f.read()
+        got = subprocess.check_output('%sdebugfs -R "cat /%s" %s 2> /dev/null'
+                                      % (sudo, name, target), shell=True)
+        if got != want:
+            raise IOError("Verifying %s on %s failed" % (name, target))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('games',
+                        help=("This is the directory where provisioned games "
+                              "are stored. Every regular file in it goes on "
+                              "the image."))
+    parser.add_argument('image',
+                        help=("This is the path to write the games partition "
+                              "image to."))
+    parser.add_argument('--size',
+                        type=lambda s: int(s, 0),
+                        help=("The size of the image in bytes. By default it "
+                              "is just big enough for the games."))
+    parser.add_argument('--dir-index',
+                        action="store_true",
+                        help=("Index the games directory. This speeds up "
+                              "lookups in Linux, but the mesh query command "
+                              "then lists games in hash order."))
+    parser.add_argument('--write',
+                        metavar='TARGET',
+                        help=("A device or file to write the image to once "
+                              "it is built, ie /dev/sdb2, and verify it."))
+    parser.add_argument('--offset',
+                        type=lambda s: int(s, 0),
+                        default=0,
+                        help=("Where in TARGET to write the image, in bytes. "
+                              "Use this to write to the games partition of "
+                              "a whole card image."))
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.games):
+        print("Error, games directory doesn't exist: %s" % (args.games))
+        exit(2)
+
+    try:
+        names = build_image(args.games, args.image, args.size, args.dir_index)
+        print("Built %s with %d games, %d bytes"
+              % (args.image, len(names), os.path.getsize(args.image)))
+        if args.write:
+            write_image(args.image, args.write, args.offset)
+            print("Wrote and verified %s at offset %d"
+                  % (args.write, args.offset))
+    except (IOError, subprocess.CalledProcessError) as e:
+        print(e)
+        exit(1)
+
+    exit(0)
+
+
+if __name__ == '__main__':
+    main()
@@ -1,12 +1,16 @@
 #!/usr/bin/env python3
 
 import os
+import shutil
 import subprocess
 import argparse
+import tempfile
+
+import buildGamesImage
+import provisionGames
 
 # the directory to mount the sd card to
 BOOT_MNT = '/mnt/zynq/boot/'
-GAMES_MNT = '/mnt/zynq/games'
 
 # the names to copy the boot and mes files to on the sd card
 BOOT_FILE = 'BOOT.bin'
@@ -42,48 +46,120 @@ def setup_sdcard(device):
     # format sd card and create filesystems
     subprocess.check_call("sudo sfdisk --force %s < ectf_sd.sfdisk > /dev/null" % (device), shell=True)
     subprocess.check_call("sudo mkfs.fat -F 32 -n BOOT -I %s1 > /dev/null" % (device), shell=True)
-    subprocess.check_call("sudo mkfs.ext4 -L games %s2 > /dev/null" % (device), shell=True)
+    # the games filesystem comes whole from copy_games
 
     print("Done Formatting SD Card")
     print("    BOOT : %s1" % (device))
     print("    games : %s2 " % (device))
 
 
-def copy_games(device, games):
+def copy_games(device, games, dir_index=False):
     """
     This function copies all the games from the specified games directory
     to the device specified. The device is the overall device and it copy the
     games to the second partition (the games partition).
 
+    The games partition is built as an image first, see buildGamesImage.py,
+    and then written to the partition in one go and read back to verify it.
+    This replaces whatever was on the partition.
+
     device: the path to the device to copy the games to, ie /dev/sdb.
     games: the path to the directory that contains the games to copy to the
             sd card. This script will copy ALL regular files in the root of
             the specified directory, so make sure it is a clean directory.
+    dir_index: whether to index the games directory on the sd card.
     """
 
     print("Copying Games...")
-    # mount sd card
-    subprocess.check_call("sudo mkdir -p %s" % (GAMES_MNT), shell=True)
-    subprocess.check_call("sudo mount %s2 %s" % (device, GAMES_MNT), shell=True)
-
-    # copy each game specified in games file
-    src_files = os.listdir(games)
-    for file_name in src_files:
-        full_path = os.path.join(games, file_name)
-        try:
-            print("    %s-> %s2/" % (full_path, device))
-            copy_file(full_path, GAMES_MNT)
-        except IOError as e:
-            print(e)
-            subprocess.check_call("sudo umount %s" % (GAMES_MNT), shell=True)
-            exit(1)
-
-    # cleanup
-    subprocess.check_call("sudo umount %s" % (GAMES_MNT), shell=True)
+    work = tempfile.mkdtemp(prefix="deploy-")
+    image = os.path.join(work, "games.img")
+    try:
+        names = buildGamesImage.build_image(games, image,
+                                            dir_index=dir_index)
+        for file_name in names:
+            print("    %s-> %s2/" % (os.path.join(games, file_name), device))
+        print("    %s (%d bytes)-> %s2" % (image, os.path.getsize(image),
+                                           device))
+        buildGamesImage.write_image(image, device + "2")
+        save_deployed(games)
+    except (IOError, subprocess.CalledProcessError) as e:
+        print(e)
+        exit(1)
+    finally:
+        shutil.rmtree(work)
 
     print("Done Copying games to SD Card")
 
 
+def manifest_paths(games):
+    """
+    This function returns the paths to the manifest provisionGames.py keeps
+    next to the games directory, and to the copy of it saved by the last
+    deploy.
+
+    games: the path to the directory that contains the games.
+    """
+
+    games = os.path.normpath(games)
+    return games + ".manifest.json", games + ".deployed.json"
+
+
+def save_deployed(games):
+    """
+    This function records which games are now on the sd card, by saving a
+    copy of the manifest of the games directory, if there is one.
+
+    games: the path to the directory that contains the games.
+    """
+
+    manifest, deployed = manifest_paths(games)
+    if os.path.isfile(manifest):
+        shutil.copy(manifest, deployed)
+
+
+def update_games(device, games):
+    """
+    This function copies only the games that changed since the last deploy
+    to the device specified, and deletes the ones that are gone, comparing
+    the manifest provisionGames.py wrote with the one saved by the last
+    deploy. The device is the overall device and it updates the second
+    partition (the games partition) in place.
+
+    This assumes the sd card is the one the last deploy from this games
+    directory went to. Without a manifest from both, it copies all the
+    games with copy_games.
+
+    device: the path to the device to copy the games to, ie /dev/sdb.
+    games: the path to the directory that contains the games.
+    """
+
+    manifest, deployed = manifest_paths(games)
+    new = provisionGames.read_manifest(manifest)
+    old = provisionGames.read_manifest(deployed)
+    if not new or not old:
+        print("No record of the last deploy, copying all games")
+        copy_games(device, games)
+        return
+
+    print("Updating Games...")
+    copy = [n for n in sorted(new)
+            if old.get(n, {}).get("sha256") != new[n].get("sha256")]
+    remove = [n for n in sorted(old) if n not in new]
+    for file_name in copy:
+        print("    %s-> %s2/" % (os.path.join(games, file_name), device))
+    for file_name in remove:
+        print("    removed %s2/%s" % (device, file_name))
+    try:
+        buildGamesImage.update_files(device + "2", games, copy, remove)
+        save_deployed(games)
+    except (IOError, subprocess.CalledProcessError) as e:
+        print(e)
+        exit(1)
+
+    print("Done Updating games on SD Card (%d copied, %d removed, %d "
+          "unchanged)" % (len(copy), len(remove), len(new) - len(copy)))
+
+
 def copy_boot(device, boot_path, mes_path=None):
     """
     This function copies the boot file from the specified file paths
@@ -147,6 +223,23 @@ def main():
                               "be formatted. Caution, if the sd card is "
                               "not already formatted correctly, this "
                               "script will fail."))
+    parser.add_argument('--dir-index',
+                        action="store_true",
+                        help=("This is an optional argument. "
+                              "If it is specified, the games directory is "
+                              "indexed. This speeds up lookups in Linux, but "
+                              "the mesh query command then lists games in "
+                              "hash order instead of by name."))
+    parser.add_argument('--update',
+                        action="store_true",
+                        help=("This is an optional argument. "
+                              "If it is specified, the SD card is not "
+                              "formatted and only the games that changed "
+                              "since the last deploy to it are copied, "
+                              "using the manifest written by "
+                              "provisionGames.py. Games added this way are "
+                              "not laid out for fast loading, deploy "
+                              "without it for the final card."))
     args = parser.parse_args()
 
     # verify boot bin
@@ -169,11 +262,14 @@ def main():
     subprocess.call("sudo umount %s* &> /dev/null" % (args.device), shell=True)
 
     # build images and provision sd card
-    if not args.noformat:
+    if not args.noformat and not args.update:
         setup_sdcard(args.device)
 
     copy_boot(args.device, boot_file, mes_path=args.mes_path)
-    copy_games(args.device, args.games)
+    if args.update:
+        update_games(args.device, args.games)
+    else:
+        copy_games(args.device, args.games, dir_index=args.dir_index)
 
     exit(0)
 
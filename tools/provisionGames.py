@@ -2,18 +2,52 @@
 
 import os
 import argparse
+import gzip
+import hashlib
+import json
+import multiprocessing
 import re
 import subprocess
 
 # Path to the generated games folder
 gen_path = "files/generated/games"
 
+# Path to the manifest of the generated games, see write_manifest
+manifest_path = gen_path + ".manifest.json"
 
-def provision_game(line):
-    """Given a line from games.txt, provision a game and write to the
-    appropriate directory
+# Part of every game's key. Bump it whenever the format of the generated
+# games changes, so that they are all provisioned again.
+game_format = 1
 
-    line: string from games.txt to create a game for
+# Codecs a game payload can be compressed with. U-Boot's mesh_play and
+# mesh-game-loader both understand these.
+codecs = ["none", "gzip", "lz4"]
+
+
+def compress_payload(data, codec):
+    """Compress a game binary with codec and return the compressed bytes.
+
+    data: bytes of the game binary
+    codec: one of codecs, other than "none"
+    """
+    if codec == "gzip":
+        return gzip.compress(data, compresslevel=9)
+
+    # U-Boot's LZ4 decoder only handles frames with independent blocks
+    try:
+        import lz4.frame
+        return lz4.frame.compress(data, block_linked=False,
+                                  compression_level=9, store_size=True)
+    except ImportError:
+        return subprocess.run(["lz4", "-9", "-c"], input=data,
+                              stdout=subprocess.PIPE, check=True).stdout
+
+
+def parse_game(line):
+    """Parse a line from games.txt and return (path to the game binary, game
+    name, version, list of users), or None if the line is not a game.
+
+    line: string from games.txt
     """
     # Regular expression to parse out the necessary parts of the line in the
     # games.txt file. The regular expression works as follows:
@@ -26,60 +60,143 @@ def provision_game(line):
     reg = r'^\s*([\w\/\-.\_]+)\s+([\w\-.\_]+)\s+(\d+\.\d+|\d+)((?:\s+\w+)+)'
     m = re.match(reg, line)
     if not m:
-        return
-
-    # Path to the game
-    g_path = m.group(1)
-    # Name of the game
-    name = m.group(2)
-    # Game version
-    version = m.group(3)
-    # List of users (strings) that are allowed to play this game
-    users = m.group(4).split()
-
-    # Open the path to the games in binary mode
+        return None
+
+    # Path to the game, name of the game, game version and the list of users
+    # (strings) that are allowed to play this game
+    return (m.group(1), m.group(2), m.group(3), m.group(4).split())
+
+
+def game_key(game, codec):
+    """Return a hash of everything a generated game is made from: the game
+    binary, its name, version and users, and how it is stored.
+
+    game: tuple returned by parse_game
+    codec: how the game binary is compressed, one of codecs
+    """
+    g_path, name, version, users = game
+    h = hashlib.sha256()
+    h.update(bytes("%d\n%s\n%s\n%s\n%s\n" % (game_format, name, version,
+                                              " ".join(users), codec),
+                   "utf-8"))
+    with open(g_path, "rb") as f:
+        for chunk in iter(lambda: f.read(1 << 20), b""):
+            h.update(chunk)
+    return h.hexdigest()
+
+
+def provision_game(game, codec="none"):
+    """Provision a game and write it to the appropriate directory. Returns
+    the name of the generated game and its sha256, and raises IOError if the
+    game cannot be read or written.
+
+    game: tuple returned by parse_game
+    codec: how to compress the game binary, one of codecs
+    """
+    g_path, name, version, users = game
+
+    # Read in the binary source
     try:
-        f = open(g_path, "rb")
+        with open(g_path, "rb") as f:
+            g_src = f.read()
     except Exception as e:
-        print("Error, could not open game: %s" % (e))
-        exit(1)
+        raise IOError("Error, could not open game: %s" % (e))
 
     # The output of the game into the file should be:
     # gamename-vmajor.minor
     f_out_name = name + "-v" + version
-    # Open the output file in binary mode
-    try:
-        f_out = open(os.path.join(gen_path, f_out_name), "wb")
-    except Exception as e:
-        print("Error, could not open game output file: %s" % (e))
-        f.close()
-        exit(1)
 
     # Write the game header to the top of the file
     # The game header takes the form of the version, name, and user information
     # one separate lines, prefaced with the information for what the data is
     # (version, name, users), separated by a colon. User information is space
-    # separated
+    # separated. A compressed game has a fourth line with the codec and the
+    # size of the game binary once decompressed.
     # For example:
     # version:1.0
     # name:2048
     # users:drew ben lou hunter
-    f_out.write(bytes("version:%s\n" % (version), "utf-8"))
-    f_out.write(bytes("name:%s\n" % (name), "utf-8"))
-    f_out.write(bytes("users:%s\n" % (" ".join(users)), "utf-8"))
+    # compression:lz4 1234567
+    header = "version:%s\n" % (version)
+    header += "name:%s\n" % (name)
+    header += "users:%s\n" % (" ".join(users))
 
-    # Read in the binary source
-    g_src = f.read()
-    # Write the binary source
-    while g_src:
-        f_out.write(g_src)
-        g_src = f.read()
+    # Write the binary source, compressed if asked to
+    if codec != "none":
+        header += "compression:%s %d\n" % (codec, len(g_src))
+        g_src = compress_payload(g_src, codec)
+    data = bytes(header, "utf-8") + g_src
 
-    # Close the files
-    f_out.close()
-    f.close()
+    # Write to a temporary file and rename it into place, so that an
+    # interrupted run never leaves a partial game behind
+    out_path = os.path.join(gen_path, f_out_name)
+    try:
+        with open(out_path + ".tmp", "wb") as f_out:
+            f_out.write(data)
+        os.replace(out_path + ".tmp", out_path)
+    except Exception as e:
+        raise IOError("Error, could not write game output file: %s" % (e))
 
-    print("    %s -> %s" % (g_path, os.path.join(gen_path, f_out_name)))
+    return f_out_name, hashlib.sha256(data).hexdigest()
+
+
+def provision_job(job):
+    """Provision one game in a worker process. Returns (game, generated game
+    name, its sha256, error message or None).
+
+    job: tuple of (game tuple returned by parse_game, codec)
+    """
+    game, codec = job
+    try:
+        return (game,) + provision_game(game, codec) + (None,)
+    except IOError as e:
+        return game, None, None, str(e)
+
+
+def read_manifest(path):
+    """Read a manifest written by write_manifest and return its games, or an
+    empty dict if there is none.
+
+    path: path to the manifest
+    """
+    try:
+        with open(path, "r") as f:
+            return json.load(f)["games"]
+    except (IOError, ValueError, KeyError):
+        return {}
+
+
+def write_manifest(path, games, changed, removed):
+    """Write the manifest of the generated games. It maps each generated
+    game to the key it was made from and its sha256, and lists what this run
+    changed. deploySystem.py --update uses the hashes to copy only the games
+    that differ from the last deploy.
+
+    path: path to write the manifest to
+    games: dict of generated game name to {"source", "key", "sha256"}
+    changed: names of the games written by this run
+    removed: names of the games deleted by this run
+    """
+    with open(path + ".tmp", "w") as f:
+        json.dump({"format": game_format, "games": games,
+                   "changed": sorted(changed), "removed": sorted(removed)},
+                  f, indent=1, sort_keys=True)
+    os.replace(path + ".tmp", path)
+
+
+def job_count(value):
+    """
+    This function parses --jobs: how many games to provision at once, with
+    0 meaning one per CPU.
+    """
+
+    try:
+        jobs = int(value)
+    except ValueError:
+        raise argparse.ArgumentTypeError("invalid int value: %r" % value)
+    if jobs < 0:
+        raise argparse.ArgumentTypeError("must be 0 or more, not %d" % jobs)
+    return jobs or os.cpu_count()
 
 
 def main():
@@ -91,6 +208,15 @@ def main():
     parser.add_argument('games',
                         help=("A text file containing game information in a "
                               "MITRE defined format."))
+    parser.add_argument('--compress', choices=codecs, default="none",
+                        help=("Compress each game binary with this codec "
+                              "(default: none)."))
+    parser.add_argument('--jobs', type=job_count, default=0,
+                        help=("How many games to provision at once, 0 for "
+                              "one per CPU (default: 0)."))
+    parser.add_argument('--force', action="store_true",
+                        help=("Provision every game again, even those that "
+                              "have not changed since the last run."))
     args = parser.parse_args()
 
     # open factory secrets
@@ -112,11 +238,60 @@ def main():
 
     print("Provision Games...")
 
-    # Provision each line in the games file
+    # Each generated game comes from the last line in the games file that
+    # names it
+    games = {}
     for line in f_games:
-        provision_game(line)
+        game = parse_game(line)
+        if game:
+            games[game[1] + "-v" + game[2]] = game
+    f_games.close()
+    f_factory_secrets.close()
+
+    # Only provision the games whose key changed since the last run
+    old = read_manifest(manifest_path)
+    manifest = {}
+    jobs = []
+    for f_out_name, game in games.items():
+        try:
+            key = game_key(game, args.compress)
+        except Exception as e:
+            print("Error, could not open game: %s" % (e))
+            exit(1)
+        entry = old.get(f_out_name)
+        if (not args.force and entry and entry["key"] == key and
+                os.path.isfile(os.path.join(gen_path, f_out_name))):
+            manifest[f_out_name] = entry
+        else:
+            manifest[f_out_name] = {"source": game[0], "key": key}
+            jobs.append((game, args.compress))
+
+    # Provision the games that changed, in parallel
+    changed = []
+    with multiprocessing.Pool(args.jobs) as pool:
+        for game, f_out_name, sha256, error in pool.imap_unordered(
+                provision_job, jobs):
+            if error:
+                print(error)
+                exit(1)
+            manifest[f_out_name]["sha256"] = sha256
+            changed.append(f_out_name)
+            print("    %s -> %s" % (game[0],
+                                    os.path.join(gen_path, f_out_name)))
+
+    # Delete the games generated before that are no longer in the games file
+    removed = [n for n in old if n not in manifest]
+    for f_out_name in removed:
+        try:
+            os.remove(os.path.join(gen_path, f_out_name))
+        except OSError:
+            pass
+        print("    removed %s" % (os.path.join(gen_path, f_out_name)))
+
+    write_manifest(manifest_path, manifest, changed, removed)
 
-    print("Done Provision Games")
+    print("Done Provision Games (%d changed, %d unchanged, %d removed)"
+          % (len(changed), len(manifest) - len(changed), len(removed)))
 
     exit(0)
 